@@ -0,0 +1,159 @@
+#include "bitset.h"
+#include "vendor/Catch/catch.hpp"
+
+namespace
+{
+TEST_CASE("bitset", "[bitset]")
+{
+	SECTION("Empty")
+	{
+		rde::bitset<100> b;
+		CHECK(100 == b.size());
+		CHECK(b.none());
+		CHECK(0 == b.count());
+		CHECK(100 == b.find_first());
+	}
+	SECTION("SetReset")
+	{
+		rde::bitset<100> b;
+		b.set(0);
+		b.set(63);
+		b.set(64);
+		b.set(99);
+		CHECK(4 == b.count());
+		CHECK(b.test(63));
+		CHECK(b[64]);
+		CHECK(!b.test(62));
+		b.reset(63);
+		CHECK(!b.test(63));
+		b.flip(1);
+		CHECK(b.test(1));
+		b.set(2, true);
+		b.set(2, false);
+		CHECK(!b.test(2));
+		b.set();
+		CHECK(b.all());
+		CHECK(100 == b.count());
+		b.flip();
+		CHECK(b.none());
+	}
+	SECTION("FindNext")
+	{
+		rde::bitset<200> b;
+		b.set(3);
+		b.set(64);
+		b.set(130);
+		b.set(199);
+		CHECK(3 == b.find_first());
+		CHECK(64 == b.find_next(3));
+		CHECK(130 == b.find_next(64));
+		CHECK(199 == b.find_next(130));
+		CHECK(200 == b.find_next(199));
+		size_t sum(0), n(0);
+		for (size_t i : b.set_bits())
+		{
+			sum += i;
+			++n;
+		}
+		CHECK(4 == n);
+		CHECK(3 + 64 + 130 + 199 == sum);
+	}
+	SECTION("BulkOps")
+	{
+		rde::bitset<1000> a, b;
+		for (size_t i = 0; i < 1000; i += 2)
+			a.set(i);
+		for (size_t i = 0; i < 1000; i += 3)
+			b.set(i);
+		rde::bitset<1000> c(a);
+		c &= b;
+		CHECK(167 == c.count());	// multiples of 6
+		c = a;
+		c |= b;
+		CHECK(500 + 334 - 167 == c.count());
+		c = a;
+		c ^= b;
+		CHECK(500 + 334 - 2 * 167 == c.count());
+		c = a;
+		c.and_not(b);
+		CHECK(500 - 167 == c.count());
+		CHECK(c.test(2));
+		CHECK(!c.test(6));
+		CHECK(c != a);
+	}
+}
+
+TEST_CASE("dynamic_bitset", "[bitset]")
+{
+	SECTION("Resize")
+	{
+		rde::dynamic_bitset<> b;
+		CHECK(b.empty());
+		b.resize(70);
+		CHECK(70 == b.size());
+		CHECK(b.none());
+		b.resize(130, true);
+		CHECK(60 == b.count());
+		CHECK(!b.test(69));
+		CHECK(b.test(70));
+		CHECK(b.test(129));
+		b.resize(100);
+		CHECK(30 == b.count());
+		b.resize(200);
+		CHECK(30 == b.count());
+		b.set();
+		CHECK(b.all());
+		CHECK(200 == b.count());
+		b.clear();
+		CHECK(b.empty());
+	}
+	SECTION("PushBack")
+	{
+		rde::dynamic_bitset<> b;
+		for (int i = 0; i < 150; ++i)
+			b.push_back(i % 5 == 0);
+		CHECK(150 == b.size());
+		CHECK(30 == b.count());
+		CHECK(0 == b.find_first());
+		CHECK(5 == b.find_next(0));
+		CHECK(145 == b.find_next(140));
+		CHECK(150 == b.find_next(145));
+	}
+	SECTION("BulkOps")
+	{
+		// Big enough to go through the AVX2 path (if available), odd tail.
+		const size_t n = 64 * 37 + 5;
+		rde::dynamic_bitset<> a(n), b(n);
+		for (size_t i = 0; i < n; i += 2)
+			a.set(i);
+		for (size_t i = 0; i < n; i += 3)
+			b.set(i);
+		const size_t numA = a.count(), numB = b.count();
+		size_t numAB(0);
+		for (size_t i = 0; i < n; i += 6)
+			++numAB;
+		rde::dynamic_bitset<> c(a);
+		c &= b;
+		CHECK(numAB == c.count());
+		c = a;
+		c |= b;
+		CHECK(numA + numB - numAB == c.count());
+		c = a;
+		c ^= b;
+		CHECK(numA + numB - 2 * numAB == c.count());
+		c = a;
+		c.and_not(b);
+		CHECK(numA - numAB == c.count());
+		size_t iterated(0);
+		for (size_t i : c.set_bits())
+		{
+			CHECK((i % 2 == 0 && i % 3 != 0));
+			++iterated;
+		}
+		CHECK(c.count() == iterated);
+		c.flip();
+		CHECK(n - (numA - numAB) == c.count());
+	}
+}
+
+}
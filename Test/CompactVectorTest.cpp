@@ -0,0 +1,94 @@
+#include "compact_vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::compact_vector<int>		tTestVector;
+typedef rde::compact_vector<std::string, rde::allocator,
+	rde::compact_vector_header_storage<std::string, rde::allocator> >	tStringVector;
+
+template<class TVector, typename T>
+void TestBasics(const T* values)
+{
+	TVector v;
+	CHECK(v.empty());
+	CHECK(0 == v.capacity());
+	for (int i = 0; i < 6; ++i)
+		v.push_back(values[i]);
+	CHECK(6 == v.size());
+	CHECK(v.capacity() >= 6);
+	for (int i = 0; i < 6; ++i)
+		CHECK(values[i] == v[i]);
+
+	TVector v2(v);
+	v.erase(v.begin());
+	CHECK(5 == v.size());
+	CHECK(values[1] == v.front());
+	v.insert(v.begin(), values[0]);
+	CHECK(values[0] == v.front());
+	CHECK(values[1] == v[1]);
+	v.erase_unordered(v.begin());
+	CHECK(values[5] == v.front());
+	v.pop_back();
+	CHECK(values[3] == v.back());
+	CHECK(v.find(values[2]) != v.end());
+
+	CHECK(6 == v2.size());
+	CHECK(values[5] == v2.back());
+	TVector v3(std::move(v2));
+	CHECK(v2.empty());
+	CHECK(6 == v3.size());
+	v3.resize(2);
+	v3.shrink_to_fit();
+	CHECK(2 == v3.capacity());
+	CHECK(values[1] == v3.back());
+	v = v3;
+	CHECK(2 == v.size());
+	v.clear();
+	CHECK(v.empty());
+	v.resize(3);
+	CHECK(T() == v[2]);
+}
+
+TEST_CASE("compact_vector", "[vector]")
+{
+	SECTION("Sizeof")
+	{
+		CHECK(sizeof(void*) * 2 >= sizeof(tTestVector));
+		CHECK(sizeof(void*) == sizeof(tStringVector));
+	}
+	SECTION("Basics")
+	{
+		const int ints[] = { 1, 2, 3, 4, 5, 6 };
+		TestBasics<tTestVector>(ints);
+		const std::string strings[] = { "a", "b", "c", "d", "e", "f" };
+		TestBasics<tStringVector>(strings);
+		TestBasics<rde::compact_vector<std::string> >(strings);
+	}
+	SECTION("Grow")
+	{
+		tStringVector v;
+		for (int i = 0; i < 1000; ++i)
+			v.emplace_back(std::to_string(i));
+		CHECK(1000 == v.size());
+		int numOk(0);
+		for (int i = 0; i < 1000; ++i)
+			numOk += (std::to_string(i) == v[i]);
+		CHECK(1000 == numOk);
+	}
+	SECTION("CopyEmpty")
+	{
+		tTestVector v;
+		tTestVector v2(v);
+		CHECK(v2.empty());
+		v2.push_back(1);
+		v2 = v;
+		CHECK(v2.empty());
+		rde::compact_vector<int, rde::allocator, rde::compact_vector_header_storage<int, rde::allocator> > h;
+		rde::compact_vector<int, rde::allocator, rde::compact_vector_header_storage<int, rde::allocator> > h2(h);
+		CHECK(h2.empty());
+		CHECK(0 == h2.capacity());
+	}
+}
+} // namespace
@@ -0,0 +1,172 @@
+#include <string>
+#include <thread>
+#include "cow_hash_map.h"
+#include "vendor/Catch/catch.hpp"
+
+namespace
+{
+struct hasher
+{
+	rde::hash_value_t operator()(const std::string& s) const
+	{
+		size_t len = s.length();
+		rde::hash_value_t hash(0);
+		for (size_t i = 0; i < len; ++i)
+		{
+			hash *= 31;
+			hash += s[i];
+		}
+		return hash;
+	}
+};
+
+// Every block remembers allocator that made it, deallocate checks it's the same one.
+struct tagged_allocator
+{
+	explicit tagged_allocator(int tag_ = 0, int* numMismatches_ = 0): tag(tag_), numMismatches(numMismatches_) {}
+	void* allocate(size_t bytes, int /*flags*/ = 0)
+	{
+		int* p = static_cast<int*>(rde::allocator().allocate(bytes + sizeof(double)));
+		*p = tag;
+		return reinterpret_cast<char*>(p) + sizeof(double);
+	}
+	void deallocate(void* ptr, size_t bytes)
+	{
+		int* p = reinterpret_cast<int*>(static_cast<char*>(ptr) - sizeof(double));
+		if (*p != tag && numMismatches)
+			++*numMismatches;
+		rde::allocator().deallocate(p, bytes + sizeof(double));
+	}
+	const char* get_name() const	{ return "TAGGED"; }
+
+	int		tag;
+	int*	numMismatches;
+};
+
+typedef rde::cow_hash_map<int, int, rde::hash<int>, rde::equal_to<int>, rde::allocator, 16>	tMap;
+typedef rde::cow_hash_map<std::string, std::string, hasher>									tStringMap;
+
+TEST_CASE("cow_hash_map", "[map]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tMap m;
+		CHECK(m.empty());
+		CHECK(0 == m.size());
+		CHECK(m.begin() == m.end());
+		CHECK(m.find(1) == m.end());
+		CHECK(0 == m.erase(1));
+		CHECK(0 == m.find_for_write(1));
+	}
+	SECTION("InsertFindErase")
+	{
+		tMap m;
+		for (int i = 0; i < 100; ++i)
+			CHECK(m.insert(rde::make_pair(i, i * 3)).second);
+		CHECK(!m.insert(rde::make_pair(5, 0)).second);
+		CHECK(100 == m.size());
+		int numFound(0);
+		for (int i = 0; i < 100; ++i)
+		{
+			tMap::const_iterator it = m.find(i);
+			if (it != m.end() && it->second == i * 3)
+				++numFound;
+		}
+		CHECK(100 == numFound);
+		CHECK(1 == m.erase(50));
+		CHECK(m.find(50) == m.end());
+		CHECK(99 == m.size());
+		int numIterated(0);
+		for (tMap::const_iterator it = m.begin(); it != m.end(); ++it)
+			++numIterated;
+		CHECK(99 == numIterated);
+		m[7] = 8;
+		CHECK(8 == m.find(7)->second);
+	}
+	SECTION("SnapshotIsolated")
+	{
+		tMap m;
+		for (int i = 0; i < 100; ++i)
+			m.insert(rde::make_pair(i, i));
+		tMap s = m.snapshot();
+		CHECK(m.bucket_count() / tMap::kPageSize == m.shared_page_count());
+
+		*m.find_for_write(3) = 33;
+		m.erase(4);
+		m.insert(rde::make_pair(1000, 1000));
+		CHECK(33 == m.find(3)->second);
+		CHECK(3 == s.find(3)->second);
+		CHECK(m.find(4) == m.end());
+		CHECK(s.find(4) != s.end());
+		CHECK(s.find(1000) == s.end());
+		CHECK(100 == s.size());
+		CHECK(100 == m.size());
+		// Only touched pages got copied.
+		CHECK(m.shared_page_count() > 0);
+		CHECK(m.shared_page_count() < m.bucket_count() / tMap::kPageSize);
+	}
+	SECTION("SnapshotSurvivesGrowAndClear")
+	{
+		tStringMap m;
+		m.insert(rde::make_pair(std::string("a"), std::string("A")));
+		m.insert(rde::make_pair(std::string("b"), std::string("B")));
+		tStringMap s(m);
+		for (int i = 0; i < 1000; ++i)
+			m[std::to_string(i)] = std::to_string(i);
+		CHECK(1002 == m.size());
+		CHECK(2 == s.size());
+		CHECK("A" == s.find("a")->second);
+		CHECK(s.find("5") == s.end());
+		m.clear();
+		CHECK(m.empty());
+		CHECK("B" == s.find("b")->second);
+		s = m;
+		CHECK(s.empty());
+	}
+	SECTION("AssignmentCopiesAllocator")
+	{
+		typedef rde::cow_hash_map<int, int, rde::hash<int>, rde::equal_to<int>, tagged_allocator, 16> tTaggedMap;
+		int numMismatches(0);
+		{
+			tTaggedMap a((tagged_allocator(1, &numMismatches)));
+			for (int i = 0; i < 100; ++i)
+				a.insert(rde::make_pair(i, i));
+			tTaggedMap b((tagged_allocator(2, &numMismatches)));
+			b.insert(rde::make_pair(1, 1));
+			b = a;
+			CHECK(1 == b.get_allocator().tag);
+			a.clear();
+			// Forces b to copy (and later free) pages that came from a.
+			b.insert(rde::make_pair(1000, 1000));
+			CHECK(101 == b.size());
+		}
+		CHECK(0 == numMismatches);
+	}
+	SECTION("SnapshotOnOtherThread")
+	{
+		tStringMap m;
+		for (int i = 0; i < 1000; ++i)
+			m[std::to_string(i)] = std::to_string(i);
+		int numFound(0);
+		{
+			tStringMap s(m);
+			std::thread reader([&]()
+			{
+				for (int i = 0; i < 1000; ++i)
+				{
+					tStringMap::const_iterator it = s.find(std::to_string(i));
+					if (it != s.end() && it->second == std::to_string(i))
+						++numFound;
+				}
+			});
+			for (int i = 0; i < 1000; i += 2)
+				m.erase(std::to_string(i));
+			for (int i = 1000; i < 2000; ++i)
+				m[std::to_string(i)] = "x";
+			reader.join();
+		}
+		CHECK(1000 == numFound);
+		CHECK(1500 == m.size());
+	}
+}
+} // namespace
@@ -0,0 +1,133 @@
+#include "deque.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::deque<int>							tTestDeque;
+// Tiny blocks, to exercise block/map management.
+typedef rde::deque<std::string, rde::allocator, 4>	tStringDeque;
+
+TEST_CASE("deque", "[deque]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tTestDeque d;
+		CHECK(d.empty());
+		CHECK(0 == d.size());
+		CHECK(d.begin() == d.end());
+	}
+	SECTION("PushBothEnds")
+	{
+		tTestDeque d;
+		for (int i = 0; i < 10000; ++i)
+		{
+			d.push_back(i);
+			d.push_front(-i - 1);
+		}
+		CHECK(20000 == d.size());
+		CHECK(-10000 == d.front());
+		CHECK(9999 == d.back());
+		int numOk(0);
+		for (int i = 0; i < 20000; ++i)
+			numOk += (d[i] == i - 10000);
+		CHECK(20000 == numOk);
+	}
+	SECTION("StableAddresses")
+	{
+		tStringDeque d;
+		d.push_back("first");
+		const std::string* first = &d.front();
+		for (int i = 0; i < 1000; ++i)
+		{
+			d.push_back(std::to_string(i));
+			d.push_front(std::to_string(-i));
+		}
+		CHECK(first == &d[1000]);
+		CHECK("first" == *first);
+	}
+	SECTION("Queue")
+	{
+		tStringDeque d;
+		int next(0);
+		int expected(0);
+		bool ok(true);
+		for (int round = 0; round < 100; ++round)
+		{
+			for (int i = 0; i < 7; ++i)
+				d.emplace_back(std::to_string(next++));
+			for (int i = 0; i < 5; ++i)
+			{
+				ok &= (std::to_string(expected++) == d.front());
+				d.pop_front();
+			}
+		}
+		CHECK(ok);
+		CHECK(200 == d.size());
+		while (!d.empty())
+		{
+			ok &= (std::to_string(expected++) == d.front());
+			d.pop_front();
+		}
+		CHECK(ok);
+		CHECK(next == expected);
+		d.push_front("x");
+		CHECK(1 == d.size());
+		CHECK("x" == d.back());
+	}
+	SECTION("PopBack")
+	{
+		tStringDeque d;
+		for (int i = 0; i < 10; ++i)
+			d.push_front(std::to_string(i));
+		for (int i = 0; i < 9; ++i)
+			d.pop_back();
+		CHECK(1 == d.size());
+		CHECK("9" == d.front());
+		d.pop_back();
+		CHECK(d.empty());
+	}
+	SECTION("Iterators")
+	{
+		tTestDeque d;
+		for (int i = 0; i < 100; ++i)
+			d.push_front(i);
+		int sum(0);
+		for (tTestDeque::const_iterator it = d.begin(); it != d.end(); ++it)
+			sum += *it;
+		CHECK(4950 == sum);
+		tTestDeque::iterator it = d.begin() + 10;
+		CHECK(89 == *it);
+		CHECK(10 == it - d.begin());
+		CHECK(100 == d.end() - d.begin());
+		*it = 5;
+		CHECK(5 == d[10]);
+		CHECK(d.begin() < it);
+		CHECK(it > d.begin());
+		CHECK(it <= it);
+		CHECK(it >= it);
+		CHECK(d.end() >= it);
+		CHECK(!(d.end() <= it));
+	}
+	SECTION("CopyMoveClear")
+	{
+		tStringDeque d;
+		for (int i = 0; i < 50; ++i)
+			d.push_back(std::to_string(i));
+		tStringDeque d2(d);
+		CHECK(50 == d2.size());
+		CHECK("49" == d2.back());
+		tStringDeque d3(std::move(d));
+		CHECK(d.empty());
+		CHECK(50 == d3.size());
+		d2.clear();
+		CHECK(d2.empty());
+		d2.push_back("a");
+		d2 = d3;
+		CHECK(50 == d2.size());
+		CHECK("0" == d2.front());
+		d.push_back("b");
+		CHECK("b" == d.front());
+	}
+}
+} // namespace
@@ -0,0 +1,144 @@
+#include "epoch.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+int s_numAlive(0);
+struct Tracked
+{
+	explicit Tracked(int v_ = 0): v(v_)	{ ++s_numAlive; }
+	~Tracked()							{ --s_numAlive; }
+	int	v;
+};
+
+Tracked* NewTracked(int v)
+{
+	return new (rde::allocator().allocate(sizeof(Tracked))) Tracked(v);
+}
+
+TEST_CASE("epoch", "[epoch]")
+{
+	s_numAlive = 0;
+	SECTION("FreedWhenNoReaders")
+	{
+		rde::epoch_domain<> domain;
+		rde::epoch_domain<>::participant p(domain);
+		p.retire(NewTracked(1));
+		CHECK(1 == p.pending());
+		CHECK(1 == s_numAlive);
+		CHECK(1 == p.collect());
+		CHECK(0 == p.pending());
+		CHECK(0 == s_numAlive);
+	}
+	SECTION("KeptWhileReaderInside")
+	{
+		rde::epoch_domain<> domain;
+		rde::epoch_domain<>::participant writer(domain);
+		rde::epoch_domain<>::participant reader(domain);
+		{
+			rde::epoch_domain<>::guard g(reader);
+			CHECK(reader.in_critical_section());
+			writer.retire(NewTracked(1));
+			CHECK(0 == writer.collect());
+			CHECK(1 == s_numAlive);
+			// Nested sections don't move reader's epoch.
+			reader.enter();
+			reader.exit();
+			CHECK(0 == writer.collect());
+		}
+		CHECK(!reader.in_critical_section());
+		// Retired while reader was inside, can go as soon as reader is out.
+		CHECK(1 == writer.collect());
+		CHECK(0 == s_numAlive);
+
+		// Reader that entered after epoch moved past retirement doesn't block it.
+		rde::epoch_domain<>::participant oldReader(domain);
+		oldReader.enter();
+		writer.retire(NewTracked(2));
+		CHECK(0 == writer.collect());
+		rde::epoch_domain<>::guard g(reader);
+		oldReader.exit();
+		CHECK(1 == writer.collect());
+		CHECK(0 == s_numAlive);
+	}
+	SECTION("BatchedCollect")
+	{
+		rde::epoch_domain<> domain;
+		rde::epoch_domain<>::participant p(domain);
+		const std::uint64_t epoch = domain.epoch();
+		for (size_t i = 0; i + 1 < rde::epoch_domain<>::kCollectThreshold; ++i)
+			p.retire(rde::allocator().allocate(16), 16);
+		// No collection yet, epoch didn't move.
+		CHECK(epoch == domain.epoch());
+		CHECK(rde::epoch_domain<>::kCollectThreshold - 1 == p.pending());
+		p.retire(rde::allocator().allocate(16), 16);
+		CHECK(epoch + 1 == domain.epoch());
+		CHECK(0 == p.pending());
+	}
+	SECTION("Orphans")
+	{
+		rde::epoch_domain<> domain;
+		rde::epoch_domain<>::participant reader(domain);
+		reader.enter();
+		{
+			rde::epoch_domain<>::participant writer(domain);
+			writer.retire(NewTracked(1));
+		}
+		CHECK(1 == domain.orphaned_count());
+		CHECK(1 == s_numAlive);
+		reader.exit();
+		// Anyone's collect picks them up.
+		CHECK(1 == reader.collect());
+		CHECK(0 == domain.orphaned_count());
+		CHECK(0 == s_numAlive);
+	}
+	SECTION("Threads")
+	{
+		// Readers keep dereferencing shared pointer while writer keeps replacing
+		// and retiring it. Freed memory would be caught by value check (and ASan).
+		rde::epoch_domain<> domain;
+		std::atomic<Tracked*> shared(NewTracked(0));
+		std::atomic<bool> done(false);
+		std::atomic<int> numErrors(0);
+		const int kNumReaders = 3;
+		std::thread readers[kNumReaders];
+		for (int t = 0; t < kNumReaders; ++t)
+		{
+			readers[t] = std::thread([&]()
+			{
+				rde::epoch_domain<>::participant p(domain);
+				while (!done.load(std::memory_order_relaxed))
+				{
+					rde::epoch_domain<>::guard g(p);
+					const Tracked* obj = shared.load(std::memory_order_acquire);
+					if (obj->v < 0)
+						++numErrors;
+					std::this_thread::yield();
+				}
+			});
+		}
+		{
+			rde::epoch_domain<>::participant p(domain);
+			for (int i = 1; i < 2000; ++i)
+			{
+				Tracked* old = shared.exchange(NewTracked(i), std::memory_order_acq_rel);
+				p.retire(old);
+				if ((i & 63) == 0)
+					std::this_thread::yield();
+			}
+			done = true;
+			for (int t = 0; t < kNumReaders; ++t)
+				readers[t].join();
+			p.collect();
+			CHECK(0 == p.pending());
+		}
+		CHECK(0 == numErrors.load());
+		CHECK(0 == domain.orphaned_count());
+		CHECK(1 == s_numAlive);
+		Tracked* last = shared.load();
+		last->~Tracked();
+		rde::allocator().deallocate(last, sizeof(Tracked));
+	}
+}
+}
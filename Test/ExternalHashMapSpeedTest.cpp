@@ -0,0 +1,93 @@
+#include "external_hash_map.h"
+
+#if !RDESTL_STANDALONE
+
+#include "core/Console.h"
+#include "core/Timer.h"
+
+namespace
+{
+// Keys are sorted by partition in batches, like offline tools should do it.
+const int kNumElements = 4 * 1024 * 1024;
+const int kBatchSize = 64 * 1024;
+
+struct record_counter
+{
+	record_counter(): count(0), sum(0) {}
+	void operator()(const int&, const int& value)
+	{
+		++count;
+		sum += value;
+	}
+	int			count;
+	long long	sum;
+};
+
+template<class TMap>
+void ReportIO(const char* name, const TMap& m, long ms)
+{
+	rde::Console::Printf("%s: %dms, %d partition reads, %d partition writes, %dKB resident\n",
+		name, ms, (int)m.read_count(), (int)m.write_count(), (int)(m.resident_bytes() >> 10));
+}
+
+void RunExternalHashMapTest(size_t numPartitions, size_t memoryBudget)
+{
+	typedef rde::external_hash_map<int, int> tMap;
+	tMap m("rdestl_ehm_speed", numPartitions, memoryBudget);
+	rde::Console::Printf("external_hash_map, %d partitions, %dKB budget\n",
+		(int)numPartitions, (int)(memoryBudget >> 10));
+
+	rde::Timer timer;
+	timer.Start();
+	for (int i = 0; i < kNumElements; ++i)
+		m.insert(i * 7919, i);
+	timer.Stop();
+	ReportIO("Sequential inserts", m, timer.GetTimeInMs());
+
+	// Group lookups by partition (counting sort of every batch, done up front,
+	// so it's not timed), every cold partition is then loaded at most once per batch.
+	rde::vector<int> keys;
+	keys.resize(kNumElements);
+	rde::vector<int> offsets;
+	for (int b = 0; b < kNumElements; b += kBatchSize)
+	{
+		const int batchEnd = (b + kBatchSize < kNumElements ? b + kBatchSize : kNumElements);
+		offsets.clear();
+		offsets.resize(numPartitions + 1, 0);
+		for (int i = b; i < batchEnd; ++i)
+			++offsets[m.partition_of(i * 7919) + 1];
+		for (size_t p = 0; p < numPartitions; ++p)
+			offsets[p + 1] += offsets[p];
+		for (int i = b; i < batchEnd; ++i)
+			keys[b + offsets[m.partition_of(i * 7919)]++] = i * 7919;
+	}
+	int numFound(0);
+	timer.Start();
+	for (rde::vector<int>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+	{
+		int v(0);
+		if (m.find(*it, v))
+			++numFound;
+	}
+	timer.Stop();
+	ReportIO("Batched lookups", m, timer.GetTimeInMs());
+
+	record_counter counter;
+	timer.Start();
+	m.for_each(counter);
+	timer.Stop();
+	ReportIO("Streaming scan", m, timer.GetTimeInMs());
+
+	if (numFound != kNumElements || counter.count != kNumElements || m.failed())
+		rde::Console::Printf("ERROR: external_hash_map test failed\n");
+}
+} // namespace
+
+void ExternalHashMap_SpeedTest()
+{
+	// Everything resident vs. ~1/8th resident.
+	RunExternalHashMapTest(64, 256 * 1024 * 1024);
+	RunExternalHashMapTest(64, 16 * 1024 * 1024);
+}
+
+#endif // #if !RDESTL_STANDALONE
@@ -0,0 +1,167 @@
+#include "external_hash_map.h"
+#include "vendor/Catch/catch.hpp"
+#include <cstdio>
+
+namespace
+{
+typedef rde::external_hash_map<int, int> tMap;
+
+struct Point
+{
+	int	x, y;
+};
+
+struct sum_counter
+{
+	sum_counter(): count(0), sum(0) {}
+	void operator()(const int& key, const int& value)
+	{
+		++count;
+		sum += value - key;
+	}
+	int			count;
+	long long	sum;
+};
+
+TEST_CASE("external_hash_map", "[map]")
+{
+	SECTION("Empty")
+	{
+		tMap m("rdestl_ehm_test", 4, 1024 * 1024);
+		CHECK(m.empty());
+		CHECK(4 == m.partition_count());
+		int v(0);
+		CHECK(!m.find(1, v));
+		CHECK(!m.erase(1));
+		CHECK(!m.failed());
+	}
+	SECTION("InsertFindErase")
+	{
+		tMap m("rdestl_ehm_test", 4, 1024 * 1024);
+		CHECK(m.insert(1, 10));
+		CHECK(m.insert(2, 20));
+		CHECK(!m.insert(1, 11));
+		CHECK(2 == m.size());
+		int v(0);
+		CHECK(m.find(1, v));
+		CHECK(11 == v);
+		CHECK(m.erase(1));
+		CHECK(!m.find(1, v));
+		CHECK(1 == m.size());
+		// Nothing should have been spilled with a budget that big.
+		CHECK(0 == m.write_count());
+	}
+	SECTION("TriviallyCopyableStruct")
+	{
+		rde::external_hash_map<int, Point> m("rdestl_ehm_test", 4, 4 * 1024);
+		for (int i = 0; i < 1000; ++i)
+		{
+			const Point p = { i, -i };
+			m.insert(i, p);
+		}
+		Point out = { 0, 0 };
+		CHECK(m.find(500, out));
+		CHECK(500 == out.x);
+		CHECK(-500 == out.y);
+		CHECK(!m.failed());
+	}
+	SECTION("SpillsToDisk")
+	{
+		// Tiny budget, only one partition can be resident at a time.
+		tMap m("rdestl_ehm_test", 16, 4 * 1024);
+		for (int i = 0; i < 10000; ++i)
+			CHECK(m.insert(i, i * 3));
+		CHECK(10000 == m.size());
+		CHECK(m.write_count() > 0);
+		CHECK(m.resident_partition_count() < m.partition_count());
+
+		int numFound(0);
+		for (int i = 0; i < 10000; ++i)
+		{
+			int v(-1);
+			if (m.find(i, v) && v == i * 3)
+				++numFound;
+		}
+		CHECK(10000 == numFound);
+		CHECK(m.read_count() > 0);
+
+		for (int i = 0; i < 10000; i += 2)
+			CHECK(m.erase(i));
+		CHECK(5000 == m.size());
+		int v(0);
+		CHECK(!m.find(0, v));
+		CHECK(m.find(1, v));
+		CHECK(3 == v);
+		CHECK(!m.failed());
+	}
+	SECTION("ForEachStreamsColdPartitions")
+	{
+		tMap m("rdestl_ehm_test", 8, 4 * 1024);
+		for (int i = 0; i < 5000; ++i)
+			m.insert(i, i + 7);
+		const size_t residentBefore = m.resident_partition_count();
+		sum_counter counter;
+		m.for_each(counter);
+		CHECK(5000 == counter.count);
+		CHECK(5000 * 7 == counter.sum);
+		CHECK(residentBefore == m.resident_partition_count());
+	}
+	SECTION("WriteFailureKeepsData")
+	{
+		// Directory doesn't exist, nothing can be spilled.
+		tMap m("rdestl_no_such_dir/ehm_test", 16, 4 * 1024);
+		for (int i = 0; i < 2000; ++i)
+			CHECK(m.insert(i, i * 3));
+		CHECK(m.failed());
+		CHECK(0 == m.write_count());
+		CHECK(m.partition_count() == m.resident_partition_count());
+		int numFound(0);
+		for (int i = 0; i < 2000; ++i)
+		{
+			int v(-1);
+			if (m.find(i, v) && v == i * 3)
+				++numFound;
+		}
+		CHECK(2000 == numFound);
+		CHECK(!m.flush());
+	}
+	SECTION("ReadFailure")
+	{
+		tMap m("rdestl_ehm_test", 4, 4 * 1024);
+		for (int i = 0; i < 4000; ++i)
+			m.insert(i, i);
+		REQUIRE(m.resident_partition_count() < m.partition_count());
+		char path[64];
+		for (int i = 0; i < 4; ++i)
+		{
+			std::snprintf(path, sizeof(path), "rdestl_ehm_test.%d", i);
+			std::remove(path);
+		}
+		const size_t residentBytes = m.resident_bytes();
+		int numFound(0);
+		for (int i = 0; i < 4000; ++i)
+		{
+			int v(-1);
+			numFound += m.find(i, v);
+		}
+		CHECK(m.failed());
+		CHECK(numFound > 0);
+		CHECK(numFound < 4000);
+		// Partitions that failed to load don't count as resident.
+		CHECK(m.resident_bytes() <= residentBytes);
+		CHECK(1 == m.resident_partition_count());
+	}
+	SECTION("Flush")
+	{
+		tMap m("rdestl_ehm_test", 2, 1024 * 1024);
+		for (int i = 0; i < 100; ++i)
+			m.insert(i, i);
+		CHECK(m.flush());
+		CHECK(m.write_count() > 0);
+		const size_t numWrites = m.write_count();
+		// Clean partitions are not written again.
+		CHECK(m.flush());
+		CHECK(numWrites == m.write_count());
+	}
+}
+} // namespace
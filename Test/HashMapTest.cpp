@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>
 
 namespace
 {
@@ -30,6 +31,23 @@ struct poor_hasher
 	}
 };
 
+// rehash_executor::run, spreads tasks over user_data (size_t*) threads.
+void RunOnThreads(void* user_data, rde::rehash_executor::task_func task, void* task_context, size_t num_tasks)
+{
+	const size_t numThreads = *static_cast<size_t*>(user_data);
+	std::thread threads[8];
+	for (size_t t = 0; t < numThreads; ++t)
+	{
+		threads[t] = std::thread([=]()
+		{
+			for (size_t i = t; i < num_tasks; i += numThreads)
+				task(task_context, i);
+		});
+	}
+	for (size_t t = 0; t < numThreads; ++t)
+		threads[t].join();
+}
+
 #define tMap				rde::hash_map<std::string, int, hasher>
 #define tPoorlyHashedMap	rde::hash_map<std::string, int, poor_hasher>
 
@@ -120,6 +138,108 @@ TEST_CASE("hash_map: GoogleIntHashFixed")
 	CHECK(m.empty());
 }
 
+TEST_CASE("hash_map: GenerationalClear")
+{
+	typedef rde::hash_map<int, int, rde::hash<int>, rde::equal_to<int>, rde::allocator, true> TestMap;
+	TestMap m;
+	m.clear();
+	CHECK(m.empty());
+	for (int i = 0; i < 100; ++i)
+		m.insert(rde::make_pair(i, i * 2));
+	CHECK(100 == m.size());
+	const TestMap::size_type bucketCount = m.bucket_count();
+	m.erase(50);
+	m.clear();
+	CHECK(m.empty());
+	CHECK(bucketCount == m.bucket_count());
+	CHECK(m.begin() == m.end());
+	CHECK(m.find(1) == m.end());
+	CHECK(0 == m.erase(2));
+
+	// Stale nodes must not come back to life.
+	m.insert(rde::make_pair(3, 33));
+	CHECK(1 == m.size());
+	CHECK(m.find(3) != m.end());
+	CHECK(33 == m.find(3)->second);
+	CHECK(m.find(4) == m.end());
+	int numIterated(0);
+	for (TestMap::iterator it = m.begin(); it != m.end(); ++it)
+		++numIterated;
+	CHECK(1 == numIterated);
+	CHECK(0 == m[7]);
+	CHECK(2 == m.size());
+
+	// Many clear/fill cycles, table should not grow.
+	for (int cycle = 0; cycle < 10; ++cycle)
+	{
+		m.clear();
+		for (int i = 0; i < 100; ++i)
+			m.insert(rde::make_pair(i + cycle, i));
+		CHECK(100 == m.size());
+		CHECK(m.find(cycle + 99) != m.end());
+		CHECK(m.find(cycle + 100) == m.end());
+	}
+	CHECK(bucketCount == m.bucket_count());
+
+	TestMap m2(m);
+	CHECK(100 == m2.size());
+	CHECK(m2.find(9 + 99) != m2.end());
+}
+
+TEST_CASE("hash_map: GenerationalClearPodValues")
+{
+	// Anything trivially destructible, not only types rde knows are POD.
+	struct point
+	{
+		int	x, y;
+	};
+	rde::hash_map<int, const point*, rde::hash<int>, rde::equal_to<int>, rde::allocator, true> pointers;
+	rde::hash_map<int, point, rde::hash<int>, rde::equal_to<int>, rde::allocator, true> points;
+	const point p = { 1, 2 };
+	pointers.insert(rde::make_pair(1, &p));
+	points.insert(rde::make_pair(1, p));
+	CHECK(&p == pointers.find(1)->second);
+	CHECK(2 == points.find(1)->second.y);
+	pointers.clear();
+	points.clear();
+	CHECK(pointers.empty());
+	CHECK(points.empty());
+}
+
+TEST_CASE("hash_map: ParallelRehash")
+{
+	size_t numThreads = 4;
+	rde::rehash_executor executor = { &RunOnThreads, &numThreads, 1000 };
+	rde::hash_map<int, std::string> m;
+	m.set_rehash_executor(&executor);
+	CHECK(&executor == m.get_rehash_executor());
+	const int kNumElements = 200000;
+	for (int i = 0; i < kNumElements; ++i)
+		m.insert(rde::make_pair(i, std::to_string(i)));
+	CHECK(kNumElements == (int)m.size());
+	int numFound(0);
+	for (int i = 0; i < kNumElements; ++i)
+	{
+		rde::hash_map<int, std::string>::iterator it = m.find(i);
+		if (it != m.end() && it->second == std::to_string(i))
+			++numFound;
+	}
+	CHECK(kNumElements == numFound);
+	m.reserve(m.bucket_count() * 4);
+	int numIterated(0);
+	for (rde::hash_map<int, std::string>::iterator it = m.begin(); it != m.end(); ++it)
+		++numIterated;
+	CHECK(kNumElements == numIterated);
+	CHECK(m.find(kNumElements) == m.end());
+
+	// Executor setting goes with the table.
+	rde::hash_map<int, std::string> m2;
+	m2.swap(m);
+	CHECK(&executor == m2.get_rehash_executor());
+	CHECK(0 == m.get_rehash_executor());
+	CHECK(kNumElements == (int)m2.size());
+}
+
 // Reported by Shiran Ben-Israel
 TEST_CASE("hash_map: ShiranIssue")
 {
@@ -0,0 +1,102 @@
+#include "intrusive_mpsc_queue.h"
+#include "vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+struct Message: public rde::intrusive_slist_node
+{
+	explicit Message(int i = 0): data(i) { }
+	int	data;
+};
+
+TEST_CASE("intrusive_mpsc_queue", "[intrusive_mpsc_queue]")
+{
+	rde::intrusive_mpsc_queue<Message> q;
+	CHECK(q.empty());
+	CHECK(0 == q.pop());
+
+	SECTION("Fifo")
+	{
+		Message m[5] = { Message(0), Message(1), Message(2), Message(3), Message(4) };
+		for (int i = 0; i < 5; ++i)
+			q.push(&m[i]);
+		CHECK(!q.empty());
+		CHECK(m[0].in_list());
+		for (int i = 0; i < 5; ++i)
+		{
+			Message* p = q.pop();
+			REQUIRE(p == &m[i]);
+			CHECK(!p->in_list());
+		}
+		CHECK(0 == q.pop());
+		CHECK(q.empty());
+	}
+	SECTION("ReuseNodes")
+	{
+		Message a(1), b(2);
+		for (int i = 0; i < 100; ++i)
+		{
+			q.push(&a);
+			q.push(&b);
+			CHECK(&a == q.pop());
+			q.push(&a);
+			CHECK(&b == q.pop());
+			CHECK(&a == q.pop());
+			CHECK(q.empty());
+		}
+	}
+	SECTION("PopN")
+	{
+		Message m[4];
+		for (int i = 0; i < 4; ++i)
+			q.push(&m[i]);
+		Message* out[8];
+		CHECK(4 == q.pop_n(out, 8));
+		CHECK(&m[3] == out[3]);
+		CHECK(0 == q.pop_n(out, 8));
+	}
+	SECTION("MultipleProducers")
+	{
+		const int kNumProducers = 4;
+		const int kNumPerProducer = 2000;
+		rde::vector<Message> messages;
+		messages.resize(kNumProducers * kNumPerProducer);
+		std::thread producers[kNumProducers];
+		for (int t = 0; t < kNumProducers; ++t)
+		{
+			producers[t] = std::thread([&q, &messages, t]()
+			{
+				for (int i = 0; i < kNumPerProducer; ++i)
+				{
+					Message& m = messages[t * kNumPerProducer + i];
+					m.data = i;
+					q.push(&m);
+				}
+			});
+		}
+		// Every producer's messages have to come in order.
+		int lastSeen[kNumProducers] = { -1, -1, -1, -1 };
+		int numPopped(0);
+		bool ordered = true;
+		while (numPopped < kNumProducers * kNumPerProducer)
+		{
+			Message* m = q.pop();
+			if (m == 0)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			const int producer = int(m - messages.begin()) / kNumPerProducer;
+			ordered &= (m->data == lastSeen[producer] + 1);
+			lastSeen[producer] = m->data;
+			++numPopped;
+		}
+		for (int t = 0; t < kNumProducers; ++t)
+			producers[t].join();
+		CHECK(ordered);
+		CHECK(q.empty());
+	}
+}
+}
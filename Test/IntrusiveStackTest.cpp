@@ -0,0 +1,96 @@
+#include "intrusive_stack.h"
+#include "vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+struct MyNode: public rde::intrusive_slist_node
+{
+	explicit MyNode(int i = 0): data(i) { }
+	int	data;
+};
+
+TEST_CASE("intrusive_stack", "[intrusive_stack]")
+{
+	rde::intrusive_stack<MyNode> s;
+	CHECK(s.empty_approx());
+	CHECK(0 == s.pop());
+
+	SECTION("Lifo")
+	{
+		MyNode n[3] = { MyNode(0), MyNode(1), MyNode(2) };
+		for (int i = 0; i < 3; ++i)
+			s.push(&n[i]);
+		CHECK(!s.empty_approx());
+		CHECK(&n[2] == s.pop());
+		CHECK(!n[2].in_list());
+		CHECK(&n[1] == s.pop());
+		s.push(&n[2]);
+		CHECK(&n[2] == s.pop());
+		CHECK(&n[0] == s.pop());
+		CHECK(0 == s.pop());
+		CHECK(s.empty_approx());
+	}
+	SECTION("PopAllPushChain")
+	{
+		MyNode n[3] = { MyNode(0), MyNode(1), MyNode(2) };
+		for (int i = 0; i < 3; ++i)
+			s.push(&n[i]);
+		MyNode* all = s.pop_all();
+		CHECK(s.empty_approx());
+		int count(0);
+		for (rde::intrusive_slist_node* it = all; it; it = it->next)
+			++count;
+		CHECK(3 == count);
+		CHECK(&n[2] == all);
+
+		// n[2] -> n[1] -> n[0] are still linked, put them back in one go.
+		s.push_chain(&n[2], &n[0]);
+		CHECK(&n[2] == s.pop());
+		CHECK(&n[1] == s.pop());
+		CHECK(&n[0] == s.pop());
+		CHECK(0 == s.pop());
+	}
+	SECTION("Threads")
+	{
+		// Free list shared by all threads, nodes constantly recycled (ABA prone).
+		const int kNumThreads = 4;
+		const int kNumNodes = 64;
+		rde::vector<MyNode> nodes;
+		nodes.resize(kNumNodes);
+		for (int i = 0; i < kNumNodes; ++i)
+			s.push(&nodes[i]);
+		std::atomic<int> numErrors(0);
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&s, &numErrors, t]()
+			{
+				for (int i = 0; i < 5000; ++i)
+				{
+					MyNode* n = s.pop();
+					if (n == 0)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+					// We own it now, nobody else should touch it.
+					n->data = t;
+					std::this_thread::yield();
+					if (n->data != t)
+						++numErrors;
+					s.push(n);
+				}
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(0 == numErrors.load());
+		int count(0);
+		while (s.pop())
+			++count;
+		CHECK(kNumNodes == count);
+	}
+}
+}
@@ -0,0 +1,205 @@
+#include "job_system.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+struct counting_allocator
+{
+	static std::atomic<int>	s_numAllocations;
+
+	void* allocate(size_t bytes, int flags = 0)
+	{
+		++s_numAllocations;
+		return rde::allocator().allocate(bytes, flags);
+	}
+	void deallocate(void* ptr, size_t bytes)
+	{
+		rde::allocator().deallocate(ptr, bytes);
+	}
+	const char* get_name() const	{ return "COUNTING"; }
+};
+std::atomic<int> counting_allocator::s_numAllocations(0);
+
+TEST_CASE("job_system", "[job_system]")
+{
+	rde::job_system js(3);
+	CHECK(4 == js.num_workers());
+
+	SECTION("RunWait")
+	{
+		std::atomic<int> sum(0);
+		rde::job_counter counter;
+		for (int i = 0; i < 1000; ++i)
+			js.run(counter, [&sum, i]() { sum += i; });
+		js.wait(counter);
+		CHECK(counter.done());
+		CHECK(999 * 1000 / 2 == sum.load());
+	}
+	SECTION("Nested")
+	{
+		std::atomic<int> numLeaves(0);
+		rde::job_counter counter;
+		for (int i = 0; i < 16; ++i)
+		{
+			js.run(counter, [&js, &numLeaves]()
+			{
+				rde::job_counter inner;
+				for (int j = 0; j < 16; ++j)
+					js.run(inner, [&numLeaves]() { ++numLeaves; });
+				js.wait(inner);
+			});
+		}
+		js.wait(counter);
+		CHECK(256 == numLeaves.load());
+	}
+	SECTION("ParallelFor")
+	{
+		const size_t n = 100000;
+		rde::vector<int> values;
+		values.resize(n);
+		std::atomic<size_t> numCalls(0);
+		js.parallel_for(0, n, [&values, &numCalls](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; ++i)
+				values[i] = int(i) * 2;
+			++numCalls;
+		}, 1000);
+		bool ok(true);
+		for (size_t i = 0; i < n; ++i)
+			ok &= (values[i] == int(i) * 2);
+		CHECK(ok);
+		CHECK(numCalls.load() >= n / 1000);
+		// Automatic grain, empty range.
+		std::atomic<size_t> total(0);
+		js.parallel_for(0, n, [&total](size_t first, size_t last) { total += last - first; });
+		CHECK(n == total.load());
+		js.parallel_for(5, 5, [&total](size_t, size_t) { total = 0; });
+		CHECK(n == total.load());
+	}
+	SECTION("Continuations")
+	{
+		std::atomic<int> stage(0);
+		bool orderOk(true);
+		rde::job_counter first, second;
+		for (int i = 0; i < 8; ++i)
+			js.run(first, [&stage]() { stage.fetch_add(1); });
+		js.run_after(first, &second, [&stage, &orderOk]()
+		{
+			orderOk = (stage.load() == 8);
+			stage = 100;
+		});
+		js.wait(second);
+		CHECK(orderOk);
+		CHECK(100 == stage.load());
+		// Dependency that is already done.
+		rde::job_counter empty, third;
+		js.run_after(empty, &third, [&stage]() { ++stage; });
+		js.wait(third);
+		CHECK(101 == stage.load());
+	}
+	SECTION("ExternalThread")
+	{
+		std::atomic<int> sum(0);
+		std::thread external([&js, &sum]()
+		{
+			rde::job_counter counter;
+			for (int i = 0; i < 100; ++i)
+				js.run(counter, [&sum]() { ++sum; });
+			js.wait(counter);
+		});
+		external.join();
+		CHECK(100 == sum.load());
+	}
+}
+
+TEST_CASE("job_system job reuse", "[job_system]")
+{
+	// Jobs are mostly run (and freed) by thieves, they have to go back to the
+	// thread that allocated them, otherwise it keeps allocating new blocks.
+	rde::basic_job_system<counting_allocator> js(2);
+	std::atomic<int> sum(0);
+	auto runRound = [&js, &sum](rde::job_counter& counter)
+	{
+		for (int i = 0; i < 64; ++i)
+		{
+			js.run(counter, [&sum]()
+			{
+				++sum;
+				std::this_thread::yield();
+			});
+		}
+		js.wait(counter);
+	};
+	SECTION("Worker")
+	{
+		rde::job_counter counter;
+		runRound(counter);
+		const int numAllocations = counting_allocator::s_numAllocations.load();
+		for (int round = 0; round < 200; ++round)
+			runRound(counter);
+		CHECK(numAllocations == counting_allocator::s_numAllocations.load());
+		CHECK(201 * 64 == sum.load());
+	}
+	SECTION("ExternalThread")
+	{
+		int numAllocations(0);
+		std::thread external([&]()
+		{
+			rde::job_counter counter;
+			runRound(counter);
+			numAllocations = counting_allocator::s_numAllocations.load();
+			for (int round = 0; round < 200; ++round)
+				runRound(counter);
+		});
+		external.join();
+		CHECK(numAllocations == counting_allocator::s_numAllocations.load());
+		CHECK(201 * 64 == sum.load());
+	}
+}
+
+TEST_CASE("job_system nested systems", "[job_system]")
+{
+	// Jobs submitted by worker 0 wait in its deque until wait(). External
+	// threads go through smaller injection queue, once it's full jobs just
+	// run inline, so early runs mean calling thread is no longer worker 0.
+	rde::job_system js(0);
+	auto countEarlyRuns = [&js]()
+	{
+		int numRun(0);
+		rde::job_counter counter;
+		for (int i = 0; i < 2000; ++i)
+			js.run(counter, [&numRun]() { ++numRun; });
+		const int numEarly = numRun;
+		js.wait(counter);
+		CHECK(2000 == numRun);
+		return numEarly;
+	};
+	CHECK(0 == countEarlyRuns());
+	{
+		rde::job_system other(0);
+		CHECK(0 == countEarlyRuns());
+		rde::job_counter counter;
+		int sum(0);
+		other.run(counter, [&sum]() { sum = 5; });
+		other.wait(counter);
+		CHECK(5 == sum);
+	}
+	CHECK(0 == countEarlyRuns());
+}
+
+TEST_CASE("job_system single thread", "[job_system]")
+{
+	rde::job_system js(0);
+	int sum(0);
+	rde::job_counter counter;
+	for (int i = 0; i < 10; ++i)
+		js.run(counter, [&sum, i]() { sum += i; });
+	js.wait(counter);
+	CHECK(45 == sum);
+	size_t total(0);
+	js.parallel_for(0, 100, [&total](size_t first, size_t last) { total += last - first; });
+	CHECK(100 == total);
+}
+
+}
@@ -0,0 +1,125 @@
+#include "mpmc_queue.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+#include <thread>
+
+namespace
+{
+TEST_CASE("mpmc_queue", "[mpmc_queue]")
+{
+	SECTION("PushPop")
+	{
+		rde::mpmc_queue<int> q(3);
+		CHECK(4 == q.capacity());
+		for (int i = 0; i < 4; ++i)
+			CHECK(q.try_push(i));
+		CHECK(!q.try_push(4));
+		int v;
+		for (int round = 0; round < 10; ++round)
+		{
+			CHECK(q.try_pop(v));
+			CHECK(round == v);
+			CHECK(q.try_push(round + 4));
+		}
+		CHECK(4 == q.size_approx());
+	}
+	SECTION("Bulk")
+	{
+		rde::mpmc_queue<int> q(8);
+		const int values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		CHECK(8 == q.push_n(values, 10));
+		int out[10];
+		CHECK(8 == q.pop_n(out, 10));
+		CHECK(7 == out[7]);
+		CHECK(q.empty_approx());
+	}
+	SECTION("NonPod")
+	{
+		rde::mpmc_queue<std::string> q(4);
+		CHECK(q.try_emplace("hello"));
+		CHECK(q.try_push(std::string("world")));
+		std::string s;
+		CHECK(q.try_pop(s));
+		CHECK("hello" == s);
+	}
+	SECTION("Threads")
+	{
+		const int kNumThreads = 4;
+		const int kItemsPerThread = 10000;
+		rde::mpmc_queue<int> q(64);
+		std::atomic<long long> sum(0);
+		std::atomic<int> numPopped(0);
+		std::thread threads[kNumThreads * 2];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&q, t]()
+			{
+				for (int i = 0; i < kItemsPerThread; )
+				{
+					if (q.try_push(t * kItemsPerThread + i))
+						++i;
+					else
+						std::this_thread::yield();
+				}
+			});
+			threads[kNumThreads + t] = std::thread([&]()
+			{
+				int v;
+				while (numPopped.load() < kNumThreads * kItemsPerThread)
+				{
+					if (q.try_pop(v))
+					{
+						sum += v;
+						++numPopped;
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for (int t = 0; t < kNumThreads * 2; ++t)
+			threads[t].join();
+		const long long n = kNumThreads * kItemsPerThread;
+		CHECK(n * (n - 1) / 2 == sum.load());
+		CHECK(q.empty_approx());
+	}
+}
+
+TEST_CASE("blocking_mpmc_queue", "[mpmc_queue]")
+{
+	const int kNumItems = 20000;
+	rde::blocking_mpmc_queue<int> q(16);
+	long long sums[2] = { 0, 0 };
+	std::thread consumers[2];
+	for (int t = 0; t < 2; ++t)
+	{
+		consumers[t] = std::thread([&q, &sums, t]()
+		{
+			int v;
+			for (;;)
+			{
+				q.pop(v);
+				if (v < 0)
+					break;
+				sums[t] += v;
+			}
+		});
+	}
+	std::thread producer([&q]()
+	{
+		for (int i = 0; i < kNumItems; i += 2)
+			q.push(i);
+	});
+	for (int i = 1; i < kNumItems; i += 2)
+		q.push(i);
+	producer.join();
+	q.push(-1);
+	q.push(-1);
+	consumers[0].join();
+	consumers[1].join();
+	CHECK((long long)kNumItems * (kNumItems - 1) / 2 == sums[0] + sums[1]);
+}
+
+}
@@ -0,0 +1,258 @@
+#include "mutex.h"
+#include "hash_map.h"
+#include "vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <chrono>
+#include <thread>
+
+namespace
+{
+// Non-atomic counter, guarded by TMutex.
+template<class TMutex>
+void TestMutualExclusion()
+{
+	TMutex mutex;
+	int counter(0);
+	const int kNumThreads = 4;
+	const int kNumIterations = 5000;
+	std::thread threads[kNumThreads];
+	for (int t = 0; t < kNumThreads; ++t)
+	{
+		threads[t] = std::thread([&mutex, &counter]()
+		{
+			for (int i = 0; i < kNumIterations; ++i)
+			{
+				std::lock_guard<TMutex> guard(mutex);
+				++counter;
+			}
+		});
+	}
+	for (int t = 0; t < kNumThreads; ++t)
+		threads[t].join();
+	CHECK(kNumThreads * kNumIterations == counter);
+}
+
+TEST_CASE("mutex", "[mutex]")
+{
+	SECTION("Size")
+	{
+		CHECK(sizeof(rde::spin_mutex) <= RDE_CACHE_LINE_SIZE);
+		CHECK(sizeof(rde::adaptive_mutex) <= RDE_CACHE_LINE_SIZE);
+		CHECK(sizeof(rde::shared_mutex) <= RDE_CACHE_LINE_SIZE);
+	}
+	SECTION("SpinTryLock")
+	{
+		rde::spin_mutex m;
+		CHECK(m.try_lock());
+		CHECK(!m.try_lock());
+		m.unlock();
+		CHECK(m.try_lock());
+		m.unlock();
+	}
+	SECTION("AdaptiveTryLock")
+	{
+		rde::adaptive_mutex m;
+		CHECK(m.try_lock());
+		CHECK(!m.try_lock());
+		m.unlock();
+		m.lock();
+		CHECK(!m.try_lock());
+		m.unlock();
+	}
+	SECTION("SpinThreads")
+	{
+		TestMutualExclusion<rde::spin_mutex>();
+	}
+	SECTION("AdaptiveThreads")
+	{
+		TestMutualExclusion<rde::adaptive_mutex>();
+	}
+	SECTION("SharedThreads")
+	{
+		TestMutualExclusion<rde::shared_mutex>();
+	}
+	SECTION("SharedReaders")
+	{
+		rde::shared_mutex m;
+		m.lock_shared();
+		CHECK(m.try_lock_shared());
+		CHECK(!m.try_lock());
+		m.unlock_shared();
+		m.unlock_shared();
+		CHECK(m.try_lock());
+		CHECK(!m.try_lock_shared());
+		m.unlock();
+	}
+	SECTION("WriterPreferred")
+	{
+		rde::shared_mutex m;
+		m.lock_shared();
+		std::atomic<bool> writerDone(false);
+		std::thread writer([&m, &writerDone]()
+		{
+			m.lock();
+			writerDone = true;
+			m.unlock();
+		});
+		// Writer is waiting (or about to), new readers have to wait too.
+		while (m.try_lock_shared())
+		{
+			m.unlock_shared();
+			std::this_thread::yield();
+		}
+		CHECK(!writerDone.load());
+		m.unlock_shared();
+		writer.join();
+		CHECK(writerDone.load());
+		CHECK(m.try_lock_shared());
+		m.unlock_shared();
+	}
+	SECTION("ReadersAndWriters")
+	{
+		// Writers keep two values equal, readers must never see them differ.
+		rde::shared_mutex m;
+		int a(0), b(0);
+		std::atomic<int> numErrors(0);
+		std::thread threads[4];
+		for (int t = 0; t < 4; ++t)
+		{
+			threads[t] = std::thread([&, t]()
+			{
+				for (int i = 0; i < 2000; ++i)
+				{
+					if (t == 0)
+					{
+						std::lock_guard<rde::shared_mutex> guard(m);
+						++a;
+						++b;
+					}
+					else
+					{
+						m.lock_shared();
+						if (a != b)
+							++numErrors;
+						m.unlock_shared();
+					}
+				}
+			});
+		}
+		for (int t = 0; t < 4; ++t)
+			threads[t].join();
+		CHECK(0 == numErrors.load());
+		CHECK(2000 == a);
+	}
+	SECTION("SharedStress")
+	{
+		// Many tiny critical sections, so waiters keep going to sleep while
+		// lock is released and re-acquired under them. Lost wakeup shows up
+		// as threads that never finish.
+		struct stress
+		{
+			rde::shared_mutex	m;
+			int					a;
+			int					b;
+			std::atomic<int>	numErrors;
+			std::atomic<int>	numDone;
+		};
+		// Leaked if threads hang, they still reference it.
+		stress* st = new stress();
+		st->a = st->b = 0;
+		st->numErrors = 0;
+		st->numDone = 0;
+		const int kNumWriters = 2;
+		const int kNumThreads = 6;
+		const int kNumIterations = 20000;
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([st, t]()
+			{
+				for (int i = 0; i < kNumIterations; ++i)
+				{
+					if (t < kNumWriters)
+					{
+						st->m.lock();
+						++st->a;
+						++st->b;
+						st->m.unlock();
+					}
+					else
+					{
+						st->m.lock_shared();
+						if (st->a != st->b)
+							++st->numErrors;
+						st->m.unlock_shared();
+					}
+				}
+				++st->numDone;
+			});
+		}
+		const std::chrono::steady_clock::time_point deadline =
+			std::chrono::steady_clock::now() + std::chrono::seconds(60);
+		while (st->numDone.load() != kNumThreads && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const bool finished = (st->numDone.load() == kNumThreads);
+		CHECK(finished);
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			if (finished)
+				threads[t].join();
+			else
+				threads[t].detach();
+		}
+		if (finished)
+		{
+			CHECK(0 == st->numErrors.load());
+			CHECK(kNumWriters * kNumIterations == st->a);
+			delete st;
+		}
+	}
+}
+
+TEST_CASE("locked", "[mutex]")
+{
+	SECTION("Vector")
+	{
+		rde::locked<rde::vector<int> > v;
+		v.lock()->push_back(1);
+		{
+			rde::locked<rde::vector<int> >::access a = v.lock();
+			a->push_back(2);
+			CHECK(2 == (*a).size());
+		}
+		CHECK(3 == v.with_lock([](rde::vector<int>& vec) { return vec[0] + vec[1]; }));
+		// No lock_shared in adaptive_mutex, falls back to exclusive lock.
+		CHECK(2 == v.with_shared_lock([](const rde::vector<int>& vec) { return vec.back(); }));
+	}
+	SECTION("HashMapThreads")
+	{
+		typedef rde::hash_map<int, int> tMap;
+		rde::locked<tMap, rde::shared_mutex> m;
+		const int kNumThreads = 4;
+		std::atomic<int> numErrors(0);
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&m, &numErrors, t]()
+			{
+				for (int i = 0; i < 500; ++i)
+				{
+					const int key = t * 1000 + i;
+					m.with_lock([key](tMap& map) { map[key] = key * 2; });
+					const int value = m.with_shared_lock([key](const tMap& map)
+					{
+						tMap::const_iterator it = map.find(key);
+						return it == map.end() ? -1 : it->second;
+					});
+					if (value != key * 2)
+						++numErrors;
+				}
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(0 == numErrors.load());
+		CHECK(kNumThreads * 500 == m.lock()->size());
+	}
+}
+}
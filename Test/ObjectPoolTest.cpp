@@ -0,0 +1,169 @@
+#include "object_pool.h"
+#include "intrusive_list.h"
+#include "list.h"
+#include "sort.h"
+#include "vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+struct Entity: public rde::intrusive_list_node
+{
+	explicit Entity(int id_ = 0): id(id_)	{ ++s_numAlive; }
+	~Entity()								{ --s_numAlive; }
+	int						id;
+	float					pos[3];
+	static std::atomic<int>	s_numAlive;
+};
+std::atomic<int> Entity::s_numAlive(0);
+
+struct alignas(32) Aligned
+{
+	char	data[40];
+};
+
+TEST_CASE("object_pool", "[object_pool]")
+{
+	SECTION("CreateDestroy")
+	{
+		rde::object_pool<Entity> pool;
+		Entity* e = pool.create(5);
+		REQUIRE(e != 0);
+		CHECK(5 == e->id);
+		CHECK(1 == Entity::s_numAlive);
+		CHECK(1 == pool.num_slabs());
+		pool.destroy(e);
+		CHECK(0 == Entity::s_numAlive);
+		// Blocks are reused.
+		Entity* e2 = pool.create(6);
+		CHECK(e == e2);
+		pool.destroy(e2);
+	}
+	SECTION("Alignment")
+	{
+		rde::object_pool<Aligned> pool;
+		rde::vector<Aligned*> v;
+		for (int i = 0; i < 100; ++i)
+		{
+			Aligned* a = pool.allocate();
+			CHECK(0 == (reinterpret_cast<size_t>(a) & 31));
+			v.push_back(a);
+		}
+		for (size_t i = 0; i < v.size(); ++i)
+			pool.deallocate(v[i]);
+	}
+	SECTION("SlabsReleasedWhenEmpty")
+	{
+		rde::object_pool<Entity> pool;
+		const size_t n = pool.blocks_per_slab() * 4;
+		rde::vector<Entity*> v;
+		for (size_t i = 0; i < n; ++i)
+			v.push_back(pool.create(int(i)));
+		const size_t numSlabs = pool.num_slabs();
+		CHECK(numSlabs >= 4);
+		// All different.
+		rde::vector<Entity*> sorted(v);
+		rde::quick_sort(sorted.begin(), sorted.end());
+		bool unique = true;
+		for (size_t i = 1; i < sorted.size(); ++i)
+			unique &= (sorted[i - 1] != sorted[i]);
+		CHECK(unique);
+
+		for (size_t i = 0; i < n; ++i)
+			pool.destroy(v[i]);
+		CHECK(0 == Entity::s_numAlive);
+		// Some blocks are still cached, spare slab is kept.
+		CHECK(pool.num_slabs() < numSlabs);
+		pool.trim();
+		CHECK(0 == pool.num_slabs());
+	}
+	SECTION("IntrusiveList")
+	{
+		rde::object_pool<Entity> pool;
+		rde::intrusive_list<Entity> entities;
+		for (int i = 0; i < 10; ++i)
+			entities.push_back(pool.create(i));
+		CHECK(10 == entities.size());
+		while (!entities.empty())
+		{
+			Entity* e = entities.front();
+			entities.pop_front();
+			pool.destroy(e);
+		}
+		CHECK(0 == Entity::s_numAlive);
+	}
+	SECTION("PoolAllocator")
+	{
+		rde::block_pool<> pool(64);
+		typedef rde::pool_allocator<> tAllocator;
+		{
+			rde::list<int, tAllocator> l((tAllocator(&pool)));
+			for (int i = 0; i < 1000; ++i)
+				l.push_back(i);
+			CHECK(pool.num_slabs() > 0);
+			CHECK(1000 == l.size());
+			CHECK(999 == l.back());
+			const size_t numSlabs = pool.num_slabs();
+			l.clear();
+			for (int i = 0; i < 1000; ++i)
+				l.push_front(i);
+			CHECK(numSlabs == pool.num_slabs());
+		}
+		pool.trim();
+		CHECK(0 == pool.num_slabs());
+
+		// Default constructed one just forwards to operator new.
+		tAllocator a;
+		void* p = a.allocate(16);
+		a.deallocate(p, 16);
+		CHECK(a != tAllocator(&pool));
+	}
+	SECTION("Threads")
+	{
+		// Objects are created on one thread and destroyed on another.
+		rde::object_pool<Entity> pool;
+		const int kNumThreads = 4;
+		const int kNumObjects = 2000;
+		rde::vector<Entity*> objects[kNumThreads];
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&pool, &objects, t]()
+			{
+				for (int i = 0; i < kNumObjects; ++i)
+					objects[t].push_back(pool.create(t * kNumObjects + i));
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(kNumThreads * kNumObjects == Entity::s_numAlive);
+		bool ok = true;
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			for (int i = 0; i < kNumObjects; ++i)
+				ok &= (objects[t][i]->id == t * kNumObjects + i);
+		}
+		CHECK(ok);
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&pool, &objects, t]()
+			{
+				rde::vector<Entity*>& mine = objects[(t + 1) % kNumThreads];
+				for (size_t i = 0; i < mine.size(); ++i)
+				{
+					// Churn a little on the way.
+					Entity* tmp = pool.create(-1);
+					pool.destroy(mine[i]);
+					pool.destroy(tmp);
+				}
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(0 == Entity::s_numAlive);
+		pool.trim();
+		CHECK(0 == pool.num_slabs());
+	}
+}
+}
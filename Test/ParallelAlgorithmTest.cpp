@@ -0,0 +1,108 @@
+#include "parallel_algorithm.h"
+#include "vendor/Catch/catch.hpp"
+
+namespace
+{
+// Big enough to go parallel.
+const int kNumElements = RDE_PARALLEL_THRESHOLD * 8 + 123;
+
+TEST_CASE("parallel_algorithm", "[parallel_algorithm]")
+{
+	rde::job_system js(3);
+
+	rde::vector<int> v;
+	for (int i = 0; i < kNumElements; ++i)
+		v.push_back(i);
+
+	SECTION("ForEach")
+	{
+		rde::parallel_for_each(js, v.begin(), v.end(), [](int& x) { x *= 2; });
+		bool ok = true;
+		for (int i = 0; i < kNumElements; ++i)
+			ok &= (i * 2 == v[i]);
+		CHECK(ok);
+
+		rde::parallel_for_each(v, [](int& x) { x += 1; });
+		CHECK(1 == v[0]);
+		CHECK((kNumElements - 1) * 2 + 1 == v.back());
+	}
+	SECTION("Transform")
+	{
+		rde::vector<long long> out;
+		out.resize(kNumElements);
+		rde::parallel_transform(js, v.begin(), v.end(), out.begin(), [](int x) { return (long long)x * x; });
+		bool ok = true;
+		for (int i = 0; i < kNumElements; ++i)
+			ok &= ((long long)i * i == out[i]);
+		CHECK(ok);
+
+		// In place.
+		rde::parallel_transform(js, v.begin(), v.end(), v.begin(), [](int x) { return -x; });
+		CHECK(-(kNumElements - 1) == v.back());
+	}
+	SECTION("Reduce")
+	{
+		const long long expected = (long long)kNumElements * (kNumElements - 1) / 2;
+		CHECK(expected == rde::parallel_reduce(js, v.begin(), v.end(), 0LL,
+			[](long long a, long long b) { return a + b; }));
+		CHECK(expected + 5 == rde::parallel_reduce(v, 5LL, [](long long a, long long b) { return a + b; }));
+
+		rde::serial_executor serial;
+		CHECK(expected == rde::parallel_reduce(serial, v.begin(), v.end(), 0LL,
+			[](long long a, long long b) { return a + b; }));
+
+		// Empty/small ranges.
+		CHECK(7 == rde::parallel_reduce(js, v.begin(), v.begin(), 7, [](int a, int b) { return a + b; }));
+		CHECK(7 + 0 + 1 + 2 == rde::parallel_reduce(js, v.begin(), v.begin() + 3, 7, [](int a, int b) { return a + b; }));
+	}
+	SECTION("InclusiveScan")
+	{
+		rde::vector<int> ones;
+		ones.insert(ones.end(), kNumElements, 1);
+		rde::vector<int> out;
+		out.resize(kNumElements);
+		rde::parallel_inclusive_scan(js, ones.begin(), ones.end(), out.begin(), [](int a, int b) { return a + b; });
+		bool ok = true;
+		for (int i = 0; i < kNumElements; ++i)
+			ok &= (i + 1 == out[i]);
+		CHECK(ok);
+
+		// In place, non-commutative op would still keep order.
+		rde::parallel_inclusive_scan(js, v.begin(), v.end(), v.begin(), [](int a, int b) { return a > b ? a : b; });
+		CHECK(kNumElements - 1 == v.back());
+		CHECK(100 == v[100]);
+	}
+	SECTION("Find")
+	{
+		CHECK(v.begin() + 12345 == rde::parallel_find(js, v.begin(), v.end(), 12345));
+		CHECK(v.end() == rde::parallel_find(js, v.begin(), v.end(), -1));
+		// Multiple matches, first one wins.
+		v[kNumElements - 10] = 7;
+		v[kNumElements / 2] = 7;
+		CHECK(v.begin() + 7 == rde::parallel_find(v, 7));
+		v[7] = 0;
+		CHECK(v.begin() + kNumElements / 2 == rde::parallel_find(js, v.begin(), v.end(), 7));
+	}
+	SECTION("Sort")
+	{
+		unsigned int seed = 12345;
+		for (int i = 0; i < kNumElements; ++i)
+		{
+			seed = seed * 1103515245 + 12345;
+			v[i] = int(seed >> 8) % 1000;
+		}
+		rde::vector<int> v2(v);
+		rde::parallel_sort(js, v.begin(), v.end());
+		bool sorted = true;
+		for (int i = 1; i < kNumElements; ++i)
+			sorted &= (v[i - 1] <= v[i]);
+		CHECK(sorted);
+		CHECK(rde::parallel_reduce(js, v.begin(), v.end(), 0LL, [](long long a, long long b) { return a + b; }) ==
+			rde::parallel_reduce(js, v2.begin(), v2.end(), 0LL, [](long long a, long long b) { return a + b; }));
+
+		rde::parallel_sort(v2, [](int a, int b) { return a > b; });
+		CHECK(v2.front() == v.back());
+		CHECK(v2.back() == v.front());
+	}
+}
+}
@@ -0,0 +1,87 @@
+#include "per_thread.h"
+#include "vendor/Catch/catch.hpp"
+#include <mutex>
+#include <thread>
+
+namespace
+{
+TEST_CASE("per_thread", "[per_thread]")
+{
+	SECTION("Local")
+	{
+		rde::per_thread<int> counts;
+		CHECK(0 == counts.local());
+		counts.local() += 5;
+		CHECK(5 == counts.local());
+		CHECK(5 == counts.combine(0, [](int a, int b) { return a + b; }));
+	}
+	SECTION("Init")
+	{
+		rde::per_thread<int, 8> v(3);
+		CHECK(8 == v.size());
+		CHECK(3 * 8 == v.combine(0, [](int a, int b) { return a + b; }));
+		v.for_each([](int& x) { x = 1; });
+		CHECK(1 == v[7]);
+	}
+	SECTION("Threads")
+	{
+		struct scratch
+		{
+			long long	sum;
+			int			count;
+		};
+		rde::per_thread<scratch> perThread;
+		perThread.for_each([](scratch& s) { s.sum = 0; s.count = 0; });
+		const int kNumThreads = 4;
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&perThread, t]()
+			{
+				scratch& s = perThread.local();
+				for (int i = 0; i < 1000; ++i)
+				{
+					s.sum += t;
+					++s.count;
+				}
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(kNumThreads * 1000 == perThread.combine(0, [](int a, const scratch& s) { return a + s.count; }));
+		CHECK((0 + 1 + 2 + 3) * 1000 == perThread.combine(0LL, [](long long a, const scratch& s) { return a + s.sum; }));
+	}
+	SECTION("MoreThreadsThanSlots")
+	{
+		// Threads alive at the same time get distinct indices, some of them
+		// past the number of slots, they have to share.
+		rde::per_thread<int, 2> counts;
+		const int kNumThreads = 5;
+		std::atomic<int> numReady(0);
+		std::mutex lock;
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&]()
+			{
+				++numReady;
+				while (numReady.load() != kNumThreads)
+					std::this_thread::yield();
+				std::lock_guard<std::mutex> g(lock);
+				++counts.local();
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(kNumThreads == counts.combine(0, [](int a, int b) { return a + b; }));
+	}
+	SECTION("ThreadIndicesReused")
+	{
+		std::uint32_t first(0), second(0);
+		std::thread([&first]() { first = rde::internal::this_thread_index(); }).join();
+		std::thread([&second]() { second = rde::internal::this_thread_index(); }).join();
+		CHECK(first == second);
+		CHECK(first != rde::internal::this_thread_index());
+	}
+}
+}
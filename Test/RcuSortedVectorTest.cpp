@@ -0,0 +1,169 @@
+#include <atomic>
+#include <thread>
+#include "rcu_sorted_vector.h"
+#include "vendor/Catch/catch.hpp"
+
+namespace
+{
+typedef rde::rcu_sorted_vector<int, int> tTable;
+
+TEST_CASE("rcu_sorted_vector", "[vector]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tTable t;
+		tTable::reader r(t);
+		int v(0);
+		CHECK(!r.find(5, v));
+		CHECK(0 == r.read([](const tTable::snapshot& s) { return s.size(); }));
+		CHECK(0 == t.retired_count());
+	}
+	SECTION("CommitBatch")
+	{
+		tTable t;
+		tTable::reader r(t);
+		tTable::update_batch batch;
+		for (int i = 9; i >= 0; --i)
+			batch.insert(i, i * 10);
+		CHECK(10 == batch.size());
+		// Nothing visible before commit.
+		CHECK(!r.contains(5));
+		t.commit(batch);
+		CHECK(batch.empty());
+		int v(0);
+		CHECK(r.find(5, v));
+		CHECK(50 == v);
+		CHECK(!r.contains(10));
+		// Sorted, lower/upper bound work on snapshot.
+		const bool sorted = r.read([](const tTable::snapshot& s)
+		{
+			bool ok = (10 == s.size() && 1 == s.version());
+			for (tTable::snapshot::const_iterator it = s.begin(); it != s.end(); ++it)
+				ok &= (it->first == int(it - s.begin()));
+			ok &= (s.lower_bound(3)->first == 3 && s.upper_bound(3)->first == 4);
+			return ok;
+		});
+		CHECK(sorted);
+		// No readers inside, replaced version was freed right away.
+		CHECK(0 == t.retired_count());
+	}
+	SECTION("LastChangeWins")
+	{
+		tTable t;
+		tTable::reader r(t);
+		t.insert(1, 1);
+		t.insert(2, 2);
+		t.insert(3, 3);
+		tTable::update_batch batch;
+		batch.insert(1, 10);
+		batch.erase(2);
+		batch.insert(2, 20);
+		batch.insert(3, 30);
+		batch.erase(3);
+		batch.erase(4);
+		batch.insert(0, 0);
+		t.commit(batch);
+		int v(0);
+		CHECK(r.find(1, v));
+		CHECK(10 == v);
+		CHECK(r.find(2, v));
+		CHECK(20 == v);
+		CHECK(!r.contains(3));
+		CHECK(!r.contains(4));
+		CHECK(r.contains(0));
+		CHECK(3 == r.read([](const tTable::snapshot& s) { return s.size(); }));
+		CHECK(4 == r.read([](const tTable::snapshot& s) { return s.version(); }));
+	}
+	SECTION("Clear")
+	{
+		tTable t;
+		tTable::reader r(t);
+		t.insert(1, 1);
+		t.insert(2, 2);
+		tTable::update_batch batch;
+		batch.insert(7, 7);
+		batch.clear();
+		batch.insert(3, 3);
+		t.commit(batch);
+		CHECK(!r.contains(1));
+		CHECK(!r.contains(7));
+		CHECK(r.contains(3));
+		// Clear alone is a change too.
+		batch.clear();
+		CHECK(!batch.empty());
+		t.commit(batch);
+		CHECK(!r.contains(3));
+	}
+	SECTION("OldVersionKeptWhileRead")
+	{
+		tTable t;
+		tTable::reader r(t);
+		t.insert(1, 1);
+		r.read([&t](const tTable::snapshot& s)
+		{
+			// Reader still sees version it started with.
+			t.insert(1, 2);
+			t.erase(1);
+			CHECK(1 == s.find(1)->second);
+			CHECK(1 == s.version());
+			CHECK(2 == t.retired_count());
+			return 0;
+		});
+		CHECK(!r.contains(1));
+		t.reclaim();
+		CHECK(0 == t.retired_count());
+	}
+	SECTION("ConcurrentReaders")
+	{
+		// Writer keeps value == key * version, readers must always see one
+		// consistent version.
+		tTable t;
+		tTable::update_batch batch;
+		for (int i = 0; i < 100; ++i)
+			batch.insert(i, 0);
+		t.commit(batch);
+
+		std::atomic<bool> done(false);
+		std::atomic<int> numErrors(0);
+		std::thread readers[3];
+		for (int r = 0; r < 3; ++r)
+		{
+			readers[r] = std::thread([&]()
+			{
+				tTable::reader reader(t);
+				while (!done.load())
+				{
+					const bool ok = reader.read([](const tTable::snapshot& s)
+					{
+						const int version = int(s.version()) - 1;
+						bool consistent = (100 == s.size());
+						for (tTable::snapshot::const_iterator it = s.begin(); it != s.end(); ++it)
+							consistent &= (it->second == it->first * version);
+						return consistent;
+					});
+					if (!ok)
+						++numErrors;
+					int v(-1);
+					if (!reader.find(50, v) || v % 50 != 0)
+						++numErrors;
+					std::this_thread::yield();
+				}
+			});
+		}
+		for (int version = 1; version < 200; ++version)
+		{
+			for (int i = 0; i < 100; ++i)
+				batch.insert(i, i * version);
+			t.commit(batch);
+			if ((version & 15) == 0)
+				std::this_thread::yield();
+		}
+		done.store(true);
+		for (int r = 0; r < 3; ++r)
+			readers[r].join();
+		t.reclaim();
+		CHECK(0 == numErrors.load());
+		CHECK(0 == t.retired_count());
+	}
+}
+} // namespace
@@ -0,0 +1,190 @@
+#include "ring_buffer.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::ring_buffer<int>		tGrowable;
+typedef rde::ring_buffer<int, 8>	tFixed;
+
+// Tags every block with id of allocator that created it.
+struct tagged_allocator
+{
+	static int	s_numForeignFrees;
+
+	explicit tagged_allocator(int id_ = 0): id(id_) {}
+
+	void* allocate(size_t bytes, int /*flags*/ = 0)
+	{
+		int* p = static_cast<int*>(rde::allocator().allocate(bytes + sizeof(double)));
+		*p = id;
+		return reinterpret_cast<char*>(p) + sizeof(double);
+	}
+	void deallocate(void* ptr, size_t bytes)
+	{
+		int* p = reinterpret_cast<int*>(static_cast<char*>(ptr) - sizeof(double));
+		if (*p != id)
+			++s_numForeignFrees;
+		rde::allocator().deallocate(p, bytes + sizeof(double));
+	}
+	const char* get_name() const	{ return "TAGGED"; }
+
+	int	id;
+};
+int tagged_allocator::s_numForeignFrees = 0;
+
+TEST_CASE("ring_buffer", "[ring_buffer]")
+{
+	SECTION("Empty")
+	{
+		tGrowable g;
+		CHECK(g.empty());
+		CHECK(0 == g.capacity());
+		tFixed f;
+		CHECK(f.empty());
+		CHECK(8 == f.capacity());
+		CHECK(0 == f.readable().size());
+	}
+	SECTION("PushPop")
+	{
+		tFixed f;
+		for (int i = 0; i < 8; ++i)
+			f.push_back(i);
+		CHECK(f.full());
+		CHECK(0 == f.front());
+		CHECK(7 == f.back());
+		f.pop_front();
+		f.pop_front();
+		f.push_back(8);
+		f.push_back(9);
+		CHECK(f.full());
+		for (int i = 0; i < 8; ++i)
+			CHECK(i + 2 == f[i]);
+		f.pop_back();
+		CHECK(8 == f.back());
+		CHECK(7 == f.size());
+	}
+	SECTION("GrowWrapped")
+	{
+		tGrowable g;
+		for (int i = 0; i < 10; ++i)
+			g.push_back(i);
+		for (int i = 0; i < 5; ++i)
+			g.pop_front();
+		const size_t capacity = g.capacity();
+		int next = 10;
+		while (g.size() < capacity)
+			g.push_back(next++);
+		// Wrapped and full, next push has to unwrap into bigger buffer.
+		g.push_back(next++);
+		CHECK(g.capacity() == capacity * 2);
+		for (size_t i = 0; i < g.size(); ++i)
+			CHECK(int(i) + 5 == g[i]);
+	}
+	SECTION("Overwrite")
+	{
+		rde::ring_buffer<int, 4> history;
+		for (int i = 0; i < 10; ++i)
+			history.push_back_overwrite(i);
+		CHECK(4 == history.size());
+		CHECK(6 == history.front());
+		CHECK(9 == history.back());
+		tGrowable g;
+		g.reserve(4);
+		for (int i = 0; i < 100; ++i)
+			g.push_back_overwrite(i);
+		CHECK(g.full());
+		CHECK(99 == g.back());
+		CHECK(int(100 - g.capacity()) == g.front());
+	}
+	SECTION("Bulk")
+	{
+		tFixed f;
+		const int values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		CHECK(5 == f.push_back_n(values, 5));
+		int out[8];
+		CHECK(3 == f.pop_front_n(out, 3));
+		CHECK(2 == out[2]);
+		// 2 elements left at [3, 5), 6 free, wraps.
+		CHECK(6 == f.push_back_n(values + 4, 10));
+		CHECK(f.full());
+		tFixed::spans s = f.readable();
+		CHECK(5 == s.firstSize);
+		CHECK(3 == s.secondSize);
+		CHECK(3 == s.first[0]);
+		CHECK(9 == s.second[2]);
+		f.consume(4);
+		CHECK(4 == f.size());
+		CHECK(6 == f.front());
+		CHECK(4 == f.pop_front_n(out, 8));
+		CHECK(9 == out[3]);
+		CHECK(f.empty());
+	}
+	SECTION("WritableCommit")
+	{
+		tFixed f;
+		f.push_back(0);
+		f.push_back(1);
+		f.pop_front();
+		tFixed::spans s = f.writable(100);
+		CHECK(7 == s.size());
+		CHECK(6 == s.firstSize);
+		for (size_t i = 0; i < s.firstSize; ++i)
+			s.first[i] = int(i) + 2;
+		for (size_t i = 0; i < s.secondSize; ++i)
+			s.second[i] = int(i + s.firstSize) + 2;
+		f.commit(s.size());
+		CHECK(f.full());
+		for (int i = 0; i < 8; ++i)
+			CHECK(i + 1 == f[i]);
+		tGrowable g;
+		CHECK(100 == g.writable(100).size());
+		CHECK(g.capacity() >= 100);
+	}
+	SECTION("NonPod")
+	{
+		rde::ring_buffer<std::string> g;
+		for (int i = 0; i < 40; ++i)
+		{
+			g.push_back(std::to_string(i));
+			if (i % 3 == 0)
+				g.pop_front();
+		}
+		rde::ring_buffer<std::string> g2(g);
+		CHECK(g.size() == g2.size());
+		CHECK(g.front() == g2.front());
+		rde::ring_buffer<std::string> g3(std::move(g2));
+		CHECK(g2.empty());
+		CHECK("39" == g3.back());
+		rde::ring_buffer<std::string, 4> f;
+		f.emplace_back("a");
+		f.emplace_back("b");
+		rde::ring_buffer<std::string, 4> f2(std::move(f));
+		CHECK(f.empty());
+		CHECK("b" == f2.back());
+		f = f2;
+		CHECK(2 == f.size());
+	}
+	SECTION("MoveAssignAllocator")
+	{
+		tagged_allocator::s_numForeignFrees = 0;
+		{
+			rde::ring_buffer<int, 0, tagged_allocator> a((tagged_allocator(1)));
+			rde::ring_buffer<int, 0, tagged_allocator> b((tagged_allocator(2)));
+			for (int i = 0; i < 10; ++i)
+			{
+				a.push_back(i);
+				b.push_back(-i);
+			}
+			a = std::move(b);
+			CHECK(10 == a.size());
+			CHECK(-9 == a.back());
+			CHECK(b.empty());
+			b.push_back(1);
+			CHECK(1 == b.size());
+		}
+		CHECK(0 == tagged_allocator::s_numForeignFrees);
+	}
+}
+
+}
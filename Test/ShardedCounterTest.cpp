@@ -0,0 +1,82 @@
+#include "sharded_counter.h"
+#include "vendor/Catch/catch.hpp"
+#include <thread>
+
+namespace
+{
+TEST_CASE("sharded_counter", "[sharded_counter]")
+{
+	SECTION("Basic")
+	{
+		rde::sharded_counter c;
+		CHECK(0 == c.value());
+		c.increment();
+		c.add(10);
+		c.decrement();
+		CHECK(10 == c.value());
+		c.reset();
+		CHECK(0 == c.value());
+	}
+	SECTION("Threads")
+	{
+		// More threads than shards, some have to share.
+		rde::basic_sharded_counter<2> c;
+		const int kNumThreads = 5;
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&c]()
+			{
+				for (int i = 0; i < 10000; ++i)
+					c.increment();
+			});
+		}
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		CHECK(kNumThreads * 10000 == c.value());
+	}
+}
+
+TEST_CASE("sharded_accumulator", "[sharded_counter]")
+{
+	SECTION("Stats")
+	{
+		rde::sharded_accumulator<double> acc;
+		CHECK(0 == acc.stats().count);
+		acc.add(2.0);
+		acc.add(-1.0);
+		acc.add(5.0);
+		const rde::sharded_accumulator<double>::stats_type s = acc.stats();
+		CHECK(3 == s.count);
+		CHECK(6.0 == s.sum);
+		CHECK(-1.0 == s.min);
+		CHECK(5.0 == s.max);
+		CHECK(2.0 == s.mean());
+		acc.reset();
+		CHECK(0 == acc.stats().count);
+	}
+	SECTION("Threads")
+	{
+		rde::sharded_accumulator<int, 4> acc;
+		const int kNumThreads = 6;
+		std::thread threads[kNumThreads];
+		for (int t = 0; t < kNumThreads; ++t)
+		{
+			threads[t] = std::thread([&acc, t]()
+			{
+				for (int i = 0; i < 1000; ++i)
+					acc.add(t * 1000 + i);
+			});
+		}
+		// Reading while others are adding is fine.
+		CHECK(acc.stats().count <= kNumThreads * 1000);
+		for (int t = 0; t < kNumThreads; ++t)
+			threads[t].join();
+		const rde::accumulator_stats<int> s = acc.stats();
+		CHECK(kNumThreads * 1000 == s.count);
+		CHECK(0 == s.min);
+		CHECK(kNumThreads * 1000 - 1 == s.max);
+		CHECK((kNumThreads * 1000 - 1) * kNumThreads * 1000 / 2 == s.sum);
+	}
+}
+}
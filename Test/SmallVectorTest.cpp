@@ -0,0 +1,124 @@
+#include "small_vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::small_vector<int, 4>			tTestVector;
+typedef rde::small_vector<std::string, 4>	tStringVector;
+
+const int array[] ={ 1, 4, 9, 16, 25, 36 };
+
+TEST_CASE("small_vector", "[vector]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tTestVector v;
+		CHECK(v.empty());
+		CHECK(0 == v.size());
+		CHECK(4 == v.capacity());
+		CHECK(v.is_inline());
+	}
+	SECTION("PushBackInline")
+	{
+		tTestVector v;
+		const int* data = v.begin();
+		for (int i = 0; i < 4; ++i)
+			v.push_back(i);
+		CHECK(4 == v.size());
+		CHECK(v.is_inline());
+		CHECK(data == v.begin());
+		// Inline buffer is part of the object.
+		CHECK(reinterpret_cast<const char*>(data) >= reinterpret_cast<const char*>(&v));
+		CHECK(reinterpret_cast<const char*>(data) < reinterpret_cast<const char*>(&v + 1));
+	}
+	SECTION("SpillToHeap")
+	{
+		tStringVector v;
+		for (int i = 0; i < 10; ++i)
+			v.push_back(std::to_string(i));
+		CHECK(!v.is_inline());
+		CHECK(10 == v.size());
+		for (int i = 0; i < 10; ++i)
+			CHECK(std::to_string(i) == v[i]);
+	}
+	SECTION("ShrinkToFitGoesInline")
+	{
+		tStringVector v;
+		for (int i = 0; i < 10; ++i)
+			v.push_back(std::to_string(i));
+		v.erase(v.begin() + 3, v.end());
+		v.shrink_to_fit();
+		CHECK(v.is_inline());
+		CHECK(3 == v.size());
+		CHECK("0" == v[0]);
+		CHECK("2" == v[2]);
+		v.push_back("3");
+		CHECK(v.is_inline());
+	}
+	SECTION("CopyConstructor")
+	{
+		tTestVector v(array, array + 6);
+		tTestVector v2(v);
+		CHECK(6 == v2.size());
+		CHECK(0 == memcmp(array, v2.data(), sizeof(array)));
+		tTestVector v3(array, array + 2);
+		tTestVector v4(v3);
+		CHECK(v4.is_inline());
+		CHECK(2 == v4.size());
+		CHECK(4 == v4[1]);
+	}
+	SECTION("MoveInline")
+	{
+		tStringVector v;
+		v.push_back("hello");
+		v.push_back("world");
+		tStringVector v2(std::move(v));
+		CHECK(v.empty());
+		CHECK(v2.is_inline());
+		CHECK(2 == v2.size());
+		CHECK("world" == v2[1]);
+	}
+	SECTION("MoveHeap")
+	{
+		tStringVector v;
+		for (int i = 0; i < 10; ++i)
+			v.push_back(std::to_string(i));
+		const std::string* data = v.begin();
+		tStringVector v2;
+		v2.push_back("x");
+		v2 = std::move(v);
+		CHECK(v.empty());
+		CHECK(v.is_inline());
+		CHECK(data == v2.begin());
+		CHECK(10 == v2.size());
+		CHECK("9" == v2[9]);
+	}
+	SECTION("InsertErase")
+	{
+		tTestVector v(array, array + 3);
+		v.insert(v.begin(), 0);
+		v.insert(v.begin() + 2, 3);
+		// 0, 1, 3, 4, 9
+		CHECK(5 == v.size());
+		CHECK(0 == v[0]);
+		CHECK(3 == v[2]);
+		CHECK(9 == v[4]);
+		v.erase(v.begin());
+		v.erase(v.begin());
+		CHECK(3 == v.size());
+		CHECK(3 == v[0]);
+	}
+	SECTION("ResetClear")
+	{
+		tTestVector v(array, array + 6);
+		v.clear();
+		CHECK(v.empty());
+		CHECK(!v.is_inline());
+		v.reset();
+		CHECK(v.is_inline());
+		v.push_back(1);
+		CHECK(1 == v[0]);
+	}
+}
+} // namespace
@@ -0,0 +1,137 @@
+#include "soa_vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::soa_vector<int, float, std::string>	tTestVector;
+
+void Fill(tTestVector& v, int n)
+{
+	for (int i = 0; i < n; ++i)
+		v.push_back(i, float(i) * 0.5f, std::to_string(i));
+}
+
+TEST_CASE("soa_vector", "[vector]")
+{
+	SECTION("Empty")
+	{
+		tTestVector v;
+		CHECK(v.empty());
+		CHECK(0 == v.size());
+		CHECK(0 == v.capacity());
+		CHECK(0 == v.column<0>().size());
+	}
+	SECTION("PushBack")
+	{
+		tTestVector v;
+		Fill(v, 100);
+		CHECK(100 == v.size());
+		CHECK(v.capacity() >= 100);
+		for (int i = 0; i < 100; ++i)
+		{
+			CHECK(i == v.get<0>(i));
+			CHECK(float(i) * 0.5f == v.get<1>(i));
+			CHECK(std::to_string(i) == v.get<2>(i));
+		}
+		v.push_back(std::make_tuple(7, 1.f, std::string("seven")));
+		CHECK(101 == v.size());
+		CHECK(std::make_tuple(7, 1.f, std::string("seven")) == v.row(100));
+	}
+	SECTION("ColumnsAligned")
+	{
+		tTestVector v;
+		Fill(v, 33);
+		CHECK(0 == (reinterpret_cast<uintptr_t>(v.column_data<0>()) % tTestVector::kColumnAlignment));
+		CHECK(0 == (reinterpret_cast<uintptr_t>(v.column_data<1>()) % tTestVector::kColumnAlignment));
+		CHECK(0 == (reinterpret_cast<uintptr_t>(v.column_data<2>()) % tTestVector::kColumnAlignment));
+	}
+	SECTION("ColumnSpan")
+	{
+		tTestVector v;
+		Fill(v, 10);
+		int sum(0);
+		for (int x : v.column<0>())
+			sum += x;
+		CHECK(45 == sum);
+		auto floats = v.column<1>();
+		CHECK(10 == floats.size());
+		for (size_t i = 0; i < floats.size(); ++i)
+			floats[i] *= 2.f;
+		CHECK(9.f == v.get<1>(9));
+	}
+	SECTION("EraseUnordered")
+	{
+		tTestVector v;
+		Fill(v, 5);
+		v.erase_unordered(1);
+		CHECK(4 == v.size());
+		CHECK(4 == v.get<0>(1));
+		CHECK("4" == v.get<2>(1));
+		v.pop_back();
+		CHECK(3 == v.size());
+		CHECK(2 == v.get<0>(2));
+	}
+	SECTION("Resize")
+	{
+		tTestVector v;
+		Fill(v, 3);
+		v.resize(6);
+		CHECK(6 == v.size());
+		CHECK(0 == v.get<0>(5));
+		CHECK(v.get<2>(5).empty());
+		v.resize(2);
+		CHECK(2 == v.size());
+		CHECK("1" == v.get<2>(1));
+		v.clear();
+		CHECK(v.empty());
+	}
+	SECTION("CopyMove")
+	{
+		tTestVector v;
+		Fill(v, 20);
+		tTestVector v2(v);
+		CHECK(20 == v2.size());
+		CHECK("19" == v2.get<2>(19));
+		tTestVector v3(std::move(v2));
+		CHECK(v2.empty());
+		CHECK(20 == v3.size());
+		v = v3;
+		CHECK(20 == v.size());
+		CHECK(v.row(7) == v3.row(7));
+	}
+	SECTION("Permute")
+	{
+		tTestVector v;
+		Fill(v, 4);
+		const std::uint32_t indices[] = { 2, 0, 3, 1 };
+		v.permute(indices);
+		CHECK(std::make_tuple(2, 1.f, std::string("2")) == v.row(0));
+		CHECK(std::make_tuple(0, 0.f, std::string("0")) == v.row(1));
+		CHECK(std::make_tuple(3, 1.5f, std::string("3")) == v.row(2));
+		CHECK(std::make_tuple(1, 0.5f, std::string("1")) == v.row(3));
+	}
+	SECTION("Sort")
+	{
+		tTestVector v;
+		for (int i = 0; i < 50; ++i)
+		{
+			const int key = (i * 37) % 50;
+			v.push_back(key, float(key), std::to_string(key));
+		}
+		v.sort_by_column<0>();
+		for (int i = 0; i < 50; ++i)
+		{
+			CHECK(i == v.get<0>(i));
+			CHECK(float(i) == v.get<1>(i));
+			CHECK(std::to_string(i) == v.get<2>(i));
+		}
+		// Descending, by float column.
+		const float* floats = v.column_data<1>();
+		v.sort([floats](size_t a, size_t b) { return floats[a] > floats[b]; });
+		CHECK(49 == v.get<0>(0));
+		CHECK("0" == v.get<2>(49));
+	}
+}
+
+}
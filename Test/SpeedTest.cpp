@@ -1,8 +1,28 @@
 #include <windows.h>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <vector>
 #include <string>
+#include "bitset.h"
+#include "deque.h"
+#include "epoch.h"
+#include "hash_map.h"
+#include "intrusive_stack.h"
+#include "mpmc_queue.h"
+#include "mutex.h"
+#include "object_pool.h"
+#include "parallel_algorithm.h"
+#include "rcu_sorted_vector.h"
+#include "ring_buffer.h"
+#include "sharded_counter.h"
+#include "small_vector.h"
+#include "sorted_vector.h"
+#include "soa_vector.h"
+#include "spsc_queue.h"
+#include "swmr_hash_map.h"
 #include "vector.h"
+#include "vm_vector.h"
 
 namespace
 {
@@ -158,12 +178,659 @@ float Vector_EraseString(size_t num)
 	return timer.DeltaTime();
 }
 
+// Keeps results alive, so the optimizer cant drop the loops.
+volatile int s_sink;
+
+// Lots of short-lived, short lists (typical per-entity data).
+template<class TVector>
+float Vector_SmallLists(size_t num)
+{
+	int sum(0);
+	timer.Sample();
+	for (size_t i = 0; i < num; ++i)
+	{
+		TVector v;
+		const int n = int(i & 7) + 1;
+		for (int j = 0; j < n; ++j)
+			v.push_back(j);
+		for (typename TVector::const_iterator it = v.begin(); it != v.end(); ++it)
+			sum += *it;
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+
+// FIFO work queue, vector has to use erase(begin()).
+float Queue_Vector(size_t num)
+{
+	rde::vector<int> q;
+	int sum(0);
+	timer.Sample();
+	for (size_t i = 0; i < num; ++i)
+	{
+		q.push_back(int(i));
+		q.push_back(int(i));
+		sum += q.front();
+		q.erase(q.begin());
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+float Queue_Deque(size_t num)
+{
+	rde::deque<int> q;
+	int sum(0);
+	timer.Sample();
+	for (size_t i = 0; i < num; ++i)
+	{
+		q.push_back(int(i));
+		q.push_back(int(i));
+		sum += q.front();
+		q.pop_front();
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+float Queue_RingBuffer(size_t num)
+{
+	rde::ring_buffer<int> q;
+	int sum(0);
+	timer.Sample();
+	for (size_t i = 0; i < num; ++i)
+	{
+		q.push_back(int(i));
+		q.push_back(int(i));
+		sum += q.front();
+		q.pop_front();
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+
+// Visibility mask & dirty mask, count survivors.
+float Mask_VectorBool(size_t num)
+{
+	rde::vector<bool> visible, dirty;
+	for (size_t i = 0; i < kCount; ++i)
+	{
+		visible.push_back((i & 3) != 0);
+		dirty.push_back((i % 5) == 0);
+	}
+	size_t sum(0);
+	// Every pass touches all kCount bits already.
+	num = num / 1000;
+	timer.Sample();
+	for (size_t n = 0; n < num; ++n)
+	{
+		for (size_t i = 0; i < kCount; ++i)
+		{
+			visible[i] = visible[i] && dirty[i];
+			sum += visible[i];
+		}
+	}
+	timer.Sample();
+	s_sink = int(sum);
+	return timer.DeltaTime();
+}
+float Mask_DynamicBitset(size_t num)
+{
+	rde::dynamic_bitset<> visible(kCount), dirty(kCount);
+	for (size_t i = 0; i < kCount; ++i)
+	{
+		visible.set(i, (i & 3) != 0);
+		dirty.set(i, (i % 5) == 0);
+	}
+	size_t sum(0);
+	num = num / 1000;
+	timer.Sample();
+	for (size_t n = 0; n < num; ++n)
+	{
+		visible &= dirty;
+		sum += visible.count();
+	}
+	timer.Sample();
+	s_sink = int(sum);
+	return timer.DeltaTime();
+}
+
+// Producer thread pinned to 2nd core hands num ints over to this thread
+// (pinned to 1st core by Timer).
+float Channel_MutexVector(size_t num)
+{
+	std::mutex lock;
+	rde::vector<int> shared, local;
+	int sum(0);
+	timer.Sample();
+	std::thread producer([&]()
+	{
+		for (size_t i = 0; i < num; ++i)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			shared.push_back(int(i));
+		}
+	});
+	SetThreadAffinityMask(producer.native_handle(), 2);
+	for (size_t received = 0; received < num; )
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			local.insert_range(local.end(), shared.begin(), shared.end());
+			shared.clear();
+		}
+		for (rde::vector<int>::const_iterator it = local.begin(); it != local.end(); ++it)
+			sum += *it;
+		received += local.size();
+		local.clear();
+	}
+	producer.join();
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+float Channel_SpscQueue(size_t num)
+{
+	rde::spsc_queue<int> q(1024);
+	int sum(0);
+	timer.Sample();
+	std::thread producer([&]()
+	{
+		for (size_t i = 0; i < num; )
+		{
+			if (q.try_push(int(i)))
+				++i;
+		}
+	});
+	SetThreadAffinityMask(producer.native_handle(), 2);
+	int batch[64];
+	for (size_t received = 0; received < num; )
+	{
+		const size_t n = q.pop_n(batch, 64);
+		for (size_t i = 0; i < n; ++i)
+			sum += batch[i];
+		received += n;
+	}
+	producer.join();
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+
+// Runs func(threadIndex) on TThreads threads and returns time it took.
+// Threads are started first and wait until all of them are up, so only the
+// work itself is timed (not thread creation/teardown).
+template<int TThreads, class TFunc>
+float TimeThreads(TFunc func)
+{
+	std::atomic<int> numReady(0);
+	std::atomic<int> numDone(0);
+	std::atomic<bool> go(false);
+	std::thread threads[TThreads];
+	for (int t = 0; t < TThreads; ++t)
+	{
+		threads[t] = std::thread([&, t]()
+		{
+			++numReady;
+			while (!go.load())
+				std::this_thread::yield();
+			func(t);
+			++numDone;
+		});
+	}
+	while (numReady.load() != TThreads)
+		std::this_thread::yield();
+	timer.Sample();
+	go.store(true);
+	while (numDone.load() != TThreads)
+		std::this_thread::yield();
+	timer.Sample();
+	for (int t = 0; t < TThreads; ++t)
+		threads[t].join();
+	return timer.DeltaTime();
+}
+
+// num push + pop pairs split between TThreads threads, all hammering the same queue.
+template<int TThreads, class TMutex = std::mutex>
+float Contention_MutexVector(size_t num)
+{
+	TMutex lock;
+	rde::vector<int> shared;
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			{
+				std::lock_guard<TMutex> guard(lock);
+				shared.push_back(int(i));
+			}
+			std::lock_guard<TMutex> guard(lock);
+			if (!shared.empty())
+			{
+				localSum += shared.back();
+				shared.pop_back();
+			}
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+template<int TThreads>
+float Contention_MpmcQueue(size_t num)
+{
+	rde::mpmc_queue<int> q(1024);
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			q.try_push(int(i));
+			int v;
+			if (q.try_pop(v))
+				localSum += v;
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+template<int TThreads>
+float Contention_IntrusiveStack(size_t num)
+{
+	struct Node: public rde::intrusive_slist_node
+	{
+		int	value;
+	};
+	rde::intrusive_stack<Node> s;
+	rde::vector<Node> nodes;
+	nodes.resize(TThreads);
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int t)
+	{
+		// Every thread holds one node and swaps it with whatever is on top.
+		Node* mine = &nodes[t];
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			mine->value = int(i);
+			s.push(mine);
+			mine = s.pop();
+			localSum += mine->value;
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+
+// num protected reads split between TThreads readers, while writer keeps
+// replacing shared object and retiring old ones.
+// Minimal hazard pointer scheme (one hazard pointer per reader) for comparison.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<int TThreads>
+float Reclaim_HazardPointers(size_t num)
+{
+	struct alignas(RDE_CACHE_LINE_SIZE) hazard
+	{
+		std::atomic<MyStruct*>	ptr;
+	};
+	hazard hazards[TThreads];
+	for (int t = 0; t < TThreads; ++t)
+		hazards[t].ptr = 0;
+	std::atomic<MyStruct*> shared(new MyStruct());
+	std::atomic<bool> done(false);
+	std::atomic<int> sum(0);
+	std::thread writer([&]()
+	{
+		rde::vector<MyStruct*> retired;
+		while (!done.load(std::memory_order_relaxed))
+		{
+			retired.push_back(shared.exchange(new MyStruct(), std::memory_order_acq_rel));
+			if (retired.size() >= 64)
+			{
+				for (size_t i = 0; i < retired.size(); )
+				{
+					bool inUse(false);
+					for (int t = 0; t < TThreads; ++t)
+						inUse |= (hazards[t].ptr.load(std::memory_order_seq_cst) == retired[i]);
+					if (inUse)
+						++i;
+					else
+					{
+						delete retired[i];
+						retired.erase_unordered(retired.begin() + i);
+					}
+				}
+			}
+			std::this_thread::yield();
+		}
+		for (size_t i = 0; i < retired.size(); ++i)
+			delete retired[i];
+	});
+	const float time = TimeThreads<TThreads>([&](int t)
+	{
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			MyStruct* p;
+			do
+			{
+				p = shared.load(std::memory_order_acquire);
+				hazards[t].ptr.store(p, std::memory_order_seq_cst);
+			} while (p != shared.load(std::memory_order_seq_cst));
+			localSum += p->a;
+			hazards[t].ptr.store(0, std::memory_order_release);
+		}
+		sum += localSum;
+	});
+	done = true;
+	writer.join();
+	delete shared.load();
+	s_sink = sum;
+	return time;
+}
+#pragma warning(pop)
+template<int TThreads>
+float Reclaim_Epoch(size_t num)
+{
+	typedef rde::epoch_domain<> domain_t;
+	domain_t domain;
+	std::atomic<MyStruct*> shared(new MyStruct());
+	std::atomic<bool> done(false);
+	std::atomic<int> sum(0);
+	std::thread writer([&]()
+	{
+		domain_t::participant p(domain);
+		while (!done.load(std::memory_order_relaxed))
+		{
+			p.retire(shared.exchange(new MyStruct(), std::memory_order_acq_rel));
+			std::this_thread::yield();
+		}
+	});
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		domain_t::participant p(domain);
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			domain_t::guard g(p);
+			localSum += shared.load(std::memory_order_acquire)->a;
+		}
+		sum += localSum;
+	});
+	done = true;
+	writer.join();
+	delete shared.load();
+	s_sink = sum;
+	return time;
+}
+
+// Every thread keeps allocating batches of objects and freeing them.
+template<int TThreads>
+float Alloc_New(size_t num)
+{
+	return TimeThreads<TThreads>([num](int /*t*/)
+	{
+		MyStruct* batch[64];
+		for (size_t i = 0; i < num / TThreads; i += 64)
+		{
+			for (int j = 0; j < 64; ++j)
+				batch[j] = new MyStruct();
+			for (int j = 0; j < 64; ++j)
+				delete batch[j];
+		}
+	});
+}
+template<int TThreads>
+float Alloc_ObjectPool(size_t num)
+{
+	rde::object_pool<MyStruct> pool;
+	return TimeThreads<TThreads>([num, &pool](int /*t*/)
+	{
+		MyStruct* batch[64];
+		for (size_t i = 0; i < num / TThreads; i += 64)
+		{
+			for (int j = 0; j < 64; ++j)
+				batch[j] = pool.create();
+			for (int j = 0; j < 64; ++j)
+				pool.destroy(batch[j]);
+		}
+	});
+}
+
+// num increments split between TThreads threads.
+template<int TThreads>
+float Counter_Atomic(size_t num)
+{
+	std::atomic<long long> counter(0);
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		for (size_t i = 0; i < num / TThreads; ++i)
+			counter.fetch_add(1, std::memory_order_relaxed);
+	});
+	s_sink = int(counter.load());
+	return time;
+}
+template<int TThreads>
+float Counter_Sharded(size_t num)
+{
+	rde::sharded_counter counter;
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		for (size_t i = 0; i < num / TThreads; ++i)
+			counter.increment();
+	});
+	s_sink = int(counter.value());
+	return time;
+}
+
+// num lookups split between TThreads threads, every 64th one is an update.
+template<int TThreads, class TMutex>
+float Lookup_LockedHashMap(size_t num)
+{
+	typedef rde::hash_map<int, int> tMap;
+	rde::locked<tMap, TMutex> map;
+	for (int i = 0; i < 1024; ++i)
+		(*map.lock())[i] = i;
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			const int key = int(i & 1023);
+			if ((i & 63) == 0)
+			{
+				map.with_lock([key](tMap& m) { ++m[key]; });
+				continue;
+			}
+			localSum += map.with_shared_lock([key](const tMap& m)
+			{
+				return m.find(key)->second;
+			});
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+
+// num lookups split between TThreads readers, no writer. Readers only write to
+// their own slot, so throughput should grow linearly with TThreads (up to
+// number of cores).
+template<int TThreads>
+float Lookup_SwmrHashMap(size_t num)
+{
+	typedef rde::swmr_hash_map<int, int> tMap;
+	tMap map;
+	for (int i = 0; i < 1024; ++i)
+		map.insert(i, i);
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int /*t*/)
+	{
+		tMap::reader reader(map);
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			int value(0);
+			reader.find(int(i & 1023), value);
+			localSum += value;
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+
+// Routing table: num lookups split between TThreads threads, one of them
+// also updates one entry every 4096 lookups.
+template<int TThreads>
+float Routing_SharedMutexSortedVector(size_t num)
+{
+	typedef rde::sorted_vector<int, int> tTable;
+	rde::locked<tTable, rde::shared_mutex> table;
+	for (int i = 0; i < 1024; ++i)
+		table.lock()->insert(i, i);
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int t)
+	{
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			const int key = int(i & 1023);
+			if (t == 0 && (i & 4095) == 0)
+				table.with_lock([key](tTable& tab) { ++tab.find(key)->second; });
+			localSum += table.with_shared_lock([key](const tTable& tab)
+			{
+				return tab.find(key)->second;
+			});
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+template<int TThreads>
+float Routing_RcuSortedVector(size_t num)
+{
+	typedef rde::rcu_sorted_vector<int, int> tTable;
+	tTable table;
+	tTable::update_batch batch;
+	for (int i = 0; i < 1024; ++i)
+		batch.insert(i, i);
+	table.commit(batch);
+	std::atomic<int> sum(0);
+	const float time = TimeThreads<TThreads>([&](int t)
+	{
+		tTable::reader reader(table);
+		int localSum(0);
+		for (size_t i = 0; i < num / TThreads; ++i)
+		{
+			const int key = int(i & 1023);
+			int value(0);
+			if (t == 0 && (i & 4095) == 0)
+			{
+				reader.find(key, value);
+				table.insert(key, value + 1);
+			}
+			reader.find(key, value);
+			localSum += value;
+		}
+		sum += localSum;
+	});
+	s_sink = sum;
+	return time;
+}
+
+// Hot loop touching only one field, array of structs vs struct of arrays.
+float Fields_AoS(size_t num)
+{
+	rde::vector<MyStruct> v;
+	v.resize(kCount);
+	for (size_t i = 0; i < kCount; ++i)
+		v[i].a = int(i);
+	int sum(0);
+	// Every pass touches all kCount elements already.
+	num = num / 1000;
+	timer.Sample();
+	for (size_t n = 0; n < num; ++n)
+	{
+		for (size_t i = 0; i < kCount; ++i)
+			sum += v[i].a;
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+float Fields_SoA(size_t num)
+{
+	rde::soa_vector<int, MyStruct*, float, float, float> v;
+	for (size_t i = 0; i < kCount; ++i)
+		v.push_back(int(i), 0, 0.f, 0.f, 0.f);
+	int sum(0);
+	num = num / 1000;
+	timer.Sample();
+	for (size_t n = 0; n < num; ++n)
+	{
+		const int* a = v.column_data<0>();
+		for (size_t i = 0; i < kCount; ++i)
+			sum += a[i];
+	}
+	timer.Sample();
+	s_sink = sum;
+	return timer.DeltaTime();
+}
+
+// Same algorithms, serial vs job_system executor.
+template<class TExecutor>
+float Algo_TransformReduce(size_t num)
+{
+	TExecutor exec;
+	rde::vector<float> v;
+	v.resize(num * 10);
+	for (size_t i = 0; i < v.size(); ++i)
+		v[i] = float(i & 1023);
+	timer.Sample();
+	rde::parallel_transform(exec, v.begin(), v.end(), v.begin(), [](float x) { return x * 0.5f + 1.f; });
+	const float sum = rde::parallel_reduce(exec, v.begin(), v.end(), 0.f, [](float a, float b) { return a + b; });
+	timer.Sample();
+	s_sink = int(sum);
+	return timer.DeltaTime();
+}
+template<class TExecutor>
+float Algo_Sort(size_t num)
+{
+	TExecutor exec;
+	rde::vector<int> v;
+	v.resize(num * 10);
+	unsigned int seed = 12345;
+	for (size_t i = 0; i < v.size(); ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		v[i] = int(seed >> 1);
+	}
+	timer.Sample();
+	rde::parallel_sort(exec, v.begin(), v.end());
+	timer.Sample();
+	s_sink = v[0];
+	return timer.DeltaTime();
+}
+
 SpeedTest s_tests[] =
 {
 	{ "STL vector: construction", Vector_Construct<std::vector<std::string> > },
 	{ "RDE vector: construction", Vector_Construct<rde::vector<std::string> > },
 	{ "STL vector: push_back", Vector_PushBack<std::vector<std::string> > },
 	{ "RDE vector: push_back", Vector_PushBack<rde::vector<std::string> > },
+	{ "RDE vm_vector: push_back", Vector_PushBack<rde::vm_vector<std::string> > },
 	{ "STL vector: insert int", Vector_InsertInt<std::vector<int> > },
 	{ "RDE vector: insert int", Vector_InsertInt<rde::vector<int> > },
 	{ "STL vector: insert POD", Vector_InsertPOD<std::vector<MyStruct> > },
@@ -172,6 +839,91 @@ SpeedTest s_tests[] =
 	{ "RDE vector: erase POD", Vector_ErasePOD<rde::vector<MyStruct> > },
 	{ "STL vector: erase string", Vector_EraseString<std::vector<std::string> > },
 	{ "RDE vector: erase string", Vector_EraseString<rde::vector<std::string> > },
+	{ "RDE vector: small lists", Vector_SmallLists<rde::vector<int> > },
+	{ "RDE vector: queue", Queue_Vector },
+	{ "RDE deque: queue", Queue_Deque },
+	{ "RDE ring_buffer: queue", Queue_RingBuffer },
+	{ "mutex + RDE vector: producer/consumer", Channel_MutexVector },
+	{ "RDE spsc_queue: producer/consumer", Channel_SpscQueue },
+	{ "mutex + RDE vector: 1 thread", Contention_MutexVector<1> },
+	{ "RDE spin_mutex + RDE vector: 1 thread", Contention_MutexVector<1, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 1 thread", Contention_MutexVector<1, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 1 thread", Contention_MpmcQueue<1> },
+	{ "RDE intrusive_stack: 1 thread", Contention_IntrusiveStack<1> },
+	{ "mutex + RDE vector: 2 threads", Contention_MutexVector<2> },
+	{ "RDE spin_mutex + RDE vector: 2 threads", Contention_MutexVector<2, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 2 threads", Contention_MutexVector<2, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 2 threads", Contention_MpmcQueue<2> },
+	{ "RDE intrusive_stack: 2 threads", Contention_IntrusiveStack<2> },
+	{ "mutex + RDE vector: 4 threads", Contention_MutexVector<4> },
+	{ "RDE spin_mutex + RDE vector: 4 threads", Contention_MutexVector<4, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 4 threads", Contention_MutexVector<4, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 4 threads", Contention_MpmcQueue<4> },
+	{ "RDE intrusive_stack: 4 threads", Contention_IntrusiveStack<4> },
+	{ "mutex + RDE vector: 8 threads", Contention_MutexVector<8> },
+	{ "RDE spin_mutex + RDE vector: 8 threads", Contention_MutexVector<8, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 8 threads", Contention_MutexVector<8, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 8 threads", Contention_MpmcQueue<8> },
+	{ "RDE intrusive_stack: 8 threads", Contention_IntrusiveStack<8> },
+	{ "mutex + RDE vector: 16 threads", Contention_MutexVector<16> },
+	{ "RDE spin_mutex + RDE vector: 16 threads", Contention_MutexVector<16, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 16 threads", Contention_MutexVector<16, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 16 threads", Contention_MpmcQueue<16> },
+	{ "RDE intrusive_stack: 16 threads", Contention_IntrusiveStack<16> },
+	{ "mutex + RDE vector: 32 threads", Contention_MutexVector<32> },
+	{ "RDE spin_mutex + RDE vector: 32 threads", Contention_MutexVector<32, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 32 threads", Contention_MutexVector<32, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 32 threads", Contention_MpmcQueue<32> },
+	{ "RDE intrusive_stack: 32 threads", Contention_IntrusiveStack<32> },
+	{ "mutex + RDE vector: 64 threads", Contention_MutexVector<64> },
+	{ "RDE spin_mutex + RDE vector: 64 threads", Contention_MutexVector<64, rde::spin_mutex> },
+	{ "RDE adaptive_mutex + RDE vector: 64 threads", Contention_MutexVector<64, rde::adaptive_mutex> },
+	{ "RDE mpmc_queue: 64 threads", Contention_MpmcQueue<64> },
+	{ "RDE intrusive_stack: 64 threads", Contention_IntrusiveStack<64> },
+	{ "hazard pointers: 1 reader", Reclaim_HazardPointers<1> },
+	{ "RDE epoch_domain: 1 reader", Reclaim_Epoch<1> },
+	{ "hazard pointers: 4 readers", Reclaim_HazardPointers<4> },
+	{ "RDE epoch_domain: 4 readers", Reclaim_Epoch<4> },
+	{ "hazard pointers: 16 readers", Reclaim_HazardPointers<16> },
+	{ "RDE epoch_domain: 16 readers", Reclaim_Epoch<16> },
+	{ "new/delete: 1 thread", Alloc_New<1> },
+	{ "RDE object_pool: 1 thread", Alloc_ObjectPool<1> },
+	{ "new/delete: 4 threads", Alloc_New<4> },
+	{ "RDE object_pool: 4 threads", Alloc_ObjectPool<4> },
+	{ "std::atomic counter: 1 thread", Counter_Atomic<1> },
+	{ "RDE sharded_counter: 1 thread", Counter_Sharded<1> },
+	{ "std::atomic counter: 4 threads", Counter_Atomic<4> },
+	{ "RDE sharded_counter: 4 threads", Counter_Sharded<4> },
+	{ "std::atomic counter: 16 threads", Counter_Atomic<16> },
+	{ "RDE sharded_counter: 16 threads", Counter_Sharded<16> },
+	{ "RDE locked<hash_map, adaptive_mutex>: 1 thread", Lookup_LockedHashMap<1, rde::adaptive_mutex> },
+	{ "RDE locked<hash_map, shared_mutex>: 1 thread", Lookup_LockedHashMap<1, rde::shared_mutex> },
+	{ "RDE locked<hash_map, adaptive_mutex>: 4 threads", Lookup_LockedHashMap<4, rde::adaptive_mutex> },
+	{ "RDE locked<hash_map, shared_mutex>: 4 threads", Lookup_LockedHashMap<4, rde::shared_mutex> },
+	{ "RDE locked<hash_map, adaptive_mutex>: 16 threads", Lookup_LockedHashMap<16, rde::adaptive_mutex> },
+	{ "RDE locked<hash_map, shared_mutex>: 16 threads", Lookup_LockedHashMap<16, rde::shared_mutex> },
+	{ "RDE swmr_hash_map: 1 reader", Lookup_SwmrHashMap<1> },
+	{ "RDE swmr_hash_map: 2 readers", Lookup_SwmrHashMap<2> },
+	{ "RDE swmr_hash_map: 4 readers", Lookup_SwmrHashMap<4> },
+	{ "RDE swmr_hash_map: 8 readers", Lookup_SwmrHashMap<8> },
+	{ "RDE swmr_hash_map: 16 readers", Lookup_SwmrHashMap<16> },
+	{ "RDE locked<sorted_vector, shared_mutex>: routing, 1 thread", Routing_SharedMutexSortedVector<1> },
+	{ "RDE rcu_sorted_vector: routing, 1 thread", Routing_RcuSortedVector<1> },
+	{ "RDE locked<sorted_vector, shared_mutex>: routing, 4 threads", Routing_SharedMutexSortedVector<4> },
+	{ "RDE rcu_sorted_vector: routing, 4 threads", Routing_RcuSortedVector<4> },
+	{ "RDE locked<sorted_vector, shared_mutex>: routing, 16 threads", Routing_SharedMutexSortedVector<16> },
+	{ "RDE rcu_sorted_vector: routing, 16 threads", Routing_RcuSortedVector<16> },
+	{ "RDE small_vector<4>: small lists", Vector_SmallLists<rde::small_vector<int, 4> > },
+	{ "RDE small_vector<8>: small lists", Vector_SmallLists<rde::small_vector<int, 8> > },
+	{ "RDE small_vector<16>: small lists", Vector_SmallLists<rde::small_vector<int, 16> > },
+	{ "RDE vector<MyStruct>: sum one field", Fields_AoS },
+	{ "RDE soa_vector: sum one field", Fields_SoA },
+	{ "RDE vector<bool>: and + count", Mask_VectorBool },
+	{ "RDE dynamic_bitset: and + count", Mask_DynamicBitset },
+	{ "RDE serial: transform + reduce", Algo_TransformReduce<rde::serial_executor> },
+	{ "RDE job_system: transform + reduce", Algo_TransformReduce<rde::job_system> },
+	{ "RDE serial: sort", Algo_Sort<rde::serial_executor> },
+	{ "RDE job_system: sort", Algo_Sort<rde::job_system> },
 };
 const size_t kNumTests = sizeof(s_tests) / sizeof(s_tests[0]);
 
@@ -0,0 +1,104 @@
+#include "spsc_queue.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+#include <thread>
+
+namespace
+{
+TEST_CASE("spsc_queue", "[spsc_queue]")
+{
+	SECTION("Capacity")
+	{
+		rde::spsc_queue<int> q(100);
+		CHECK(128 == q.capacity());
+		rde::spsc_queue<int, 16> f;
+		CHECK(16 == f.capacity());
+		CHECK(f.empty_approx());
+	}
+	SECTION("PushPop")
+	{
+		rde::spsc_queue<int, 4> q;
+		for (int i = 0; i < 4; ++i)
+			CHECK(q.try_push(i));
+		CHECK(!q.try_push(4));
+		CHECK(4 == q.size_approx());
+		int v;
+		CHECK(q.try_pop(v));
+		CHECK(0 == v);
+		CHECK(q.try_push(4));
+		for (int i = 1; i < 5; ++i)
+		{
+			CHECK(q.try_pop(v));
+			CHECK(i == v);
+		}
+		CHECK(!q.try_pop(v));
+	}
+	SECTION("Batch")
+	{
+		rde::spsc_queue<int> q(8);
+		const int values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		CHECK(5 == q.push_n(values, 5));
+		int out[10];
+		CHECK(2 == q.pop_n(out, 2));
+		CHECK(1 == out[1]);
+		// Wraps around.
+		CHECK(5 == q.push_n(values + 5, 5));
+		CHECK(8 == q.push_n(values, 10) + q.size_approx());
+		CHECK(8 == q.pop_n(out, 10));
+		CHECK(2 == out[0]);
+		CHECK(9 == out[7]);
+		CHECK(0 == q.pop_n(out, 10));
+	}
+	SECTION("NonPod")
+	{
+		rde::spsc_queue<std::string> q(4);
+		CHECK(q.try_emplace("hello"));
+		CHECK(q.try_push(std::string("world")));
+		std::string s;
+		CHECK(q.try_pop(s));
+		CHECK("hello" == s);
+		// "world" is destroyed with the queue.
+	}
+	SECTION("ProducerConsumer")
+	{
+		const int kNumItems = 200000;
+		rde::spsc_queue<int> q(256);
+		std::thread producer([&]()
+		{
+			int batch[16];
+			for (int i = 0; i < kNumItems; )
+			{
+				if (i % 3 == 0)
+				{
+					int n = 0;
+					for (; n < 16 && i + n < kNumItems; ++n)
+						batch[n] = i + n;
+					i += int(q.push_n(batch, size_t(n)));
+				}
+				else if (q.try_push(i))
+				{
+					++i;
+				}
+			}
+		});
+		long long sum(0);
+		int expected(0);
+		bool inOrder(true);
+		int out[32];
+		while (expected < kNumItems)
+		{
+			const size_t n = q.pop_n(out, 32);
+			for (size_t i = 0; i < n; ++i)
+			{
+				inOrder &= (out[i] == expected++);
+				sum += out[i];
+			}
+		}
+		producer.join();
+		CHECK(inOrder);
+		CHECK(sum == (long long)kNumItems * (kNumItems - 1) / 2);
+		CHECK(q.empty_approx());
+	}
+}
+
+}
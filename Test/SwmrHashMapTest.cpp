@@ -0,0 +1,150 @@
+#include <atomic>
+#include <thread>
+#include "swmr_hash_map.h"
+#include "vendor/Catch/catch.hpp"
+
+namespace
+{
+typedef rde::swmr_hash_map<int, int> tMap;
+
+struct Point
+{
+	int	x, y;
+};
+
+TEST_CASE("swmr_hash_map", "[map]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tMap m;
+		CHECK(m.empty());
+		CHECK(0 == m.size());
+		tMap::reader r(m);
+		int v(0);
+		CHECK(!r.find(5, v));
+	}
+	SECTION("InsertFind")
+	{
+		tMap m;
+		tMap::reader r(m);
+		CHECK(m.insert(1, 10));
+		CHECK(m.insert(2, 20));
+		CHECK(2 == m.size());
+		int v(0);
+		CHECK(r.find(1, v));
+		CHECK(10 == v);
+		CHECK(r.find(2, v));
+		CHECK(20 == v);
+		CHECK(!r.contains(3));
+	}
+	SECTION("InsertOverwrites")
+	{
+		tMap m;
+		tMap::reader r(m);
+		CHECK(m.insert(1, 10));
+		CHECK(!m.insert(1, 11));
+		CHECK(1 == m.size());
+		int v(0);
+		CHECK(r.find(1, v));
+		CHECK(11 == v);
+	}
+	SECTION("Erase")
+	{
+		tMap m;
+		tMap::reader r(m);
+		m.insert(1, 10);
+		m.insert(2, 20);
+		CHECK(m.erase(1));
+		CHECK(!m.erase(1));
+		CHECK(1 == m.size());
+		CHECK(!r.contains(1));
+		CHECK(r.contains(2));
+		m.insert(1, 12);
+		int v(0);
+		CHECK(r.find(1, v));
+		CHECK(12 == v);
+	}
+	SECTION("GrowAndReclaim")
+	{
+		tMap m;
+		const tMap::size_type initialBuckets = m.bucket_count();
+		for (int i = 0; i < 1000; ++i)
+			m.insert(i, i * 2);
+		CHECK(1000 == m.size());
+		CHECK(m.bucket_count() > initialBuckets);
+		// No reader inside of lookup, everything should have been freed already.
+		CHECK(0 == m.retired_count());
+		tMap::reader r(m);
+		int numFound(0);
+		for (int i = 0; i < 1000; ++i)
+		{
+			int v(-1);
+			if (r.find(i, v) && v == i * 2)
+				++numFound;
+		}
+		CHECK(1000 == numFound);
+	}
+	SECTION("TriviallyCopyableStruct")
+	{
+		rde::swmr_hash_map<int, Point> m;
+		rde::swmr_hash_map<int, Point>::reader r(m);
+		const Point p = { 1, 2 };
+		m.insert(5, p);
+		Point out = { 0, 0 };
+		CHECK(r.find(5, out));
+		CHECK(1 == out.x);
+		CHECK(2 == out.y);
+	}
+	SECTION("Clear")
+	{
+		tMap m;
+		tMap::reader r(m);
+		for (int i = 0; i < 100; ++i)
+			m.insert(i, i);
+		m.clear();
+		CHECK(m.empty());
+		CHECK(!r.contains(5));
+		m.insert(5, 5);
+		CHECK(r.contains(5));
+	}
+	SECTION("ConcurrentReaders")
+	{
+		// Keys [0, 1000) are always there, writer keeps growing/erasing around them.
+		tMap m;
+		for (int i = 0; i < 1000; ++i)
+			m.insert(i, i);
+
+		std::atomic<bool> done(false);
+		std::atomic<int> numErrors(0);
+		std::thread readers[3];
+		for (int t = 0; t < 3; ++t)
+		{
+			readers[t] = std::thread([&]()
+			{
+				tMap::reader r(m);
+				while (!done.load())
+				{
+					for (int i = 0; i < 1000; ++i)
+					{
+						int v(-1);
+						if (!r.find(i, v) || v != i)
+							++numErrors;
+					}
+				}
+			});
+		}
+		for (int i = 1000; i < 100000; ++i)
+		{
+			m.insert(i, i);
+			if ((i & 3) == 0 && i > 1000)
+				m.erase(i - 1);
+		}
+		done.store(true);
+		for (int t = 0; t < 3; ++t)
+			readers[t].join();
+		m.reclaim();
+		CHECK(0 == numErrors.load());
+		CHECK(0 == m.retired_count());
+	}
+}
+} // namespace
@@ -23,6 +23,8 @@ int __cdecl main(int argc, const char* argv[])
 #if SPEED_TEST
 	void Map_SpeedTest();
 	Map_SpeedTest();
+	void ExternalHashMap_SpeedTest();
+	ExternalHashMap_SpeedTest();
 #endif
 
 	int result = Catch::Session().run(argc, argv);
@@ -1,5 +1,7 @@
 //#include <cstdio>
 #include "vector.h"
+#include "buffer_allocator.h"
+#include "fixed_vector.h"
 #include "pair.h"
 #include "vendor/Catch/catch.hpp"
 
@@ -10,9 +12,29 @@ struct MyStruct
 	float f;
 };
 
+// Owns heap memory, so not trivially copyable, but safe to memcpy around.
+struct MyHandle
+{
+	static int	s_numCopies;
+
+	explicit MyHandle(int v): value(new int(v)) {}
+	MyHandle(const MyHandle& rhs): value(new int(*rhs.value)) { ++s_numCopies; }
+	~MyHandle() { delete value; }
+	MyHandle& operator=(const MyHandle& rhs)
+	{
+		*value = *rhs.value;
+		++s_numCopies;
+		return *this;
+	}
+
+	int*	value;
+};
+int MyHandle::s_numCopies = 0;
+
 namespace rde
 {
 template<> struct is_pod<MyStruct> { enum { value = true }; };
+template<> struct is_trivially_relocatable<MyHandle> { enum { value = true }; };
 }
 
 namespace
@@ -22,6 +44,28 @@ typedef rde::vector<std::string>	tStringVector;
 
 const int array[] ={ 1, 4, 9, 16, 25, 36 };
 
+// Remembers size of every block, counts deallocations with different size.
+struct sized_allocator
+{
+	static int	s_numWrongSizes;
+
+	void* allocate(size_t bytes, int /*flags*/ = 0)
+	{
+		size_t* p = static_cast<size_t*>(rde::allocator().allocate(bytes + sizeof(double)));
+		*p = bytes;
+		return reinterpret_cast<char*>(p) + sizeof(double);
+	}
+	void deallocate(void* ptr, size_t bytes)
+	{
+		size_t* p = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - sizeof(double));
+		if (*p != bytes)
+			++s_numWrongSizes;
+		rde::allocator().deallocate(p, *p + sizeof(double));
+	}
+	const char* get_name() const	{ return "SIZED"; }
+};
+int sized_allocator::s_numWrongSizes = 0;
+
 void PrintVector(const tTestVector& v)
 {
 	for (tTestVector::const_iterator it = v.begin(); it != v.end(); ++it)
@@ -384,6 +428,173 @@ TEST_CASE("vector", "[vector]")
 		CHECK(myFoosFoos[1].size() == 20);
 	}
 
+	SECTION("VectorOfVectorsGrow")
+	{
+		CHECK(rde::is_trivially_relocatable<rde::vector<int> >::value);
+		rde::vector< rde::vector<int> > v;
+		for (int i = 0; i < 100; ++i)
+			v.push_back(rde::vector<int>(i));
+		v.erase(v.begin() + 10, v.begin() + 20);
+		v.emplace(v.begin(), 5);
+		CHECK(91 == v.size());
+		CHECK(5 == v[0].size());
+		CHECK(0 == v[1].size());
+		CHECK(20 == v[11].size());
+		CHECK(99 == v.back().size());
+	}
+	SECTION("InsertOwnElement")
+	{
+		rde::vector< rde::vector<int> > v;
+		v.reserve(8);
+		for (int i = 1; i < 4; ++i)
+			v.push_back(rde::vector<int>(i));
+		v.insert(0, 1, v[0]);
+		v.insert(v.begin(), v[1]);
+		v.emplace(v.begin(), v[2]);
+		CHECK(6 == v.size());
+		for (int i = 0; i < 4; ++i)
+			CHECK(1 == v[i].size());
+		CHECK(2 == v[4].size());
+		// Reallocates.
+		v.insert(0, v.capacity(), v[5]);
+		CHECK(3 == v[0].size());
+		CHECK(3 == v[v.size() - 1].size());
+	}
+	SECTION("RelocatableNoCopies")
+	{
+		MyHandle::s_numCopies = 0;
+		rde::vector<MyHandle> v;
+		for (int i = 0; i < 100; ++i)
+			v.emplace_back(i);
+		v.emplace(v.begin(), -1);
+		v.erase(v.begin() + 1);
+		v.erase(v.begin() + 10, v.begin() + 20);
+		CHECK(0 == MyHandle::s_numCopies);
+		CHECK(90 == v.size());
+		CHECK(-1 == *v[0].value);
+		CHECK(1 == *v[1].value);
+		CHECK(20 == *v[10].value);
+		CHECK(99 == *v.back().value);
+	}
+	SECTION("GrowthPolicy")
+	{
+		rde::vector<int, rde::allocator, rde::standard_vector_storage<int, rde::allocator>,
+			rde::vector_growth_one_and_half> v;
+		for (int i = 0; i < 17; ++i)
+			v.push_back(i);
+		CHECK(24 == v.capacity());
+
+		rde::vector<int, rde::allocator, rde::standard_vector_storage<int, rde::allocator>,
+			rde::vector_growth_page_rounded<4096> > v2;
+		v2.resize(1500);
+		CHECK(2048 == v2.capacity());
+		v2.resize(2049);
+		CHECK(4096 == v2.capacity());
+		v2.reserve(4097);
+		v2.resize(5000);
+		CHECK(0 == (v2.capacity() * sizeof(int)) % 4096);
+	}
+	SECTION("ExpandInPlace")
+	{
+		char buffer[4096];
+		rde::buffer_allocator alloc("vec", buffer, sizeof(buffer));
+		rde::vector<int, rde::buffer_allocator> v(alloc);
+		v.push_back(0);
+		const int* data = v.begin();
+		for (int i = 1; i < 500; ++i)
+			v.push_back(i);
+		// Only allocation from the buffer, grows without moving.
+		CHECK(data == v.begin());
+		CHECK(v.capacity() >= 500);
+		for (int i = 0; i < 500; ++i)
+			CHECK(i == v[i]);
+	}
+	SECTION("DeallocateWithCapacity")
+	{
+		sized_allocator::s_numWrongSizes = 0;
+		{
+			rde::vector<int, sized_allocator> v;
+			v.reserve(100);
+			v.push_back(1);
+			// Grow with size < capacity.
+			v.reserve(200);
+			rde::vector<int, sized_allocator> v2;
+			v2.reserve(50);
+			v2.push_back(2);
+			v2.reset();
+			v2.reserve(10);
+			v2.push_back(3);
+			v2.push_back(4);
+
+			rde::fixed_vector<int, 4, true, sized_allocator> fv;
+			for (int i = 0; i < 10; ++i)
+				fv.push_back(i);
+			fv.reserve(100);
+		}
+		CHECK(0 == sized_allocator::s_numWrongSizes);
+	}
+	SECTION("MallocReallocate")
+	{
+		rde::vector<MyHandle, rde::malloc_allocator> v;
+		MyHandle::s_numCopies = 0;
+		for (int i = 0; i < 1000; ++i)
+			v.emplace_back(i);
+		CHECK(0 == MyHandle::s_numCopies);
+		CHECK(1000 == v.size());
+		CHECK(999 == *v.back().value);
+	}
+	SECTION("ResizeDefaultInit")
+	{
+		tTestVector v;
+		v.push_back(1);
+		v.resize_default_init(1000);
+		CHECK(1000 == v.size());
+		CHECK(1 == v[0]);
+		v.resize_default_init(2);
+		CHECK(2 == v.size());
+
+		tStringVector sv;
+		sv.resize_default_init(3);
+		CHECK(3 == sv.size());
+		CHECK(sv[2].empty());
+	}
+	SECTION("AppendUninitialized")
+	{
+		tTestVector v(array, array + 2);
+		int* p = v.append_uninitialized(4);
+		CHECK(6 == v.size());
+		CHECK(p == v.begin() + 2);
+		for (int i = 2; i < 6; ++i)
+			*p++ = array[i];
+		CHECK(0 == memcmp(array, v.data(), sizeof(array)));
+	}
+	SECTION("InsertRange")
+	{
+		tTestVector v(array, array + 2);
+		v.insert_range(v.end(), array + 4, array + 6);
+		v.insert_range(v.begin() + 2, array + 2, array + 4);
+		CHECK(6 == v.size());
+		CHECK(0 == memcmp(array, v.data(), sizeof(array)));
+
+		const std::string strings[] = { "a", "b", "c", "d", "e", "f" };
+		tStringVector sv;
+		sv.insert_range(sv.begin(), strings + 3, strings + 4);
+		// Inserted range longer than tail.
+		sv.insert_range(sv.begin(), strings, strings + 3);
+		// Inserted range shorter than tail.
+		sv.insert_range(sv.end(), strings + 5, strings + 6);
+		sv.insert_range(sv.begin() + 4, strings + 4, strings + 5);
+		CHECK(6 == sv.size());
+		for (int i = 0; i < 6; ++i)
+			CHECK(strings[i] == sv[i]);
+		tStringVector sv2;
+		sv2.insert_range(sv2.begin(), strings + 4, strings + 6);
+		sv2.reserve(100);
+		sv2.insert_range(sv2.begin(), strings + 1, strings + 4);
+		sv2.insert_range(sv2.begin(), strings, strings + 1);
+		for (int i = 0; i < 6; ++i)
+			CHECK(strings[i] == sv2[i]);
+	}
 	SECTION("MoveConstructorExplicit")
 	{
 		rde::vector<int> v;
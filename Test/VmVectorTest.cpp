@@ -0,0 +1,94 @@
+#include "vm_vector.h"
+#include "vendor/Catch/catch.hpp"
+#include <string>
+
+namespace
+{
+typedef rde::vm_vector<int, 64 * 1024 * 1024>			tTestVector;
+typedef rde::vm_vector<std::string, 16 * 1024 * 1024>	tStringVector;
+
+TEST_CASE("vm_vector", "[vector]")
+{
+	SECTION("DefaultCtorEmpty")
+	{
+		tTestVector v;
+		CHECK(v.empty());
+		CHECK(0 == v.size());
+		CHECK(0 == v.capacity());
+		CHECK(v.begin() == v.end());
+	}
+	SECTION("GrowthNeverMoves")
+	{
+		tTestVector v;
+		v.push_back(0);
+		const int* data = v.begin();
+		for (int i = 1; i < 1000000; ++i)
+			v.push_back(i);
+		CHECK(data == v.begin());
+		CHECK(1000000 == v.size());
+		int numOk(0);
+		for (int i = 0; i < 1000000; ++i)
+			numOk += (v[i] == i);
+		CHECK(1000000 == numOk);
+	}
+	SECTION("ResizeAndShrink")
+	{
+		tTestVector v;
+		v.resize(100000);
+		CHECK(v.capacity() >= 100000);
+		const int* data = v.begin();
+		v[99999] = 5;
+		v.resize(10);
+		v.shrink_to_fit();
+		CHECK(data == v.begin());
+		CHECK(10 == v.size());
+		CHECK(v.capacity() < 100000);
+		// Decommitted pages come back zeroed and usable (default init doesn't
+		// touch ints, so zero has to come from fresh pages).
+		v.resize_default_init(100000);
+		CHECK(0 == v[99999]);
+		CHECK(data == v.begin());
+	}
+	SECTION("Strings")
+	{
+		tStringVector v;
+		for (int i = 0; i < 10000; ++i)
+			v.push_back(std::to_string(i));
+		v.erase(v.begin(), v.begin() + 5000);
+		CHECK(5000 == v.size());
+		CHECK("5000" == v[0]);
+		v.shrink_to_fit();
+		CHECK("9999" == v.back());
+	}
+	SECTION("CopyAndMove")
+	{
+		tTestVector v;
+		for (int i = 0; i < 100; ++i)
+			v.push_back(i);
+		tTestVector v2(v);
+		CHECK(100 == v2.size());
+		CHECK(99 == v2[99]);
+		const int* data = v.begin();
+		tTestVector v3(std::move(v));
+		CHECK(data == v3.begin());
+		CHECK(v.empty());
+		v.push_back(1);
+		CHECK(1 == v[0]);
+	}
+	SECTION("MaxSize")
+	{
+		CHECK(16 * 1024 * 1024 == tTestVector::max_size());
+	}
+	SECTION("FillToMaxSize")
+	{
+		// Growth step is cut at the end of reserved range, last elements still fit.
+		typedef rde::vm_vector<int, 1024 * 1024> tSmallVector;
+		tSmallVector v;
+		for (size_t i = 0; i < tSmallVector::max_size(); ++i)
+			v.push_back(int(i));
+		CHECK(tSmallVector::max_size() == v.size());
+		CHECK(tSmallVector::max_size() == v.capacity());
+		CHECK(int(tSmallVector::max_size() - 1) == v.back());
+	}
+}
+} // namespace
@@ -68,6 +68,22 @@ void move_construct_n(T* first, size_t n, T* result)
 	internal::move_construct_n(first, n, result, int_to_type<has_trivial_copy<T>::value>());
 }
 
+//-----------------------------------------------------------------------------
+// Moves n objects to uninitialized memory, originals are dead afterwards
+// (no need to destruct them). Plain memcpy for trivially relocatable types.
+template<typename T>
+void relocate_n(T* first, size_t n, T* result)
+{
+	internal::relocate_n(first, n, result, int_to_type<is_trivially_relocatable<T>::value>());
+}
+
+//-----------------------------------------------------------------------------
+template<typename T> RDE_FORCEINLINE
+void relocate(T* mem, T* from)
+{
+	internal::relocate(mem, from, int_to_type<is_trivially_relocatable<T>::value>());
+}
+
 //-----------------------------------------------------------------------------
 template<typename T>
 void move_n(const T* from, size_t n, T* result)
@@ -108,6 +124,16 @@ void construct_n(T* first, size_t n)
 	internal::construct_n(first, n, int_to_type<has_trivial_constructor<T>::value>());
 }
 
+//-----------------------------------------------------------------------------
+// Default-initialization, ie. types with trivial ctor are left uninitialized
+// (construct_n value-initializes them if they're not known PODs).
+template<typename T>
+void default_construct_n(T* first, size_t n)
+{
+	internal::default_construct_n(first, n,
+		int_to_type<has_trivial_constructor<T>::value || std::is_trivially_default_constructible<T>::value>());
+}
+
 //-----------------------------------------------------------------------------
 template<typename T>
 void destruct_n(T* first, size_t n)
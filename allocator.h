@@ -1,10 +1,21 @@
 #ifndef RDESTL_ALLOCATOR_H
 #define RDESTL_ALLOCATOR_H
 
+#include <cstdlib>
+#include "int_to_type.h"
+#include "rdestl_common.h"
+#include "type_traits.h"
+
 namespace rde
 {
 
 // CONCEPT!
+// Optional hooks, containers detect them (see allocator_try_expand/allocator_reallocate):
+//	bool try_expand(void* ptr, size_t oldBytes, size_t newBytes)
+//		grows block in place, returns false if it cannot (block untouched then).
+//	void* reallocate(void* ptr, size_t oldBytes, size_t newBytes)
+//		realloc-like, contents may be moved bitwise. Returns 0 on failure
+//		(old block stays valid then).
 class allocator
 {
 public:
@@ -37,6 +48,8 @@ inline bool operator!=(const allocator& lhs, const allocator& rhs)
 	return !(lhs == rhs);
 }
 
+template<> struct is_trivially_relocatable<allocator> { enum { value = true }; };
+
 inline void* allocator::allocate(unsigned int bytes, int)
 {
 	return operator new(bytes);
@@ -47,6 +60,99 @@ inline void allocator::deallocate(void* ptr, unsigned int)
 	operator delete(ptr);
 }
 
+//=============================================================================
+// Allocator on top of malloc/free, supports reallocate hook.
+// (CRT realloc can often grow big blocks without copying, e.g. with mremap).
+class malloc_allocator
+{
+public:
+	explicit malloc_allocator(const char* name = "MALLOC"): m_name(name) {}
+
+	void* allocate(size_t bytes, int /*flags*/ = 0)
+	{
+		return std::malloc(bytes);
+	}
+	void deallocate(void* ptr, size_t /*bytes*/)
+	{
+		std::free(ptr);
+	}
+	void* reallocate(void* ptr, size_t /*oldBytes*/, size_t newBytes)
+	{
+		return std::realloc(ptr, newBytes);
+	}
+
+	const char* get_name() const { return m_name; }
+
+private:
+	const char*	m_name;
+};
+
+inline bool operator==(const malloc_allocator&, const malloc_allocator&)
+{
+	return true;
+}
+inline bool operator!=(const malloc_allocator&, const malloc_allocator&)
+{
+	return false;
+}
+
+//=============================================================================
+namespace internal
+{
+	template<class TAllocator>
+	struct has_try_expand
+	{
+		template<typename U> static char test(decltype(&U::try_expand));
+		template<typename U> static int test(...);
+		enum { value = sizeof(test<TAllocator>(0)) == sizeof(char) };
+	};
+	template<class TAllocator>
+	struct has_reallocate
+	{
+		template<typename U> static char test(decltype(&U::reallocate));
+		template<typename U> static int test(...);
+		enum { value = sizeof(test<TAllocator>(0)) == sizeof(char) };
+	};
+
+	template<class TAllocator> RDE_FORCEINLINE
+	bool try_expand(TAllocator& allocator, void* ptr, size_t oldBytes, size_t newBytes, int_to_type<true>)
+	{
+		return allocator.try_expand(ptr, oldBytes, newBytes);
+	}
+	template<class TAllocator> RDE_FORCEINLINE
+	bool try_expand(TAllocator&, void*, size_t, size_t, int_to_type<false>)
+	{
+		return false;
+	}
+
+	template<class TAllocator> RDE_FORCEINLINE
+	void* reallocate(TAllocator& allocator, void* ptr, size_t oldBytes, size_t newBytes, int_to_type<true>)
+	{
+		return allocator.reallocate(ptr, oldBytes, newBytes);
+	}
+	template<class TAllocator> RDE_FORCEINLINE
+	void* reallocate(TAllocator&, void*, size_t, size_t, int_to_type<false>)
+	{
+		return 0;
+	}
+} // namespace internal
+
+// Tries to grow block in place. Always fails for allocators without try_expand.
+template<class TAllocator> RDE_FORCEINLINE
+bool allocator_try_expand(TAllocator& allocator, void* ptr, size_t oldBytes, size_t newBytes)
+{
+	return internal::try_expand(allocator, ptr, oldBytes, newBytes,
+		int_to_type<internal::has_try_expand<TAllocator>::value>());
+}
+// Reallocates block, contents are moved bitwise. Returns 0 if allocator has no
+// reallocate hook or it failed.
+template<class TAllocator> RDE_FORCEINLINE
+void* allocator_reallocate(TAllocator& allocator, void* ptr, size_t oldBytes, size_t newBytes)
+{
+	return internal::reallocate(allocator, ptr, oldBytes, newBytes,
+		int_to_type<internal::has_reallocate<TAllocator>::value>());
+}
+
 } // namespace rde
 
 //-----------------------------------------------------------------------------
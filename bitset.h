@@ -0,0 +1,441 @@
+#ifndef RDESTL_BITSET_H
+#define RDESTL_BITSET_H
+
+#include "vector.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#	define RDE_BITSET_AVX2	1
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#		define RDE_TARGET_AVX2
+#	else
+#		define RDE_TARGET_AVX2	__attribute__((target("avx2")))
+#	endif
+#else
+#	define RDE_BITSET_AVX2	0
+#endif
+
+namespace rde
+{
+namespace internal
+{
+	typedef std::uint64_t	bitset_word;
+	static const size_t		kBitsPerWord = 64;
+
+	RDE_FORCEINLINE size_t popcount64(bitset_word w)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return size_t(__popcnt64(w));
+#elif defined(_MSC_VER)
+		w = w - ((w >> 1) & 0x5555555555555555ull);
+		w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+		w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return size_t((w * 0x0101010101010101ull) >> 56);
+#else
+		return size_t(__builtin_popcountll(w));
+#endif
+	}
+	// Index of lowest set bit, w != 0.
+	RDE_FORCEINLINE size_t ctz64(bitset_word w)
+	{
+		RDE_ASSERT(w != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, w);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(w)))
+			return index;
+		_BitScanForward(&index, static_cast<unsigned long>(w >> 32));
+		return index + 32;
+#else
+		return size_t(__builtin_ctzll(w));
+#endif
+	}
+
+	inline size_t count_bits(const bitset_word* words, size_t numWords)
+	{
+		size_t n(0);
+		for (size_t i = 0; i < numWords; ++i)
+			n += popcount64(words[i]);
+		return n;
+	}
+	// First set bit >= from, or numBits.
+	inline size_t find_next_bit(const bitset_word* words, size_t numBits, size_t from)
+	{
+		if (from >= numBits)
+			return numBits;
+		const size_t numWords = (numBits + kBitsPerWord - 1) / kBitsPerWord;
+		size_t wordIndex = from / kBitsPerWord;
+		bitset_word w = words[wordIndex] & (~bitset_word(0) << (from % kBitsPerWord));
+		while (w == 0)
+		{
+			if (++wordIndex == numWords)
+				return numBits;
+			w = words[wordIndex];
+		}
+		return wordIndex * kBitsPerWord + ctz64(w);
+	}
+
+	struct bit_and
+	{
+		static bitset_word apply(bitset_word a, bitset_word b)	{ return a & b; }
+#if RDE_BITSET_AVX2
+		RDE_TARGET_AVX2 static __m256i apply(__m256i a, __m256i b)	{ return _mm256_and_si256(a, b); }
+#endif
+	};
+	struct bit_or
+	{
+		static bitset_word apply(bitset_word a, bitset_word b)	{ return a | b; }
+#if RDE_BITSET_AVX2
+		RDE_TARGET_AVX2 static __m256i apply(__m256i a, __m256i b)	{ return _mm256_or_si256(a, b); }
+#endif
+	};
+	struct bit_xor
+	{
+		static bitset_word apply(bitset_word a, bitset_word b)	{ return a ^ b; }
+#if RDE_BITSET_AVX2
+		RDE_TARGET_AVX2 static __m256i apply(__m256i a, __m256i b)	{ return _mm256_xor_si256(a, b); }
+#endif
+	};
+	struct bit_and_not
+	{
+		static bitset_word apply(bitset_word a, bitset_word b)	{ return a & ~b; }
+#if RDE_BITSET_AVX2
+		RDE_TARGET_AVX2 static __m256i apply(__m256i a, __m256i b)	{ return _mm256_andnot_si256(b, a); }
+#endif
+	};
+
+	template<class TOp>
+	void bitwise_op_scalar(bitset_word* dst, const bitset_word* src, size_t numWords)
+	{
+		for (size_t i = 0; i < numWords; ++i)
+			dst[i] = TOp::apply(dst[i], src[i]);
+	}
+
+#if RDE_BITSET_AVX2
+	inline bool cpu_has_avx2()
+	{
+#	ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// OSXSAVE + AVX, and OS saves YMM registers.
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return false;
+		if ((_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#	else
+		return __builtin_cpu_supports("avx2") != 0;
+#	endif
+	}
+	inline bool use_avx2()
+	{
+		static const bool s_avx2 = cpu_has_avx2();
+		return s_avx2;
+	}
+
+	template<class TOp>
+	RDE_TARGET_AVX2 void bitwise_op_avx2(bitset_word* dst, const bitset_word* src, size_t numWords)
+	{
+		size_t i(0);
+		for (; i + 4 <= numWords; i += 4)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), TOp::apply(a, b));
+		}
+		for (; i < numWords; ++i)
+			dst[i] = TOp::apply(dst[i], src[i]);
+	}
+#endif
+
+	// dst = dst OP src, AVX2 used for bigger sets if CPU supports it.
+	template<class TOp>
+	void bitwise_op(bitset_word* dst, const bitset_word* src, size_t numWords)
+	{
+#if RDE_BITSET_AVX2
+		if (numWords >= 8 && use_avx2())
+		{
+			bitwise_op_avx2<TOp>(dst, src, numWords);
+			return;
+		}
+#endif
+		bitwise_op_scalar<TOp>(dst, src, numWords);
+	}
+} // namespace internal
+
+//=============================================================================
+// Iterates over indices of set bits (for (size_t i : bits.set_bits())).
+class set_bit_iterator
+{
+public:
+	typedef forward_iterator_tag	iterator_category;
+
+	set_bit_iterator(const internal::bitset_word* words, size_t numBits, size_t index)
+		: m_words(words),
+		m_numBits(numBits),
+		m_index(index)
+	{
+	}
+
+	size_t operator*() const	{ return m_index; }
+	set_bit_iterator& operator++()
+	{
+		m_index = internal::find_next_bit(m_words, m_numBits, m_index + 1);
+		return *this;
+	}
+	set_bit_iterator operator++(int)
+	{
+		set_bit_iterator copy(*this);
+		++(*this);
+		return copy;
+	}
+	bool operator==(const set_bit_iterator& rhs) const	{ return m_index == rhs.m_index; }
+	bool operator!=(const set_bit_iterator& rhs) const	{ return m_index != rhs.m_index; }
+
+private:
+	const internal::bitset_word*	m_words;
+	size_t							m_numBits;
+	size_t							m_index;
+};
+class set_bit_range
+{
+public:
+	set_bit_range(const internal::bitset_word* words, size_t numBits)
+		: m_words(words),
+		m_numBits(numBits)
+	{
+	}
+	set_bit_iterator begin() const
+	{
+		return set_bit_iterator(m_words, m_numBits, internal::find_next_bit(m_words, m_numBits, 0));
+	}
+	set_bit_iterator end() const	{ return set_bit_iterator(m_words, m_numBits, m_numBits); }
+
+private:
+	const internal::bitset_word*	m_words;
+	size_t							m_numBits;
+};
+
+//=============================================================================
+// Fixed size bit set, 64 bits per word.
+// Bits past N are always 0.
+template<size_t N>
+class bitset
+{
+	static_assert(N > 0, "empty bitset");
+public:
+	typedef internal::bitset_word	word_type;
+	static const size_t				kNumWords = (N + internal::kBitsPerWord - 1) / internal::kBitsPerWord;
+
+	bitset()	{ reset(); }
+
+	size_t size() const					{ return N; }
+	bool test(size_t i) const			{ RDE_ASSERT(i < N); return (m_words[i / 64] >> (i % 64)) & 1; }
+	bool operator[](size_t i) const		{ return test(i); }
+	void set(size_t i)					{ RDE_ASSERT(i < N); m_words[i / 64] |= word_type(1) << (i % 64); }
+	void set(size_t i, bool value)		{ if (value) set(i); else reset(i); }
+	void reset(size_t i)				{ RDE_ASSERT(i < N); m_words[i / 64] &= ~(word_type(1) << (i % 64)); }
+	void flip(size_t i)					{ RDE_ASSERT(i < N); m_words[i / 64] ^= word_type(1) << (i % 64); }
+	void set()
+	{
+		Sys::MemSet(m_words, 0xFF, sizeof(m_words));
+		clear_unused_bits();
+	}
+	void reset()	{ Sys::MemSet(m_words, 0, sizeof(m_words)); }
+	void flip()
+	{
+		for (size_t i = 0; i < kNumWords; ++i)
+			m_words[i] = ~m_words[i];
+		clear_unused_bits();
+	}
+
+	size_t count() const	{ return internal::count_bits(m_words, kNumWords); }
+	bool all() const		{ return count() == N; }
+	bool any() const
+	{
+		for (size_t i = 0; i < kNumWords; ++i)
+			if (m_words[i])
+				return true;
+		return false;
+	}
+	bool none() const		{ return !any(); }
+	// First set bit, or size() if none.
+	size_t find_first() const			{ return internal::find_next_bit(m_words, N, 0); }
+	// First set bit after i, or size() if none.
+	size_t find_next(size_t i) const	{ return internal::find_next_bit(m_words, N, i + 1); }
+	set_bit_range set_bits() const		{ return set_bit_range(m_words, N); }
+
+	bitset& operator&=(const bitset& rhs)	{ internal::bitwise_op<internal::bit_and>(m_words, rhs.m_words, kNumWords); return *this; }
+	bitset& operator|=(const bitset& rhs)	{ internal::bitwise_op<internal::bit_or>(m_words, rhs.m_words, kNumWords); return *this; }
+	bitset& operator^=(const bitset& rhs)	{ internal::bitwise_op<internal::bit_xor>(m_words, rhs.m_words, kNumWords); return *this; }
+	// this &= ~rhs
+	bitset& and_not(const bitset& rhs)		{ internal::bitwise_op<internal::bit_and_not>(m_words, rhs.m_words, kNumWords); return *this; }
+
+	bool operator==(const bitset& rhs) const
+	{
+		for (size_t i = 0; i < kNumWords; ++i)
+			if (m_words[i] != rhs.m_words[i])
+				return false;
+		return true;
+	}
+	bool operator!=(const bitset& rhs) const	{ return !(*this == rhs); }
+
+	const word_type* words() const	{ return m_words; }
+
+private:
+	void clear_unused_bits()
+	{
+		if (N % internal::kBitsPerWord)
+			m_words[kNumWords - 1] &= ~word_type(0) >> (internal::kBitsPerWord - N % internal::kBitsPerWord);
+	}
+
+	word_type	m_words[kNumWords];
+};
+
+//=============================================================================
+// Resizable bit set, words kept in rde::vector.
+// Bits past size() are always 0. Bulk operations need sets of the same size.
+template<class TAllocator = rde::allocator>
+class dynamic_bitset
+{
+public:
+	typedef internal::bitset_word	word_type;
+	typedef TAllocator				allocator_type;
+
+	explicit dynamic_bitset(const allocator_type& allocator = allocator_type())
+		: m_words(allocator),
+		m_numBits(0)
+	{
+	}
+	explicit dynamic_bitset(size_t numBits, const allocator_type& allocator = allocator_type())
+		: m_words(allocator),
+		m_numBits(0)
+	{
+		resize(numBits);
+	}
+
+	size_t size() const		{ return m_numBits; }
+	bool empty() const		{ return m_numBits == 0; }
+	size_t num_words() const	{ return m_words.size(); }
+
+	// New bits are set to value.
+	void resize(size_t numBits, bool value = false)
+	{
+		const size_t prevBits = m_numBits;
+		const size_t numWords = words_for(numBits);
+		if (numWords > m_words.size())
+			m_words.insert(m_words.end(), numWords - m_words.size(), value ? ~word_type(0) : 0);
+		else
+			m_words.resize(numWords);
+		if (value && numBits > prevBits && (prevBits % internal::kBitsPerWord) != 0)
+			m_words[prevBits / internal::kBitsPerWord] |= ~word_type(0) << (prevBits % internal::kBitsPerWord);
+		m_numBits = numBits;
+		clear_unused_bits();
+	}
+	void clear()
+	{
+		m_words.clear();
+		m_numBits = 0;
+	}
+	void push_back(bool value)
+	{
+		if (m_numBits % internal::kBitsPerWord == 0)
+			m_words.push_back(0);
+		++m_numBits;
+		set(m_numBits - 1, value);
+	}
+
+	bool test(size_t i) const			{ RDE_ASSERT(i < m_numBits); return (m_words[i / 64] >> (i % 64)) & 1; }
+	bool operator[](size_t i) const		{ return test(i); }
+	void set(size_t i)					{ RDE_ASSERT(i < m_numBits); m_words[i / 64] |= word_type(1) << (i % 64); }
+	void set(size_t i, bool value)		{ if (value) set(i); else reset(i); }
+	void reset(size_t i)				{ RDE_ASSERT(i < m_numBits); m_words[i / 64] &= ~(word_type(1) << (i % 64)); }
+	void flip(size_t i)					{ RDE_ASSERT(i < m_numBits); m_words[i / 64] ^= word_type(1) << (i % 64); }
+	void set()
+	{
+		if (!m_words.empty())
+			Sys::MemSet(m_words.data(), 0xFF, m_words.size() * sizeof(word_type));
+		clear_unused_bits();
+	}
+	void reset()
+	{
+		if (!m_words.empty())
+			Sys::MemSet(m_words.data(), 0, m_words.size() * sizeof(word_type));
+	}
+	void flip()
+	{
+		for (size_t i = 0; i < m_words.size(); ++i)
+			m_words[i] = ~m_words[i];
+		clear_unused_bits();
+	}
+
+	size_t count() const	{ return internal::count_bits(m_words.data(), m_words.size()); }
+	bool all() const		{ return count() == m_numBits; }
+	bool any() const
+	{
+		for (size_t i = 0; i < m_words.size(); ++i)
+			if (m_words[i])
+				return true;
+		return false;
+	}
+	bool none() const		{ return !any(); }
+	// First set bit, or size() if none.
+	size_t find_first() const			{ return internal::find_next_bit(m_words.data(), m_numBits, 0); }
+	// First set bit after i, or size() if none.
+	size_t find_next(size_t i) const	{ return internal::find_next_bit(m_words.data(), m_numBits, i + 1); }
+	set_bit_range set_bits() const		{ return set_bit_range(m_words.data(), m_numBits); }
+
+	dynamic_bitset& operator&=(const dynamic_bitset& rhs)	{ return bulk_op<internal::bit_and>(rhs); }
+	dynamic_bitset& operator|=(const dynamic_bitset& rhs)	{ return bulk_op<internal::bit_or>(rhs); }
+	dynamic_bitset& operator^=(const dynamic_bitset& rhs)	{ return bulk_op<internal::bit_xor>(rhs); }
+	// this &= ~rhs
+	dynamic_bitset& and_not(const dynamic_bitset& rhs)		{ return bulk_op<internal::bit_and_not>(rhs); }
+
+	bool operator==(const dynamic_bitset& rhs) const
+	{
+		if (m_numBits != rhs.m_numBits)
+			return false;
+		for (size_t i = 0; i < m_words.size(); ++i)
+			if (m_words[i] != rhs.m_words[i])
+				return false;
+		return true;
+	}
+	bool operator!=(const dynamic_bitset& rhs) const	{ return !(*this == rhs); }
+
+	// Raw words, bit i is (words[i / 64] >> (i % 64)) & 1.
+	const word_type* words() const	{ return m_words.data(); }
+
+private:
+	static size_t words_for(size_t numBits)
+	{
+		return (numBits + internal::kBitsPerWord - 1) / internal::kBitsPerWord;
+	}
+	template<class TOp>
+	dynamic_bitset& bulk_op(const dynamic_bitset& rhs)
+	{
+		RDE_ASSERT(m_numBits == rhs.m_numBits);
+		internal::bitwise_op<TOp>(m_words.data(), rhs.m_words.data(), m_words.size());
+		return *this;
+	}
+	void clear_unused_bits()
+	{
+		if (m_numBits % internal::kBitsPerWord)
+			m_words.back() &= ~word_type(0) >> (internal::kBitsPerWord - m_numBits % internal::kBitsPerWord);
+	}
+
+	vector<word_type, TAllocator>	m_words;
+	size_t							m_numBits;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_BITSET_H
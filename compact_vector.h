@@ -0,0 +1,307 @@
+#ifndef RDESTL_COMPACT_VECTOR_H
+#define RDESTL_COMPACT_VECTOR_H
+
+#include "vector.h"
+
+namespace rde
+{
+
+// Compact vector storages.
+// Allocator is not stored (that's the point), a default constructed instance
+// is used whenever memory is (de)allocated, so it has to be stateless.
+// Size and capacity are 32-bit.
+
+//=============================================================================
+// Pointer + 32-bit size/capacity, 16 bytes on 64-bit.
+template<typename T, class TAllocator>
+struct compact_vector_storage
+{
+	typedef std::uint32_t	size_type;
+
+	compact_vector_storage(): m_data(0), m_size(0), m_capacity(0) {}
+
+	RDE_FORCEINLINE T* data() const				{ return m_data; }
+	RDE_FORCEINLINE size_type size() const		{ return m_size; }
+	RDE_FORCEINLINE size_type capacity() const	{ return m_capacity; }
+	RDE_FORCEINLINE void set_size(size_type n)	{ RDE_ASSERT(n <= m_capacity); m_size = n; }
+
+	// Moves elements to new block. newCapacity >= size().
+	void reallocate(size_type newCapacity)
+	{
+		RDE_ASSERT(newCapacity >= m_size);
+		TAllocator allocator;
+		T* newData = newCapacity ? static_cast<T*>(allocator.allocate(newCapacity * sizeof(T))) : 0;
+		if (m_data)
+		{
+			if (m_size)
+				rde::relocate_n(m_data, m_size, newData);
+			allocator.deallocate(m_data, m_capacity * sizeof(T));
+		}
+		m_data = newData;
+		m_capacity = newCapacity;
+	}
+	void swap(compact_vector_storage& rhs)
+	{
+		rde::swap(m_data, rhs.m_data);
+		rde::swap(m_size, rhs.m_size);
+		rde::swap(m_capacity, rhs.m_capacity);
+	}
+
+	T*			m_data;
+	size_type	m_size;
+	size_type	m_capacity;
+};
+
+//=============================================================================
+// Single pointer, 8 bytes on 64-bit. Size and capacity live in front of
+// the elements on the heap, empty vector doesn't allocate.
+template<typename T, class TAllocator>
+struct compact_vector_header_storage
+{
+	typedef std::uint32_t	size_type;
+
+	struct header
+	{
+		size_type	size;
+		size_type	capacity;
+	};
+	static const size_t	kHeaderSize = (alignof(T) > sizeof(header) ? alignof(T) : sizeof(header));
+
+	compact_vector_header_storage(): m_data(0) {}
+
+	RDE_FORCEINLINE T* data() const				{ return m_data; }
+	RDE_FORCEINLINE size_type size() const		{ return m_data ? get_header()->size : 0; }
+	RDE_FORCEINLINE size_type capacity() const	{ return m_data ? get_header()->capacity : 0; }
+	RDE_FORCEINLINE void set_size(size_type n)
+	{
+		RDE_ASSERT(n <= capacity());
+		if (m_data)
+			get_header()->size = n;
+	}
+
+	void reallocate(size_type newCapacity)
+	{
+		const size_type oldSize = size();
+		RDE_ASSERT(newCapacity >= oldSize);
+		TAllocator allocator;
+		T* newData(0);
+		if (newCapacity)
+		{
+			char* mem = static_cast<char*>(allocator.allocate(kHeaderSize + newCapacity * sizeof(T)));
+			newData = reinterpret_cast<T*>(mem + kHeaderSize);
+		}
+		if (m_data)
+		{
+			if (oldSize)
+				rde::relocate_n(m_data, oldSize, newData);
+			allocator.deallocate(reinterpret_cast<char*>(m_data) - kHeaderSize,
+				kHeaderSize + get_header()->capacity * sizeof(T));
+		}
+		m_data = newData;
+		if (m_data)
+		{
+			get_header()->size = oldSize;
+			get_header()->capacity = newCapacity;
+		}
+	}
+	void swap(compact_vector_header_storage& rhs)
+	{
+		rde::swap(m_data, rhs.m_data);
+	}
+
+	RDE_FORCEINLINE header* get_header() const
+	{
+		return reinterpret_cast<header*>(reinterpret_cast<char*>(m_data) - kHeaderSize);
+	}
+
+	T*	m_data;
+};
+
+//=============================================================================
+// Vector for small per-object lists, where sizeof matters more than anything.
+// Subset of rde::vector interface.
+template<typename T,
+	class TAllocator = rde::allocator,
+	class TStorage = compact_vector_storage<T, TAllocator>
+>
+class compact_vector: private TStorage
+{
+public:
+	typedef T							value_type;
+	typedef T*							iterator;
+	typedef const T*					const_iterator;
+	typedef TAllocator					allocator_type;
+	typedef typename TStorage::size_type	size_type;
+	static const size_type				kInitialCapacity = 4;
+
+	compact_vector() {}
+	compact_vector(const compact_vector& rhs)
+	{
+		copy(rhs);
+	}
+	compact_vector(compact_vector&& rhs)
+	{
+		TStorage::swap(rhs);
+	}
+	~compact_vector()
+	{
+		clear();
+		if (capacity())
+			TStorage::reallocate(0);
+	}
+	compact_vector& operator=(const compact_vector& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			copy(rhs);
+		}
+		return *this;
+	}
+	compact_vector& operator=(compact_vector&& rhs)
+	{
+		TStorage::swap(rhs);
+		return *this;
+	}
+
+	iterator begin()				{ return data(); }
+	const_iterator begin() const	{ return data(); }
+	iterator end()					{ return data() + size(); }
+	const_iterator end() const		{ return data() + size(); }
+	T* data()						{ return TStorage::data(); }
+	const T* data() const			{ return TStorage::data(); }
+	size_type size() const			{ return TStorage::size(); }
+	size_type capacity() const		{ return TStorage::capacity(); }
+	bool empty() const				{ return size() == 0; }
+
+	T& operator[](size_type i)				{ RDE_ASSERT(i < size()); return data()[i]; }
+	const T& operator[](size_type i) const	{ RDE_ASSERT(i < size()); return data()[i]; }
+	T& front()				{ RDE_ASSERT(!empty()); return data()[0]; }
+	const T& front() const	{ RDE_ASSERT(!empty()); return data()[0]; }
+	T& back()				{ RDE_ASSERT(!empty()); return data()[size() - 1]; }
+	const T& back() const	{ RDE_ASSERT(!empty()); return data()[size() - 1]; }
+
+	RDE_FORCEINLINE void push_back(const T& v)
+	{
+		const size_type n = size();
+		if (n == capacity())
+			grow();
+		rde::copy_construct(data() + n, v);
+		TStorage::set_size(n + 1);
+	}
+	template<class... Args>
+	RDE_FORCEINLINE void emplace_back(Args&&... args)
+	{
+		const size_type n = size();
+		if (n == capacity())
+			grow();
+		rde::construct_args(data() + n, std::forward<Args>(args)...);
+		TStorage::set_size(n + 1);
+	}
+	void pop_back()
+	{
+		RDE_ASSERT(!empty());
+		const size_type n = size() - 1;
+		rde::destruct(data() + n);
+		TStorage::set_size(n);
+	}
+
+	// @pre validate_iterator(it)
+	iterator insert(iterator it, const T& val)
+	{
+		RDE_ASSERT(validate_iterator(it));
+		const size_type index = size_type(it - begin());
+		push_back(val);
+		// Rotate new element into place.
+		T* first = data() + index;
+		for (T* p = data() + size() - 1; p != first; --p)
+			rde::swap(*p, *(p - 1));
+		return first;
+	}
+	// @pre validate_iterator(it) && it != end()
+	iterator erase(iterator it)
+	{
+		RDE_ASSERT(validate_iterator(it) && it != end());
+		for (iterator next = it + 1; next != end(); ++next)
+			*(next - 1) = std::move(*next);
+		pop_back();
+		return it;
+	}
+	// Doesn't preserve order.
+	void erase_unordered(iterator it)
+	{
+		RDE_ASSERT(validate_iterator(it) && it != end());
+		iterator last = end() - 1;
+		if (it != last)
+			*it = std::move(*last);
+		pop_back();
+	}
+
+	void clear()
+	{
+		rde::destruct_n(data(), size());
+		TStorage::set_size(0);
+	}
+	void reserve(size_type n)
+	{
+		if (n > capacity())
+			TStorage::reallocate(n);
+	}
+	void resize(size_type n)
+	{
+		const size_type prevSize = size();
+		if (n > prevSize)
+		{
+			reserve(n);
+			for (size_type i = prevSize; i < n; ++i)
+				rde::construct_args(data() + i);
+		}
+		else
+		{
+			rde::destruct_n(data() + n, prevSize - n);
+		}
+		TStorage::set_size(n);
+	}
+	void shrink_to_fit()
+	{
+		if (capacity() != size())
+			TStorage::reallocate(size());
+	}
+
+	iterator find(const T& item)
+	{
+		iterator itEnd = end();
+		for (iterator it = begin(); it != itEnd; ++it)
+			if (*it == item)
+				return it;
+		return itEnd;
+	}
+	bool validate_iterator(const_iterator it) const
+	{
+		return it >= begin() && it <= end();
+	}
+
+private:
+	// @pre this is empty.
+	void copy(const compact_vector& rhs)
+	{
+		const size_type n = rhs.size();
+		// Empty rhs may have no block at all, don't copy from null.
+		if (n == 0)
+			return;
+		reserve(n);
+		rde::copy_construct_n(const_cast<T*>(rhs.data()), n, data());
+		TStorage::set_size(n);
+	}
+	void grow()
+	{
+		const size_type c = capacity();
+		RDE_ASSERT(c < size_type(-1) / 2);
+		TStorage::reallocate(c == 0 ? kInitialCapacity : c * 2);
+	}
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_COMPACT_VECTOR_H
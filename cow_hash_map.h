@@ -0,0 +1,463 @@
+#ifndef RDESTL_COW_HASH_MAP_H
+#define RDESTL_COW_HASH_MAP_H
+
+#include <atomic>
+#include "algorithm.h"
+#include "allocator.h"
+#include "functional.h"
+#include "iterator.h"
+#include "pair.h"
+#include "rhash.h"
+
+namespace rde
+{
+
+// Hash map with O(1) copy-on-write snapshots.
+// Buckets are kept in fixed size pages (TPageSize nodes each), pages are
+// reference counted and shared between map and its snapshots. Snapshot (copy
+// constructor/assignment) only adds a reference to the page directory, first
+// write after that copies directory (pointers only) and then every modified
+// page is copied on demand, untouched pages stay shared.
+// Reference counts are atomic, so snapshot can be read (and destroyed) on
+// another thread while the original is modified. Single map object itself is
+// not thread-safe.
+// Hashing, probing and load factor (7/8th) are the same as in hash_map.
+template<typename TKey, typename TValue,
+	class THashFunc		= rde::hash<TKey>,
+	class TKeyEqualFunc	= rde::equal_to<TKey>,
+	class TAllocator	= rde::allocator,
+	size_t TPageSize	= 256
+>
+class cow_hash_map
+{
+public:
+	typedef rde::pair<TKey, TValue>	value_type;
+
+private:
+	struct node
+	{
+		static const hash_value_t kUnusedHash	= 0xFFFFFFFF;
+		static const hash_value_t kDeletedHash	= 0xFFFFFFFE;
+
+		RDE_FORCEINLINE bool is_unused() const		{ return hash == kUnusedHash; }
+		RDE_FORCEINLINE bool is_deleted() const		{ return hash == kDeletedHash; }
+		RDE_FORCEINLINE bool is_occupied() const	{ return hash < kDeletedHash; }
+
+		hash_value_t	hash;
+		value_type		data;
+	};
+	struct page
+	{
+		std::atomic<int>	refs;
+		node				nodes[TPageSize];
+	};
+	struct directory
+	{
+		std::atomic<int>	refs;
+		size_t				numPages;
+		// [page* pages[numPages]]
+		page** pages()				{ return reinterpret_cast<page**>(this + 1); }
+		page* const* pages() const	{ return reinterpret_cast<page* const*>(this + 1); }
+	};
+
+	static_assert((TPageSize & (TPageSize - 1)) == 0, "page size must be power-of-two");
+
+public:
+	typedef TKey		key_type;
+	typedef TValue		mapped_type;
+	typedef TAllocator	allocator_type;
+	typedef size_t		size_type;
+
+	// Read-only iteration. Use find_for_write/operator[] to modify values.
+	class const_iterator
+	{
+		friend class cow_hash_map;
+	public:
+		typedef forward_iterator_tag	iterator_category;
+
+		const value_type& operator*() const		{ return current()->data; }
+		const value_type* operator->() const	{ return &current()->data; }
+
+		const_iterator& operator++()
+		{
+			++m_index;
+			move_to_next_occupied_node();
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator copy(*this);
+			++(*this);
+			return copy;
+		}
+
+		RDE_FORCEINLINE bool operator==(const const_iterator& rhs) const { return rhs.m_index == m_index; }
+		RDE_FORCEINLINE bool operator!=(const const_iterator& rhs) const { return !(rhs == *this); }
+
+	private:
+		const_iterator(const cow_hash_map* map, size_type index)
+			: m_map(map),
+			m_index(index)
+		{
+			/**/
+		}
+		const node* current() const
+		{
+			RDE_ASSERT(m_index < m_map->m_capacity);
+			return m_map->get_node(m_index);
+		}
+		void move_to_next_occupied_node()
+		{
+			for (; m_index < m_map->m_capacity; ++m_index)
+			{
+				if (m_map->get_node(m_index)->is_occupied())
+					break;
+			}
+		}
+
+		const cow_hash_map*	m_map;
+		size_type			m_index;
+	};
+	typedef const_iterator	iterator;
+
+	static const size_type	kPageSize = TPageSize;
+
+	explicit cow_hash_map(const allocator_type& allocator = allocator_type())
+		: m_dir(0),
+		m_size(0),
+		m_capacity(0),
+		m_capacityMask(0),
+		m_numUsed(0),
+		m_allocator(allocator)
+	{
+		/**/
+	}
+	// O(1), shares all pages with rhs.
+	// @note: unlike other containers, allocator IS copied from rhs (pages are shared).
+	cow_hash_map(const cow_hash_map& rhs)
+		: m_dir(rhs.m_dir),
+		m_size(rhs.m_size),
+		m_capacity(rhs.m_capacity),
+		m_capacityMask(rhs.m_capacityMask),
+		m_numUsed(rhs.m_numUsed),
+		m_hashFunc(rhs.m_hashFunc),
+		m_keyEqualFunc(rhs.m_keyEqualFunc),
+		m_allocator(rhs.m_allocator)
+	{
+		if (m_dir)
+			m_dir->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+	~cow_hash_map()
+	{
+		release_directory(m_dir);
+	}
+
+	// O(1), shares all pages with rhs.
+	// @note: allocator IS copied from rhs (like in copy constructor), shared
+	// pages have to be freed by the allocator that created them.
+	cow_hash_map& operator=(const cow_hash_map& rhs)
+	{
+		if (m_dir != rhs.m_dir)
+		{
+			if (rhs.m_dir)
+				rhs.m_dir->refs.fetch_add(1, std::memory_order_relaxed);
+			release_directory(m_dir);
+			m_dir = rhs.m_dir;
+		}
+		m_allocator = rhs.m_allocator;
+		m_size = rhs.m_size;
+		m_capacity = rhs.m_capacity;
+		m_capacityMask = rhs.m_capacityMask;
+		m_numUsed = rhs.m_numUsed;
+		m_hashFunc = rhs.m_hashFunc;
+		m_keyEqualFunc = rhs.m_keyEqualFunc;
+		return *this;
+	}
+	// @extension: explicit version of copy constructor.
+	cow_hash_map snapshot() const
+	{
+		return cow_hash_map(*this);
+	}
+
+	const_iterator begin() const
+	{
+		const_iterator it(this, 0);
+		it.move_to_next_occupied_node();
+		return it;
+	}
+	const_iterator end() const	{ return const_iterator(this, m_capacity); }
+
+	const_iterator find(const key_type& key) const
+	{
+		return const_iterator(this, lookup(key));
+	}
+	// @return pointer to value (in page private to this map) or 0 if not found.
+	mapped_type* find_for_write(const key_type& key)
+	{
+		const size_type i = lookup(key);
+		return i == m_capacity ? 0 : &get_writable_node(i)->data.second;
+	}
+	mapped_type& operator[](const key_type& key)
+	{
+		return insert(value_type(key, TValue())).first->second;
+	}
+
+	rde::pair<value_type*, bool> insert(const value_type& v)
+	{
+		if (m_numUsed * 8 >= m_capacity * 7)
+			grow(m_capacity == 0 ? TPageSize : m_capacity * 2);
+
+		const hash_value_t hash = hash_func(v.first);
+		size_type i = hash & m_capacityMask;
+		size_type freeIndex = m_capacity;
+		std::uint32_t numProbes(0);
+		for (;;)
+		{
+			const node* n = get_node(i);
+			if (n->is_unused())
+				break;
+			if (compare_key(n, v.first, hash))
+				return rde::pair<value_type*, bool>(&get_writable_node(i)->data, false);
+			if (n->is_deleted() && freeIndex == m_capacity)
+				freeIndex = i;
+			++numProbes;
+			i = (i + numProbes) & m_capacityMask;
+		}
+		if (freeIndex == m_capacity)
+		{
+			freeIndex = i;
+			++m_numUsed;
+		}
+		node* n = get_writable_node(freeIndex);
+		rde::copy_construct(&n->data, v);
+		n->hash = hash;
+		++m_size;
+		return rde::pair<value_type*, bool>(&n->data, true);
+	}
+	size_type erase(const key_type& key)
+	{
+		const size_type i = lookup(key);
+		if (i == m_capacity)
+			return 0;
+		node* n = get_writable_node(i);
+		rde::destruct(&n->data);
+		n->hash = node::kDeletedHash;
+		--m_size;
+		return 1;
+	}
+	// Drops this map's references, shared pages survive in snapshots.
+	void clear()
+	{
+		release_directory(m_dir);
+		m_dir = 0;
+		m_size = 0;
+		m_capacity = 0;
+		m_capacityMask = 0;
+		m_numUsed = 0;
+	}
+	void reserve(size_type min_size)
+	{
+		size_type newCapacity = (m_capacity == 0 ? TPageSize : m_capacity);
+		while (newCapacity < min_size)
+			newCapacity *= 2;
+		if (newCapacity > m_capacity)
+			grow(newCapacity);
+	}
+
+	size_type bucket_count() const	{ return m_capacity; }
+	size_type size() const			{ return m_size; }
+	bool empty() const				{ return m_size == 0; }
+	// Number of pages shared with at least one other map.
+	size_type shared_page_count() const
+	{
+		if (m_dir == 0)
+			return 0;
+		const bool dirShared = m_dir->refs.load(std::memory_order_acquire) > 1;
+		size_type numShared(0);
+		for (size_type i = 0; i < m_dir->numPages; ++i)
+		{
+			if (dirShared || m_dir->pages()[i]->refs.load(std::memory_order_acquire) > 1)
+				++numShared;
+		}
+		return numShared;
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	RDE_FORCEINLINE const node* get_node(size_type i) const
+	{
+		return &m_dir->pages()[i / TPageSize]->nodes[i & (TPageSize - 1)];
+	}
+	// Makes sure both directory and page containing i-th node are not shared.
+	node* get_writable_node(size_type i)
+	{
+		if (m_dir->refs.load(std::memory_order_acquire) > 1)
+			m_dir = clone_directory(m_dir);
+		page*& p = m_dir->pages()[i / TPageSize];
+		if (p->refs.load(std::memory_order_acquire) > 1)
+		{
+			page* newPage = clone_page(p);
+			release_page(p);
+			p = newPage;
+		}
+		return &p->nodes[i & (TPageSize - 1)];
+	}
+
+	size_type lookup(const key_type& key) const
+	{
+		if (m_capacity == 0)
+			return 0;
+		const hash_value_t hash = hash_func(key);
+		size_type i = hash & m_capacityMask;
+		std::uint32_t numProbes(0);
+		for (;;)
+		{
+			const node* n = get_node(i);
+			if (compare_key(n, key, hash))
+				return i;
+			if (n->is_unused())
+				return m_capacity;
+			++numProbes;
+			i = (i + numProbes) & m_capacityMask;
+		}
+	}
+
+	void grow(size_type newCapacity)
+	{
+		RDE_ASSERT((newCapacity & (newCapacity - 1)) == 0);
+		RDE_ASSERT(newCapacity >= TPageSize);
+		directory* newDir = allocate_directory(newCapacity / TPageSize);
+		for (size_type i = 0; i < newDir->numPages; ++i)
+			newDir->pages()[i] = allocate_page();
+
+		const size_type newMask = newCapacity - 1;
+		// Unique pages can be moved from, shared ones have to be copied.
+		const bool dirShared = (m_dir != 0 && m_dir->refs.load(std::memory_order_acquire) > 1);
+		for (size_type pageIndex = 0; m_dir != 0 && pageIndex < m_dir->numPages; ++pageIndex)
+		{
+			page* p = m_dir->pages()[pageIndex];
+			const bool canMove = !dirShared && p->refs.load(std::memory_order_acquire) == 1;
+			for (size_type j = 0; j < TPageSize; ++j)
+			{
+				node* it = &p->nodes[j];
+				if (!it->is_occupied())
+					continue;
+				const hash_value_t hash = it->hash;
+				size_type i = hash & newMask;
+				node* n = &newDir->pages()[i / TPageSize]->nodes[i & (TPageSize - 1)];
+				std::uint32_t numProbes(0);
+				while (!n->is_unused())
+				{
+					++numProbes;
+					i = (i + numProbes) & newMask;
+					n = &newDir->pages()[i / TPageSize]->nodes[i & (TPageSize - 1)];
+				}
+				if (canMove)
+				{
+					rde::construct_args(&n->data, std::move(it->data));
+					rde::destruct(&it->data);
+					it->hash = node::kUnusedHash;
+				}
+				else
+				{
+					rde::copy_construct(&n->data, it->data);
+				}
+				n->hash = hash;
+			}
+		}
+		release_directory(m_dir);
+		m_dir = newDir;
+		m_capacity = newCapacity;
+		m_capacityMask = newMask;
+		m_numUsed = m_size;
+	}
+
+	page* allocate_page()
+	{
+		page* p = static_cast<page*>(m_allocator.allocate(sizeof(page)));
+		::new (static_cast<void*>(&p->refs)) std::atomic<int>(1);
+		for (size_type i = 0; i < TPageSize; ++i)
+			p->nodes[i].hash = node::kUnusedHash;
+		return p;
+	}
+	page* clone_page(const page* p)
+	{
+		page* newPage = static_cast<page*>(m_allocator.allocate(sizeof(page)));
+		::new (static_cast<void*>(&newPage->refs)) std::atomic<int>(1);
+		for (size_type i = 0; i < TPageSize; ++i)
+		{
+			const node& from = p->nodes[i];
+			node& to = newPage->nodes[i];
+			if (from.is_occupied())
+				rde::copy_construct(&to.data, from.data);
+			to.hash = from.hash;
+		}
+		return newPage;
+	}
+	void release_page(page* p)
+	{
+		if (p->refs.fetch_sub(1, std::memory_order_release) != 1)
+			return;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		for (size_type i = 0; i < TPageSize; ++i)
+		{
+			if (p->nodes[i].is_occupied())
+				rde::destruct(&p->nodes[i].data);
+		}
+		m_allocator.deallocate(p, sizeof(page));
+	}
+
+	directory* allocate_directory(size_type numPages)
+	{
+		directory* d = static_cast<directory*>(m_allocator.allocate(sizeof(directory) + numPages * sizeof(page*)));
+		::new (static_cast<void*>(&d->refs)) std::atomic<int>(1);
+		d->numPages = numPages;
+		return d;
+	}
+	// New directory points to the same pages.
+	directory* clone_directory(directory* d)
+	{
+		directory* newDir = allocate_directory(d->numPages);
+		for (size_type i = 0; i < d->numPages; ++i)
+		{
+			page* p = d->pages()[i];
+			p->refs.fetch_add(1, std::memory_order_relaxed);
+			newDir->pages()[i] = p;
+		}
+		release_directory(d);
+		return newDir;
+	}
+	void release_directory(directory* d)
+	{
+		if (d == 0 || d->refs.fetch_sub(1, std::memory_order_release) != 1)
+			return;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		for (size_type i = 0; i < d->numPages; ++i)
+			release_page(d->pages()[i]);
+		m_allocator.deallocate(d, sizeof(directory) + d->numPages * sizeof(page*));
+	}
+
+	RDE_FORCEINLINE hash_value_t hash_func(const key_type& key) const
+	{
+		return m_hashFunc(key) & 0xFFFFFFFD;
+	}
+	RDE_FORCEINLINE bool compare_key(const node* n, const key_type& key, hash_value_t hash) const
+	{
+		return (n->hash == hash && m_keyEqualFunc(key, n->data.first));
+	}
+
+	directory*		m_dir;
+	size_type		m_size;
+	size_type		m_capacity;
+	size_type		m_capacityMask;
+	size_type		m_numUsed;
+	THashFunc		m_hashFunc;
+	TKeyEqualFunc	m_keyEqualFunc;
+	TAllocator		m_allocator;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_COW_HASH_MAP_H
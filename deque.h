@@ -0,0 +1,384 @@
+#ifndef RDESTL_DEQUE_H
+#define RDESTL_DEQUE_H
+
+#include "algorithm.h"
+#include "allocator.h"
+#include "iterator.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Segmented deque.
+// Elements live in fixed-size blocks (TBlockSize elements each), deque keeps
+// a map of block pointers. Push/pop at both ends are O(1) and never move
+// elements, so references/pointers to them stay valid (until element is popped).
+// Only the map itself is reallocated (recentered) when either end runs out of slots.
+// Emptied blocks are kept for reuse (up to kMaxSpareBlocks), so queue-like
+// usage (push_back/pop_front) doesn't hit the allocator in steady state.
+template<typename T, class TAllocator = rde::allocator,
+	size_t TBlockSize = (sizeof(T) <= 256 ? 4096 / sizeof(T) : 16)>
+class deque
+{
+	static_assert(TBlockSize * sizeof(T) >= sizeof(void*), "deque block has to hold a pointer");
+
+	template<typename TDequePtr, typename TPtr, typename TRef>
+	class index_iterator
+	{
+	public:
+		typedef random_access_iterator_tag	iterator_category;
+		typedef size_t						size_type;
+		typedef ptrdiff_t					difference_type;
+
+		index_iterator(): m_deque(0), m_index(0) {}
+		index_iterator(TDequePtr d, size_type index): m_deque(d), m_index(index) {}
+
+		template<typename UDequePtr, typename UPtr, typename URef>
+		index_iterator(const index_iterator<UDequePtr, UPtr, URef>& rhs)
+			: m_deque(rhs.get_deque()), m_index(rhs.index()) {}
+
+		TRef operator*() const	{ return (*m_deque)[m_index]; }
+		TPtr operator->() const	{ return &(*m_deque)[m_index]; }
+		TRef operator[](difference_type n) const	{ return (*m_deque)[m_index + n]; }
+
+		index_iterator& operator++()	{ ++m_index; return *this; }
+		index_iterator& operator--()	{ --m_index; return *this; }
+		index_iterator operator++(int)
+		{
+			index_iterator copy(*this);
+			++m_index;
+			return copy;
+		}
+		index_iterator operator--(int)
+		{
+			index_iterator copy(*this);
+			--m_index;
+			return copy;
+		}
+		index_iterator& operator+=(difference_type n)	{ m_index += n; return *this; }
+		index_iterator& operator-=(difference_type n)	{ m_index -= n; return *this; }
+		index_iterator operator+(difference_type n) const	{ return index_iterator(m_deque, m_index + n); }
+		index_iterator operator-(difference_type n) const	{ return index_iterator(m_deque, m_index - n); }
+		difference_type operator-(const index_iterator& rhs) const
+		{
+			return difference_type(m_index) - difference_type(rhs.m_index);
+		}
+
+		bool operator==(const index_iterator& rhs) const	{ return m_index == rhs.m_index; }
+		bool operator!=(const index_iterator& rhs) const	{ return m_index != rhs.m_index; }
+		bool operator<(const index_iterator& rhs) const		{ return m_index < rhs.m_index; }
+		bool operator>(const index_iterator& rhs) const		{ return m_index > rhs.m_index; }
+		bool operator<=(const index_iterator& rhs) const	{ return m_index <= rhs.m_index; }
+		bool operator>=(const index_iterator& rhs) const	{ return m_index >= rhs.m_index; }
+
+		TDequePtr get_deque() const	{ return m_deque; }
+		size_type index() const		{ return m_index; }
+
+	private:
+		TDequePtr	m_deque;
+		size_type	m_index;
+	};
+
+public:
+	typedef T																value_type;
+	typedef TAllocator														allocator_type;
+	typedef size_t															size_type;
+	typedef index_iterator<deque*, T*, T&>									iterator;
+	typedef index_iterator<const deque*, const T*, const T&>				const_iterator;
+	static const size_type													kBlockSize = TBlockSize;
+	static const size_type													kMaxSpareBlocks = 2;
+
+	explicit deque(const allocator_type& allocator = allocator_type())
+		: m_map(0),
+		m_mapSize(0),
+		m_start(0),
+		m_size(0),
+		m_spareBlocks(0),
+		m_numSpareBlocks(0),
+		m_allocator(allocator)
+	{
+		/**/
+	}
+	// @note: allocator is not copied from rhs.
+	deque(const deque& rhs, const allocator_type& allocator = allocator_type())
+		: m_map(0),
+		m_mapSize(0),
+		m_start(0),
+		m_size(0),
+		m_spareBlocks(0),
+		m_numSpareBlocks(0),
+		m_allocator(allocator)
+	{
+		copy(rhs);
+	}
+	deque(deque&& rhs)
+		: m_map(0),
+		m_mapSize(0),
+		m_start(0),
+		m_size(0),
+		m_spareBlocks(0),
+		m_numSpareBlocks(0),
+		m_allocator(rhs.m_allocator)
+	{
+		swap(rhs);
+	}
+	~deque()
+	{
+		clear();
+		shrink_to_fit();
+		if (m_map)
+			m_allocator.deallocate(m_map, m_mapSize * sizeof(T*));
+	}
+
+	deque& operator=(const deque& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			copy(rhs);
+		}
+		return *this;
+	}
+	deque& operator=(deque&& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			swap(rhs);
+		}
+		return *this;
+	}
+	// @note: allocators are not swapped.
+	void swap(deque& rhs)
+	{
+		rde::swap(m_map, rhs.m_map);
+		rde::swap(m_mapSize, rhs.m_mapSize);
+		rde::swap(m_start, rhs.m_start);
+		rde::swap(m_size, rhs.m_size);
+		rde::swap(m_spareBlocks, rhs.m_spareBlocks);
+		rde::swap(m_numSpareBlocks, rhs.m_numSpareBlocks);
+	}
+
+	iterator begin()				{ return iterator(this, 0); }
+	const_iterator begin() const	{ return const_iterator(this, 0); }
+	iterator end()					{ return iterator(this, m_size); }
+	const_iterator end() const		{ return const_iterator(this, m_size); }
+	size_type size() const			{ return m_size; }
+	bool empty() const				{ return m_size == 0; }
+
+	T& operator[](size_type i)
+	{
+		RDE_ASSERT(i < m_size);
+		const size_type pos = m_start + i;
+		return m_map[pos / TBlockSize][pos % TBlockSize];
+	}
+	const T& operator[](size_type i) const
+	{
+		RDE_ASSERT(i < m_size);
+		const size_type pos = m_start + i;
+		return m_map[pos / TBlockSize][pos % TBlockSize];
+	}
+	T& front()				{ RDE_ASSERT(!empty()); return (*this)[0]; }
+	const T& front() const	{ RDE_ASSERT(!empty()); return (*this)[0]; }
+	T& back()				{ RDE_ASSERT(!empty()); return (*this)[m_size - 1]; }
+	const T& back() const	{ RDE_ASSERT(!empty()); return (*this)[m_size - 1]; }
+
+	void push_back(const T& v)
+	{
+		rde::copy_construct(slot_back(), v);
+		++m_size;
+	}
+	template<class... Args>
+	void emplace_back(Args&&... args)
+	{
+		rde::construct_args(slot_back(), std::forward<Args>(args)...);
+		++m_size;
+	}
+	void push_front(const T& v)
+	{
+		T* slot = slot_front();
+		rde::copy_construct(slot, v);
+		--m_start;
+		++m_size;
+	}
+	template<class... Args>
+	void emplace_front(Args&&... args)
+	{
+		T* slot = slot_front();
+		rde::construct_args(slot, std::forward<Args>(args)...);
+		--m_start;
+		++m_size;
+	}
+
+	void pop_front()
+	{
+		RDE_ASSERT(!empty());
+		const size_type pos = m_start;
+		rde::destruct(&m_map[pos / TBlockSize][pos % TBlockSize]);
+		++m_start;
+		--m_size;
+		if (m_size == 0 || m_start % TBlockSize == 0)
+			release_block(pos / TBlockSize);
+		if (m_size == 0)
+			recenter_empty();
+	}
+	void pop_back()
+	{
+		RDE_ASSERT(!empty());
+		const size_type pos = m_start + m_size - 1;
+		rde::destruct(&m_map[pos / TBlockSize][pos % TBlockSize]);
+		--m_size;
+		if (m_size == 0 || pos % TBlockSize == 0)
+			release_block(pos / TBlockSize);
+		if (m_size == 0)
+			recenter_empty();
+	}
+
+	// Destructs all elements. Keeps the map and up to kMaxSpareBlocks blocks.
+	void clear()
+	{
+		if (m_size == 0)
+			return;
+		const size_type firstBlock = m_start / TBlockSize;
+		const size_type lastBlock = (m_start + m_size - 1) / TBlockSize;
+		for (size_type b = firstBlock; b <= lastBlock; ++b)
+		{
+			const size_type first = (b == firstBlock ? m_start % TBlockSize : 0);
+			const size_type last = (b == lastBlock ? (m_start + m_size - 1) % TBlockSize + 1 : TBlockSize);
+			rde::destruct_n(m_map[b] + first, last - first);
+			release_block(b);
+		}
+		m_size = 0;
+		recenter_empty();
+	}
+	// Frees spare blocks.
+	void shrink_to_fit()
+	{
+		while (m_spareBlocks != 0)
+		{
+			T* block = m_spareBlocks;
+			m_spareBlocks = next_spare(block);
+			m_allocator.deallocate(block, TBlockSize * sizeof(T));
+		}
+		m_numSpareBlocks = 0;
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+	void set_allocator(const allocator_type& allocator)
+	{
+		m_allocator = allocator;
+	}
+
+private:
+	void copy(const deque& rhs)
+	{
+		for (size_type i = 0; i < rhs.size(); ++i)
+			push_back(rhs[i]);
+	}
+
+	// Returns raw memory for new last element.
+	T* slot_back()
+	{
+		size_type pos = m_start + m_size;
+		if (pos == m_mapSize * TBlockSize)
+		{
+			grow_map();
+			pos = m_start + m_size;
+		}
+		T*& block = m_map[pos / TBlockSize];
+		if (block == 0)
+			block = acquire_block();
+		return block + pos % TBlockSize;
+	}
+	// Returns raw memory for new first element (at m_start - 1).
+	T* slot_front()
+	{
+		if (m_start == 0)
+			grow_map();
+		const size_type pos = m_start - 1;
+		T*& block = m_map[pos / TBlockSize];
+		if (block == 0)
+			block = acquire_block();
+		return block + pos % TBlockSize;
+	}
+
+	// Recenters blocks in use, doubles map if it's more than half full.
+	void grow_map()
+	{
+		const size_type firstBlock = m_start / TBlockSize;
+		const size_type numBlocks = (m_size == 0 ? 0 : (m_start + m_size - 1) / TBlockSize - firstBlock + 1);
+		size_type newMapSize = m_mapSize;
+		if (numBlocks * 2 + 2 > m_mapSize)
+			newMapSize = (m_mapSize == 0 ? 8 : m_mapSize * 2);
+		const size_type newFirstBlock = (newMapSize - numBlocks) / 2;
+
+		T** newMap = m_map;
+		if (newMapSize != m_mapSize)
+		{
+			newMap = static_cast<T**>(m_allocator.allocate(newMapSize * sizeof(T*)));
+			Sys::MemSet(newMap, 0, newMapSize * sizeof(T*));
+			if (numBlocks)
+				Sys::MemCpy(newMap + newFirstBlock, m_map + firstBlock, numBlocks * sizeof(T*));
+			if (m_map)
+				m_allocator.deallocate(m_map, m_mapSize * sizeof(T*));
+		}
+		else
+		{
+			Sys::MemMove(newMap + newFirstBlock, m_map + firstBlock, numBlocks * sizeof(T*));
+			Sys::MemSet(newMap, 0, newFirstBlock * sizeof(T*));
+			Sys::MemSet(newMap + newFirstBlock + numBlocks, 0, (newMapSize - newFirstBlock - numBlocks) * sizeof(T*));
+		}
+		m_map = newMap;
+		m_mapSize = newMapSize;
+		m_start = newFirstBlock * TBlockSize + m_start % TBlockSize;
+	}
+	void recenter_empty()
+	{
+		RDE_ASSERT(m_size == 0);
+		m_start = (m_mapSize / 2) * TBlockSize;
+	}
+
+	static T*& next_spare(T* block)	{ return *reinterpret_cast<T**>(block); }
+	T* acquire_block()
+	{
+		if (m_spareBlocks != 0)
+		{
+			T* block = m_spareBlocks;
+			m_spareBlocks = next_spare(block);
+			--m_numSpareBlocks;
+			return block;
+		}
+		return static_cast<T*>(m_allocator.allocate(TBlockSize * sizeof(T)));
+	}
+	void release_block(size_type index)
+	{
+		T* block = m_map[index];
+		RDE_ASSERT(block != 0);
+		m_map[index] = 0;
+		if (m_numSpareBlocks < kMaxSpareBlocks)
+		{
+			next_spare(block) = m_spareBlocks;
+			m_spareBlocks = block;
+			++m_numSpareBlocks;
+		}
+		else
+		{
+			m_allocator.deallocate(block, TBlockSize * sizeof(T));
+		}
+	}
+
+	T**				m_map;
+	size_type		m_mapSize;
+	// Position of first element, in elements from the start of the map.
+	size_type		m_start;
+	size_type		m_size;
+	// Free blocks, linked through their first bytes.
+	T*				m_spareBlocks;
+	size_type		m_numSpareBlocks;
+	TAllocator		m_allocator;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_DEQUE_H
@@ -0,0 +1,286 @@
+#ifndef RDESTL_EPOCH_H
+#define RDESTL_EPOCH_H
+
+#include <atomic>
+#include <mutex>
+#include "algorithm.h"
+#include "allocator.h"
+#include "vector.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Epoch based memory reclamation for lock-free/read-mostly containers.
+// Threads access shared data inside of critical sections (guard), memory that
+// was unlinked from shared structure is retired instead of freed right away.
+// Retired memory is freed once every thread that was inside of critical section
+// at the time of retirement has left it.
+// - every thread that touches shared data registers as participant (up to
+//   TMaxThreads at a time). Participant itself is not thread-safe,
+// - entering/leaving critical section costs one store to participant's own
+//   cache line (+ fence), no shared writes,
+// - retired pointers go to participant's local list, global epoch is only
+//   advanced and list scanned once every kCollectThreshold retirements,
+// - memory is returned through TAllocator::deallocate(ptr, bytes), from whichever
+//   thread collects it, so allocator has to be thread-safe.
+// Pointers have to be unlinked (no longer reachable for new readers) before
+// they're retired.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<class TAllocator = rde::allocator, int TMaxThreads = 64>
+class epoch_domain
+{
+	// Every slot on its own cache line.
+	struct alignas(RDE_CACHE_LINE_SIZE) slot
+	{
+		// 0 if thread is not inside of critical section, global epoch at the time it entered otherwise.
+		std::atomic<std::uint64_t>	epoch;
+		std::atomic<bool>			registered;
+	};
+	static_assert(sizeof(slot) == RDE_CACHE_LINE_SIZE, "slot should take exactly one cache line");
+	struct retired_ptr
+	{
+		void*			ptr;
+		size_t			bytes;
+		void			(*destroy)(void*);
+		std::uint64_t	epoch;
+	};
+	typedef rde::vector<retired_ptr, TAllocator>	retired_list_t;
+
+public:
+	typedef TAllocator	allocator_type;
+	typedef size_t		size_type;
+
+	static const size_type	kCollectThreshold = 64;
+
+	// Per-thread handle.
+	class participant
+	{
+	public:
+		explicit participant(epoch_domain& domain)
+		:	m_domain(domain),
+			m_slot(domain.register_participant()),
+			m_depth(0),
+			m_retired(domain.m_allocator)
+		{
+			m_retired.reserve(kCollectThreshold);
+		}
+		// Whatever couldn't be freed yet is handed over to the domain.
+		~participant()
+		{
+			RDE_ASSERT(m_depth == 0);
+			collect();
+			m_domain.adopt(m_retired);
+			m_domain.unregister_participant(m_slot);
+		}
+
+		// Critical sections can be nested.
+		void enter()
+		{
+			if (m_depth++ == 0)
+			{
+				m_slot->epoch.store(m_domain.m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+		void exit()
+		{
+			RDE_ASSERT(m_depth > 0);
+			if (--m_depth == 0)
+				m_slot->epoch.store(0, std::memory_order_release);
+		}
+		bool in_critical_section() const	{ return m_depth != 0; }
+
+		// Calls destructor and frees sizeof(T) bytes.
+		template<typename T>
+		void retire(T* p)
+		{
+			retire(p, sizeof(T), &destroy<T>);
+		}
+		// Only frees memory, no destructor call.
+		void retire(void* p, size_type bytes)
+		{
+			retire(p, bytes, 0);
+		}
+		// destroy (if not null) is called before memory is freed.
+		void retire(void* p, size_type bytes, void (*destroy)(void*))
+		{
+			retired_ptr r;
+			r.ptr = p;
+			r.bytes = bytes;
+			r.destroy = destroy;
+			// Caller's unlink (usually just a release store) must not be
+			// reordered after the epoch load (StoreLoad), otherwise reader
+			// entering in the next epoch could still see p.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			r.epoch = m_domain.m_epoch.load(std::memory_order_seq_cst);
+			m_retired.push_back(r);
+			if (m_retired.size() >= kCollectThreshold)
+				collect();
+		}
+		// Advances global epoch and frees everything that's safe to free.
+		// @return number of pointers freed.
+		size_type collect()
+		{
+			return m_domain.collect(m_retired);
+		}
+
+		// Retired, but not freed yet.
+		size_type pending() const	{ return m_retired.size(); }
+
+	private:
+		participant(const participant&);
+		participant& operator=(const participant&);
+
+		epoch_domain&	m_domain;
+		slot* const		m_slot;
+		int				m_depth;
+		retired_list_t	m_retired;
+	};
+
+	// Critical section, scope based.
+	class guard
+	{
+	public:
+		explicit guard(participant& p): m_participant(p)	{ p.enter(); }
+		~guard()											{ m_participant.exit(); }
+
+	private:
+		guard(const guard&);
+		guard& operator=(const guard&);
+
+		participant&	m_participant;
+	};
+
+	explicit epoch_domain(const allocator_type& allocator = allocator_type())
+	:	m_epoch(1),
+		m_allocator(allocator),
+		m_orphans(allocator)
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+		{
+			m_slots[i].epoch.store(0, std::memory_order_relaxed);
+			m_slots[i].registered.store(false, std::memory_order_relaxed);
+		}
+	}
+	// @pre no participants.
+	~epoch_domain()
+	{
+		for (typename retired_list_t::iterator it = m_orphans.begin(); it != m_orphans.end(); ++it)
+			free(*it);
+	}
+
+	std::uint64_t epoch() const	{ return m_epoch.load(std::memory_order_relaxed); }
+	// Left behind by participants that are gone.
+	size_type orphaned_count() const
+	{
+		std::lock_guard<std::mutex> lock(m_orphansLock);
+		return m_orphans.size();
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	epoch_domain(const epoch_domain&);
+	epoch_domain& operator=(const epoch_domain&);
+
+	slot* register_participant()
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+		{
+			bool expected(false);
+			if (!m_slots[i].registered.load(std::memory_order_relaxed) &&
+				m_slots[i].registered.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				return &m_slots[i];
+			}
+		}
+		RDE_ASSERT(!"epoch_domain: too many participants");
+		return 0;
+	}
+	void unregister_participant(slot* s)
+	{
+		s->epoch.store(0, std::memory_order_release);
+		s->registered.store(false, std::memory_order_release);
+	}
+
+	size_type collect(retired_list_t& retired)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		// Threads entering from now on can't see anything retired so far.
+		const std::uint64_t minEpoch = min_active_epoch(m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1);
+		size_type numFreed = free_older_than(retired, minEpoch);
+		// Orphans are rare, don't wait for someone else to finish with them.
+		std::unique_lock<std::mutex> lock(m_orphansLock, std::try_to_lock);
+		if (lock.owns_lock() && !m_orphans.empty())
+			numFreed += free_older_than(m_orphans, minEpoch);
+		return numFreed;
+	}
+	size_type free_older_than(retired_list_t& retired, std::uint64_t minEpoch)
+	{
+		size_type numFreed(0);
+		for (size_type i = 0; i < retired.size(); )
+		{
+			if (retired[i].epoch < minEpoch)
+			{
+				free(retired[i]);
+				retired.erase_unordered(retired.begin() + i);
+				++numFreed;
+			}
+			else
+			{
+				++i;
+			}
+		}
+		return numFreed;
+	}
+	// @return oldest epoch that is still observed by any thread (or current if none).
+	std::uint64_t min_active_epoch(std::uint64_t current) const
+	{
+		std::uint64_t minEpoch = current;
+		for (int i = 0; i < TMaxThreads; ++i)
+		{
+			const std::uint64_t e = m_slots[i].epoch.load(std::memory_order_seq_cst);
+			if (e != 0 && e < minEpoch)
+				minEpoch = e;
+		}
+		return minEpoch;
+	}
+	void adopt(retired_list_t& retired)
+	{
+		if (retired.empty())
+			return;
+		std::lock_guard<std::mutex> lock(m_orphansLock);
+		m_orphans.insert_range(m_orphans.end(), retired.begin(), retired.end());
+		retired.clear();
+	}
+	void free(const retired_ptr& r)
+	{
+		if (r.destroy)
+			r.destroy(r.ptr);
+		m_allocator.deallocate(r.ptr, r.bytes);
+	}
+
+	template<typename T>
+	static void destroy(void* p)
+	{
+		rde::destruct(static_cast<T*>(p));
+	}
+
+	slot												m_slots[TMaxThreads];
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<std::uint64_t>	m_epoch;
+	alignas(RDE_CACHE_LINE_SIZE) TAllocator					m_allocator;
+	mutable std::mutex			m_orphansLock;
+	retired_list_t				m_orphans;
+};
+// Slots, global epoch and the rest on separate cache lines.
+static_assert(alignof(epoch_domain<rde::allocator, 4>) == RDE_CACHE_LINE_SIZE &&
+	sizeof(epoch_domain<rde::allocator, 4>) >= 6 * RDE_CACHE_LINE_SIZE, "epoch_domain should be cache line aligned");
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_EPOCH_H
@@ -0,0 +1,373 @@
+#ifndef RDESTL_EXTERNAL_HASH_MAP_H
+#define RDESTL_EXTERNAL_HASH_MAP_H
+
+#include <cstdio>
+#include <type_traits>
+#include "hash_map.h"
+#include "rde_string.h"
+#include "vector.h"
+
+namespace rde
+{
+
+// Hash map for data sets that don't fit in memory.
+// Keys are partitioned by hash prefix (top bits of 32-bit hash), every partition
+// is either resident (regular hash_map) or cold (file on disk, one record per
+// element). Accessing cold partition streams it in with big sequential reads,
+// when resident partitions exceed memory budget, least recently used ones are
+// written back (sequentially, if modified) and dropped.
+// Works best if accesses are batched per partition (see partition_of).
+// Files are scratch data, named <file_prefix>.<partition index> and removed in
+// destructor.
+// Keys and values are stored as raw bytes, they have to be trivially copyable.
+// I/O errors do not throw, they're sticky and reported by failed().
+template<typename TKey, typename TValue,
+	class THashFunc		= rde::hash<TKey>,
+	class TKeyEqualFunc	= rde::equal_to<TKey>,
+	class TAllocator	= rde::allocator
+>
+class external_hash_map
+{
+public:
+	typedef TKey															key_type;
+	typedef TValue															mapped_type;
+	typedef TAllocator														allocator_type;
+	typedef size_t															size_type;
+	typedef hash_map<TKey, TValue, THashFunc, TKeyEqualFunc, TAllocator>	partition_map;
+
+	static_assert(std::is_trivially_copyable<TKey>::value && std::is_trivially_copyable<TValue>::value,
+		"external_hash_map requires trivially copyable keys and values");
+
+	static const size_type	kRecordSize = sizeof(TKey) + sizeof(TValue);
+	static const size_type	kIOBufferSize = 256 * 1024;
+
+	// @param num_partitions	power-of-two, more partitions == smaller I/O units.
+	// @param memory_budget		max. bytes of buckets kept resident (at least one
+	//							partition is always resident, though).
+	external_hash_map(const char* file_prefix, size_type num_partitions, size_type memory_budget,
+		const allocator_type& allocator = allocator_type())
+		: m_filePrefix(file_prefix),
+		m_partitions(allocator),
+		m_partitionShift(32),
+		m_memoryBudget(memory_budget),
+		m_residentBytes(0),
+		m_size(0),
+		m_clock(0),
+		m_numReads(0),
+		m_numWrites(0),
+		m_failed(false),
+		m_allocator(allocator)
+	{
+		RDE_ASSERT(num_partitions > 0 && (num_partitions & (num_partitions - 1)) == 0);
+		for (size_type n = num_partitions; n > 1; n >>= 1)
+			--m_partitionShift;
+		m_partitions.resize(num_partitions);
+		m_ioBuffer = static_cast<unsigned char*>(m_allocator.allocate(kIOBufferSize));
+	}
+	~external_hash_map()
+	{
+		char path[kMaxPath];
+		for (size_type i = 0; i < m_partitions.size(); ++i)
+		{
+			drop(m_partitions[i]);
+			if (m_partitions[i].onDisk)
+				std::remove(partition_path(i, path));
+		}
+		m_allocator.deallocate(m_ioBuffer, kIOBufferSize);
+	}
+
+	// Inserts new element or overwrites value of existing one.
+	// @return true if new element was inserted.
+	bool insert(const key_type& key, const mapped_type& value)
+	{
+		partition& p = acquire(partition_of(key));
+		if (p.map == 0)
+			return false;
+		const size_type bytesBefore = p.map->used_memory();
+		rde::pair<typename partition_map::iterator, bool> r = p.map->insert(rde::make_pair(key, value));
+		if (!r.second)
+			r.first->second = value;
+		else
+			++m_size;
+		p.dirty = true;
+		m_residentBytes += p.map->used_memory() - bytesBefore;
+		enforce_budget(&p);
+		return r.second;
+	}
+	bool find(const key_type& key, mapped_type& out_value)
+	{
+		partition& p = acquire(partition_of(key));
+		if (p.map == 0)
+			return false;
+		typename partition_map::const_iterator it = p.map->find(key);
+		if (it == p.map->end())
+			return false;
+		out_value = it->second;
+		return true;
+	}
+	bool erase(const key_type& key)
+	{
+		partition& p = acquire(partition_of(key));
+		if (p.map == 0 || p.map->erase(key) == 0)
+			return false;
+		--m_size;
+		p.dirty = true;
+		return true;
+	}
+
+	// Calls f(key, value) for every element. Cold partitions are streamed
+	// straight from disk, without making them resident.
+	template<class TFunc>
+	void for_each(TFunc& f)
+	{
+		for (size_type i = 0; i < m_partitions.size(); ++i)
+		{
+			partition& p = m_partitions[i];
+			if (p.map != 0)
+			{
+				for (typename partition_map::const_iterator it = p.map->begin(); it != p.map->end(); ++it)
+					f(it->first, it->second);
+			}
+			else if (p.onDisk)
+			{
+				stream_in(i, f);
+			}
+		}
+	}
+	// Writes all modified resident partitions to disk (they stay resident).
+	bool flush()
+	{
+		for (size_type i = 0; i < m_partitions.size(); ++i)
+		{
+			if (m_partitions[i].map != 0 && m_partitions[i].dirty)
+				write_partition(i);
+		}
+		return !m_failed;
+	}
+
+	// Partition given key belongs to. Sorting/batching work by it minimizes I/O.
+	size_type partition_of(const key_type& key) const
+	{
+		const std::uint32_t h = static_cast<std::uint32_t>(m_hashFunc(key));
+		return m_partitionShift == 32 ? 0 : size_type(h >> m_partitionShift);
+	}
+
+	size_type size() const					{ return m_size; }
+	bool empty() const						{ return m_size == 0; }
+	size_type partition_count() const		{ return m_partitions.size(); }
+	size_type resident_bytes() const		{ return m_residentBytes; }
+	size_type resident_partition_count() const
+	{
+		size_type n(0);
+		for (size_type i = 0; i < m_partitions.size(); ++i)
+			n += (m_partitions[i].map != 0);
+		return n;
+	}
+	// Number of partition loads/stores so far.
+	size_type read_count() const			{ return m_numReads; }
+	size_type write_count() const			{ return m_numWrites; }
+	bool failed() const						{ return m_failed; }
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	static const size_type	kMaxPath = 512;
+
+	struct partition
+	{
+		partition(): map(0), count(0), lastUse(0), dirty(false), onDisk(false) {}
+
+		partition_map*	map;
+		// Number of elements in file (valid if onDisk).
+		size_type		count;
+		std::uint64_t	lastUse;
+		bool			dirty;
+		bool			onDisk;
+	};
+
+	external_hash_map(const external_hash_map&);
+	external_hash_map& operator=(const external_hash_map&);
+
+	const char* partition_path(size_type index, char* path) const
+	{
+		std::snprintf(path, kMaxPath, "%s.%u", m_filePrefix.c_str(), static_cast<unsigned int>(index));
+		return path;
+	}
+
+	// Makes partition resident.
+	// @return partition, with map == 0 if it could not be loaded.
+	partition& acquire(size_type index)
+	{
+		partition& p = m_partitions[index];
+		p.lastUse = ++m_clock;
+		if (p.map != 0)
+			return p;
+
+		p.map = static_cast<partition_map*>(m_allocator.allocate(sizeof(partition_map)));
+		::new (static_cast<void*>(p.map)) partition_map(m_allocator);
+		if (p.onDisk)
+		{
+			p.map->reserve(p.count + p.count / 4);
+			partition_loader loader(*p.map);
+			if (!stream_in(index, loader))
+			{
+				// Never counted as resident.
+				free_map(p);
+				return p;
+			}
+		}
+		m_residentBytes += p.map->used_memory();
+		enforce_budget(&p);
+		return p;
+	}
+	// Evicts LRU partitions until resident buckets fit in the budget.
+	// If modified partition can't be written, it stays resident (over budget)
+	// and failed() is set, so nothing is lost.
+	void enforce_budget(const partition* keep)
+	{
+		while (m_residentBytes > m_memoryBudget)
+		{
+			size_type victim = m_partitions.size();
+			for (size_type i = 0; i < m_partitions.size(); ++i)
+			{
+				const partition& p = m_partitions[i];
+				if (p.map != 0 && &p != keep && (victim == m_partitions.size() || p.lastUse < m_partitions[victim].lastUse))
+					victim = i;
+			}
+			if (victim == m_partitions.size())
+				break;
+			if (m_partitions[victim].dirty && !write_partition(victim))
+				break;
+			drop(m_partitions[victim]);
+		}
+	}
+	void drop(partition& p)
+	{
+		if (p.map == 0)
+			return;
+		m_residentBytes -= p.map->used_memory();
+		free_map(p);
+	}
+	void free_map(partition& p)
+	{
+		p.map->~partition_map();
+		m_allocator.deallocate(p.map, sizeof(partition_map));
+		p.map = 0;
+	}
+
+	bool write_partition(size_type index)
+	{
+		partition& p = m_partitions[index];
+		RDE_ASSERT(p.map != 0);
+		char path[kMaxPath];
+		if (p.map->empty())
+		{
+			if (p.onDisk)
+				std::remove(partition_path(index, path));
+			p.onDisk = false;
+			p.count = 0;
+			p.dirty = false;
+			return true;
+		}
+		std::FILE* f = std::fopen(partition_path(index, path), "wb");
+		if (f == 0)
+		{
+			m_failed = true;
+			return false;
+		}
+		size_type bufferUsed(0);
+		bool ok(true);
+		for (typename partition_map::const_iterator it = p.map->begin(); it != p.map->end() && ok; ++it)
+		{
+			if (bufferUsed + kRecordSize > kIOBufferSize)
+			{
+				ok = (std::fwrite(m_ioBuffer, 1, bufferUsed, f) == bufferUsed);
+				bufferUsed = 0;
+			}
+			Sys::MemCpy(m_ioBuffer + bufferUsed, &it->first, sizeof(TKey));
+			Sys::MemCpy(m_ioBuffer + bufferUsed + sizeof(TKey), &it->second, sizeof(TValue));
+			bufferUsed += kRecordSize;
+		}
+		if (ok && bufferUsed != 0)
+			ok = (std::fwrite(m_ioBuffer, 1, bufferUsed, f) == bufferUsed);
+		ok = (std::fclose(f) == 0) && ok;
+		if (!ok)
+		{
+			m_failed = true;
+			return false;
+		}
+		p.onDisk = true;
+		p.count = p.map->size();
+		p.dirty = false;
+		++m_numWrites;
+		return true;
+	}
+
+	struct partition_loader
+	{
+		explicit partition_loader(partition_map& map): m_map(map) {}
+		void operator()(const key_type& key, const mapped_type& value)
+		{
+			m_map.insert(rde::make_pair(key, value));
+		}
+		partition_map&	m_map;
+	};
+	// Reads partition file sequentially, calling f(key, value) for every record.
+	template<class TFunc>
+	bool stream_in(size_type index, TFunc& f)
+	{
+		char path[kMaxPath];
+		std::FILE* file = std::fopen(partition_path(index, path), "rb");
+		if (file == 0)
+		{
+			m_failed = true;
+			return false;
+		}
+		const size_type recordsPerRead = kIOBufferSize / kRecordSize;
+		size_type numRecords(0);
+		for (;;)
+		{
+			const size_type bytesRead = std::fread(m_ioBuffer, 1, recordsPerRead * kRecordSize, file);
+			const size_type recordsRead = bytesRead / kRecordSize;
+			for (size_type i = 0; i < recordsRead; ++i)
+			{
+				// Copy out, buffer is not necessarily aligned for TKey/TValue.
+				key_type key;
+				mapped_type value;
+				Sys::MemCpy(&key, m_ioBuffer + i * kRecordSize, sizeof(TKey));
+				Sys::MemCpy(&value, m_ioBuffer + i * kRecordSize + sizeof(TKey), sizeof(TValue));
+				f(key, value);
+			}
+			numRecords += recordsRead;
+			if (bytesRead < recordsPerRead * kRecordSize)
+				break;
+		}
+		std::fclose(file);
+		++m_numReads;
+		if (numRecords != m_partitions[index].count)
+		{
+			m_failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	rde::string							m_filePrefix;
+	rde::vector<partition, TAllocator>	m_partitions;
+	unsigned char*						m_ioBuffer;
+	int									m_partitionShift;
+	size_type							m_memoryBudget;
+	size_type							m_residentBytes;
+	size_type							m_size;
+	std::uint64_t						m_clock;
+	size_type							m_numReads;
+	size_type							m_numWrites;
+	bool								m_failed;
+	THashFunc							m_hashFunc;
+	TAllocator							m_allocator;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_EXTERNAL_HASH_MAP_H
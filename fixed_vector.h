@@ -43,8 +43,10 @@ struct fixed_vector_storage
 		// Copy old data if needed.
 		if (m_begin)
 		{
-			rde::copy_construct_n(m_begin, newSize, newBegin);
-			destroy(m_begin, oldSize);
+			rde::relocate_n(m_begin, newSize, newBegin);
+			rde::destruct_n(m_begin + newSize, oldSize - newSize);
+			if ((etype_t*)m_begin != &m_data[0])
+				m_allocator.deallocate(m_begin, (m_capacityEnd - m_begin) * sizeof(T));
 		}
 		m_begin = newBegin;
 		m_end = m_begin + newSize;
@@ -75,9 +77,10 @@ struct fixed_vector_storage
 	}
 	RDE_FORCEINLINE void destroy(T* ptr, base_vector::size_type n)
 	{
+		RDE_ASSERT(ptr == m_begin);
 		rde::destruct_n(ptr, n);
 		if ((etype_t*)ptr != &m_data[0])
-			m_allocator.deallocate(ptr, n * sizeof(T));
+			m_allocator.deallocate(ptr, (m_capacityEnd - m_begin) * sizeof(T));
 	}
 	bool invariant() const
 	{
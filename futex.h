@@ -0,0 +1,60 @@
+#ifndef RDESTL_FUTEX_H
+#define RDESTL_FUTEX_H
+
+#include <atomic>
+#include "rdestl_common.h"
+
+#if defined(_WIN32)
+#	include <windows.h>
+#	pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#else
+#	include <thread>
+#endif
+
+namespace rde
+{
+// Address based wait/wake (futex on Linux, WaitOnAddress on Windows,
+// yield loop elsewhere). Used to put threads to sleep in blocking containers.
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "atomic must be layout compatible");
+
+// Blocks while *addr == expected. May return spuriously, callers re-check.
+inline void futex_wait(std::atomic<std::uint32_t>* addr, std::uint32_t expected)
+{
+#if defined(_WIN32)
+	WaitOnAddress(addr, &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+	syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+#else
+	while (addr->load(std::memory_order_acquire) == expected)
+		std::this_thread::yield();
+#endif
+}
+inline void futex_wake_one(std::atomic<std::uint32_t>* addr)
+{
+#if defined(_WIN32)
+	WakeByAddressSingle(addr);
+#elif defined(__linux__)
+	syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAKE_PRIVATE, 1, 0, 0, 0);
+#else
+	(void)addr;
+#endif
+}
+inline void futex_wake_all(std::atomic<std::uint32_t>* addr)
+{
+#if defined(_WIN32)
+	WakeByAddressAll(addr);
+#elif defined(__linux__)
+	syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAKE_PRIVATE, 0x7FFFFFFF, 0, 0, 0);
+#else
+	(void)addr;
+#endif
+}
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_FUTEX_H
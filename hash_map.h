@@ -1,8 +1,10 @@
 #ifndef RDESTL_HASH_MAP_H
 #define RDESTL_HASH_MAP_H
 
+#include <atomic>
 #include <utility>
 #include <tuple> // TODO use own tuple?
+#include <type_traits>
 
 #include "pair.h"
 #include "algorithm.h"
@@ -13,29 +15,83 @@
 
 namespace rde
 {
+namespace internal
+{
+	// Per-node generation tag. Empty (and free) unless generational clear is enabled.
+	template<bool TGenerational>
+	struct hash_node_generation
+	{
+		RDE_FORCEINLINE bool is_stale(std::uint32_t) const	{ return false; }
+		RDE_FORCEINLINE void set_generation(std::uint32_t)	{ /**/ }
+	};
+	template<>
+	struct hash_node_generation<true>
+	{
+		RDE_FORCEINLINE bool is_stale(std::uint32_t gen) const	{ return generation != gen; }
+		RDE_FORCEINLINE void set_generation(std::uint32_t gen)	{ generation = gen; }
+
+		std::uint32_t	generation;
+	};
+
+	// Claims unused slot for given hash, safe to call from many threads at once.
+	// @note: node::hash is a plain hash_value_t, it's accessed through
+	// std::atomic<hash_value_t> (only during parallel rehash), so both have to
+	// share size, alignment and atomic has to be lock-free (no hidden lock).
+	RDE_FORCEINLINE bool try_claim_hash(hash_value_t* slot, hash_value_t unusedHash, hash_value_t hash)
+	{
+		static_assert(sizeof(std::atomic<hash_value_t>) == sizeof(hash_value_t), "atomic hash must be layout compatible");
+		static_assert(alignof(std::atomic<hash_value_t>) == alignof(hash_value_t), "atomic hash must be layout compatible");
+		static_assert(ATOMIC_LONG_LOCK_FREE == 2, "atomic hash must always be lock-free");
+		std::atomic<hash_value_t>* atomicSlot = reinterpret_cast<std::atomic<hash_value_t>*>(slot);
+		hash_value_t expected = unusedHash;
+		return atomicSlot->load(std::memory_order_relaxed) == unusedHash &&
+			atomicSlot->compare_exchange_strong(expected, hash, std::memory_order_relaxed);
+	}
+} // namespace internal
+
+// Opt-in hook for parallel rehashing of big tables (see hash_map::set_rehash_executor).
+// run() must call task(task_context, i) for every i in [0, num_tasks), in any order
+// and on any threads, and return only once all of them have finished.
+struct rehash_executor
+{
+	typedef void (*task_func)(void* task_context, size_t index);
+	typedef void (*run_func)(void* user_data, task_func task, void* task_context, size_t num_tasks);
+
+	run_func	run;
+	void*		user_data;
+	// Tables with less elements are rehashed serially.
+	size_t		min_elements;
+};
 
 // Load factor is 7/8th.
+// TGenerationalClear: nodes are tagged with a generation and clear() simply bumps
+// current one (nodes from older generations are considered unused), so it's O(1)
+// instead of touching whole table. Only for trivially destructible keys/values.
 template<typename TKey, typename TValue,
 	class THashFunc		= rde::hash<TKey>,
 	class TKeyEqualFunc	= rde::equal_to<TKey>,
-	class TAllocator	= rde::allocator
+	class TAllocator	= rde::allocator,
+	bool TGenerationalClear = false
 >
 class hash_map
 {
 public:
 	typedef rde::pair<TKey, TValue>         value_type;
 
+	static_assert(!TGenerationalClear || std::is_trivially_destructible<value_type>::value,
+		"generational clear requires trivially destructible elements");
+
 //private:
-	struct node
+	struct node: public internal::hash_node_generation<TGenerationalClear>
 	{
 		static const hash_value_t kUnusedHash       = 0xFFFFFFFF;
 		static const hash_value_t kDeletedHash      = 0xFFFFFFFE;
 
 		node(): hash(kUnusedHash) {}
 
-		RDE_FORCEINLINE bool is_unused() const		{ return hash == kUnusedHash; }
-		RDE_FORCEINLINE bool is_deleted() const		{ return hash == kDeletedHash; }
-		RDE_FORCEINLINE bool is_occupied() const	{ return hash < kDeletedHash; }
+		RDE_FORCEINLINE bool is_unused(std::uint32_t gen) const		{ return hash == kUnusedHash || this->is_stale(gen); }
+		RDE_FORCEINLINE bool is_deleted(std::uint32_t gen) const	{ return hash == kDeletedHash && !this->is_stale(gen); }
+		RDE_FORCEINLINE bool is_occupied(std::uint32_t gen) const	{ return hash < kDeletedHash && !this->is_stale(gen); }
 
 		hash_value_t    hash;
 		value_type      data;
@@ -93,7 +149,7 @@ public:
 			TNodePtr nodeEnd = m_map->m_nodes + m_map->bucket_count();
 			for (; m_node < nodeEnd; ++m_node)
 			{
-				if (m_node->is_occupied())
+				if (m_node->is_occupied(m_map->m_generation))
 					break;
 			}
 		}
@@ -118,7 +174,9 @@ public:
 		m_size(0),
 		m_capacity(0),
 		m_capacityMask(0),
-		m_numUsed(0)
+		m_generation(0),
+		m_numUsed(0),
+		m_rehashExecutor(0)
 	{
 		RDE_ASSERT((kInitialCapacity & (kInitialCapacity - 1)) == 0);	// Must be power-of-two
 	}
@@ -127,7 +185,9 @@ public:
 		m_size(0),
 		m_capacity(0),
 		m_capacityMask(0),
+		m_generation(0),
 		m_numUsed(0),
+		m_rehashExecutor(0),
 		m_allocator(allocator)
 	{
 		/**/
@@ -137,7 +197,9 @@ public:
 		m_size(0),
 		m_capacity(0),
 		m_capacityMask(0),
+		m_generation(0),
 		m_numUsed(0),
+		m_rehashExecutor(0),
 		m_allocator(allocator)
 	{
 		reserve(initial_bucket_count);
@@ -147,7 +209,9 @@ public:
 		m_size(0),
 		m_capacity(0),
 		m_capacityMask(0),
+		m_generation(0),
 		m_numUsed(0),
+		m_rehashExecutor(0),
 		m_hashFunc(hashFunc),
 		m_allocator(allocator)
 	{
@@ -158,7 +222,9 @@ public:
 		m_size(0),
 		m_capacity(0),
 		m_capacityMask(0),
+		m_generation(0),
 		m_numUsed(0),
+		m_rehashExecutor(0),
 		m_allocator(allocator)
 	{
 		*this = rhs;
@@ -193,7 +259,7 @@ public:
 	{
 		hash_value_t hash;
 		node* n = find_for_insert(key, &hash);
-		if (n == 0 || !n->is_occupied())
+		if (n == 0 || !n->is_occupied(m_generation))
 		{
 			return insert_at(value_type(key, TValue()), n, hash).first->second;
 		}
@@ -213,7 +279,7 @@ public:
 				m_capacity = rhs.bucket_count();
 				m_capacityMask = m_capacity - 1;
 			}
-			rehash(m_capacity, m_nodes, rhs.m_capacity, rhs.m_nodes, false);
+			rehash(m_capacity, m_nodes, m_generation, rhs.m_capacity, rhs.m_nodes, rhs.m_generation, false);
 			m_size = rhs.size();
 			m_numUsed = rhs.m_numUsed;
 		}
@@ -230,9 +296,11 @@ public:
 			rde::swap(m_size, rhs.m_size);
 			rde::swap(m_capacity, rhs.m_capacity);
 			rde::swap(m_capacityMask, rhs.m_capacityMask);
+			rde::swap(m_generation, rhs.m_generation);
 			rde::swap(m_numUsed, rhs.m_numUsed);
 			rde::swap(m_hashFunc, rhs.m_hashFunc);
 			rde::swap(m_keyEqualFunc, rhs.m_keyEqualFunc);
+			rde::swap(m_rehashExecutor, rhs.m_rehashExecutor);
 			RDE_ASSERT(invariant());
 		}
 	}
@@ -257,7 +325,7 @@ public:
 	size_type erase(const key_type& key)
 	{
 		node* n = lookup(key);
-		if (n != (m_nodes + m_capacity) && n->is_occupied())
+		if (n != (m_nodes + m_capacity) && n->is_occupied(m_generation))
 		{
 			erase_node(n);
 			return 1;
@@ -278,7 +346,7 @@ public:
 		for (; from != to; ++from)
 		{
 			node* n = from.node();
-			if (n->is_occupied())
+			if (n->is_occupied(m_generation))
 				erase_node(n);
 		}
 	}
@@ -294,22 +362,10 @@ public:
 		return const_iterator(n, this);
 	}
 
+	// @note:	O(1) if TGenerationalClear is set, O(bucket_count()) otherwise.
 	void clear()
 	{
-		node* endNode = m_nodes + m_capacity;
-		for (node* iter = m_nodes; iter != endNode; ++iter)
-		{
-			if (iter)
-			{
-				if (iter->is_occupied())
-				{
-					rde::destruct(&iter->data);
-				}
-				// We can make them unused, because we clear whole hash_map,
-				// so we can guarantee there'll be no holes.
-				iter->hash = node::kUnusedHash;
-			}
-		}
+		clear_nodes(int_to_type<TGenerationalClear>());
 		m_size = 0;
 		m_numUsed = 0;
 	}
@@ -332,6 +388,12 @@ public:
 	const allocator_type& get_allocator() const	{ return m_allocator; }
 	void set_allocator(const allocator_type& allocator) { m_allocator = allocator; }
 
+	// Extension: growing tables with at least executor->min_elements elements will
+	// rehash in parallel, using given executor. Executor is not owned (nor copied
+	// by operator=), it has to outlive the map. Pass 0 to go back to serial rehash.
+	void set_rehash_executor(const rehash_executor* executor) { m_rehashExecutor = executor; }
+	const rehash_executor* get_rehash_executor() const { return m_rehashExecutor; }
+
 private:
 	void grow()
 	{
@@ -342,7 +404,10 @@ private:
 	{
 		RDE_ASSERT((new_capacity & (new_capacity - 1)) == 0);	// Must be power-of-two
 		node* newNodes = allocate_nodes(new_capacity);
-		rehash(new_capacity, newNodes, m_capacity, m_nodes, true);
+		if (m_rehashExecutor != 0 && m_size >= m_rehashExecutor->min_elements && m_size != 0)
+			parallel_rehash(*m_rehashExecutor, new_capacity, newNodes, m_capacity, m_nodes, m_generation);
+		else
+			rehash(new_capacity, newNodes, m_generation, m_capacity, m_nodes, m_generation, true);
 		if (m_nodes != &ms_emptyNode)
 			m_allocator.deallocate(m_nodes, sizeof(node) * m_capacity);
 		m_capacity = new_capacity;
@@ -356,12 +421,12 @@ private:
 	rde::pair<iterator, bool> emplace_at(node* n, hash_value_t hash, K&& key, Args&&... args)
 	{
 		typedef rde::pair<iterator, bool> ret_type_t;
-		if (n->is_occupied())
+		if (n->is_occupied(m_generation))
 		{
 			RDE_ASSERT(hash == n->hash && m_keyEqualFunc(key, n->data.first));
 			return ret_type_t(iterator(n, this), false);
 		}
-		if (n->is_unused())
+		if (n->is_unused(m_generation))
 		{
 			++m_numUsed;
 		}
@@ -369,6 +434,7 @@ private:
 			std::forward<K>(key),
 			std::forward<Args>(args)...);
 		n->hash = hash;
+		n->set_generation(m_generation);
 		++m_size;
 		RDE_ASSERT(invariant());
 		return ret_type_t(iterator(n, this), true);
@@ -380,7 +446,7 @@ private:
 		if (n == 0 || m_numUsed * 8 >= m_capacity * 7)
 			return insert(v);
 
-		RDE_ASSERT(!n->is_occupied());
+		RDE_ASSERT(!n->is_occupied(m_generation));
 		return emplace_at(n, hash, v.first, v.second);
 	}
 	node* find_for_insert(const key_type& key, hash_value_t* out_hash)
@@ -393,22 +459,22 @@ private:
 		std::uint32_t i = hash & m_capacityMask;
 
 		node* n = m_nodes + i;
-		if (n->hash == hash && m_keyEqualFunc(key, n->data.first))
+		if (compare_key(n, key, hash))
 			return n;
 
 		node* freeNode(0);
-		if (n->is_deleted())
+		if (n->is_deleted(m_generation))
 			freeNode = n;
 		std::uint32_t numProbes(1);
 		// Guarantees loop termination.
 		RDE_ASSERT(m_numUsed < m_capacity);
-		while (!n->is_unused())
+		while (!n->is_unused(m_generation))
 		{
 			i = (i + numProbes) & m_capacityMask;
 			n = m_nodes + i;
 			if (compare_key(n, key, hash))
 				return n;
-			if (n->is_deleted() && freeNode == 0)
+			if (n->is_deleted(m_generation) && freeNode == 0)
 				freeNode = n;
 			++numProbes;
 		}
@@ -419,13 +485,13 @@ private:
 		const hash_value_t hash = hash_func(key);
 		std::uint32_t i = hash & m_capacityMask;
 		node* n = m_nodes + i;
-		if (n->hash == hash && m_keyEqualFunc(key, n->data.first))
+		if (compare_key(n, key, hash))
 			return n;
 
 		std::uint32_t numProbes(1);
 		// Guarantees loop termination.
 		RDE_ASSERT(m_capacity == 0 || m_numUsed < m_capacity);
-		while (!n->is_unused())
+		while (!n->is_unused(m_generation))
 		{
 			i = (i + numProbes) & m_capacityMask;
 			n = m_nodes + i;
@@ -438,7 +504,8 @@ private:
 		return m_nodes + m_capacity;
 	}
 
-	static void rehash(size_t new_capacity, node* new_nodes, size_t capacity, const node* nodes, bool destruct_original)
+	static void rehash(size_t new_capacity, node* new_nodes, std::uint32_t new_generation,
+		size_t capacity, const node* nodes, std::uint32_t generation, bool destruct_original)
 	{
 		//if (nodes == &ms_emptyNode || new_nodes == &ms_emptyNode)
 		//  return;
@@ -448,14 +515,14 @@ private:
 		const std::uint32_t mask = new_capacity - 1;
 		while (it != itEnd)
 		{
-			if (it->is_occupied())
+			if (it->is_occupied(generation))
 			{
 				const hash_value_t hash = it->hash;
 				std::uint32_t i = hash & mask;
 
 				node* n = new_nodes + i;
 				std::uint32_t numProbes(0);
-				while (!n->is_unused())
+				while (!n->is_unused(new_generation))
 				{
 					++numProbes;
 					i = (i + numProbes) & mask;
@@ -468,19 +535,70 @@ private:
 				// Both would bloat the code a bit.
 				if (destruct_original)
 				{
-					rde::construct_args(&n->data, std::move(it->data));
-					rde::destruct(&it->data);
+					rde::relocate(&n->data, &it->data);
 				}
 				else
 				{
 					rde::copy_construct(&n->data, it->data);
 				}
 				n->hash = hash;
+				n->set_generation(new_generation);
 			}
 			++it;
 		}
 	}
 
+	struct parallel_rehash_context
+	{
+		node*			new_nodes;
+		size_t			new_capacity;
+		const node*		nodes;
+		size_t			capacity;
+		size_t			range_size;
+		std::uint32_t	generation;
+	};
+	// Each task moves one range of the old table. Slots in the new table are claimed
+	// with CAS on node::hash, so tasks never construct into the same node.
+	static void parallel_rehash_task(void* task_context, size_t index)
+	{
+		const parallel_rehash_context& ctx = *static_cast<const parallel_rehash_context*>(task_context);
+		const size_t first = index * ctx.range_size;
+		const size_t last = rde::min(first + ctx.range_size, ctx.capacity);
+		const std::uint32_t mask = ctx.new_capacity - 1;
+		for (node* it = const_cast<node*>(ctx.nodes) + first, *itEnd = const_cast<node*>(ctx.nodes) + last; it != itEnd; ++it)
+		{
+			if (!it->is_occupied(ctx.generation))
+				continue;
+
+			const hash_value_t hash = it->hash;
+			std::uint32_t i = hash & mask;
+			node* n = ctx.new_nodes + i;
+			std::uint32_t numProbes(0);
+			while (!internal::try_claim_hash(&n->hash, node::kUnusedHash, hash))
+			{
+				++numProbes;
+				i = (i + numProbes) & mask;
+				n = ctx.new_nodes + i;
+			}
+			rde::relocate(&n->data, &it->data);
+			n->set_generation(ctx.generation);
+		}
+	}
+	static void parallel_rehash(const rehash_executor& executor, size_t new_capacity, node* new_nodes,
+		size_t capacity, const node* nodes, std::uint32_t generation)
+	{
+		static const size_t kRangeSize = 16 * 1024;
+		parallel_rehash_context ctx;
+		ctx.new_nodes = new_nodes;
+		ctx.new_capacity = new_capacity;
+		ctx.nodes = nodes;
+		ctx.capacity = capacity;
+		ctx.range_size = kRangeSize;
+		ctx.generation = generation;
+		const size_t numTasks = (capacity + kRangeSize - 1) / kRangeSize;
+		executor.run(executor.user_data, &parallel_rehash_task, &ctx, numTasks);
+	}
+
 	node* allocate_nodes(size_t n)
 	{
 		node* buckets = static_cast<node*>(m_allocator.allocate(n * sizeof(node)));
@@ -496,7 +614,7 @@ private:
 		node* itEnd = it + m_capacity;
 		while (it != itEnd)
 		{
-			if (it && it->is_occupied())
+			if (it && it->is_occupied(m_generation))
 				rde::destruct(&it->data);
 			++it;
 		}
@@ -510,7 +628,7 @@ private:
 	void erase_node(node* n)
 	{
 		RDE_ASSERT(!empty());
-		RDE_ASSERT(n->is_occupied());
+		RDE_ASSERT(n->is_occupied(m_generation));
 		rde::destruct(&n->data);
 		n->hash = node::kDeletedHash;
 		--m_size;
@@ -531,14 +649,48 @@ private:
 
 	RDE_FORCEINLINE bool compare_key(const node* n, const key_type& key, hash_value_t hash) const
 	{
-		return (n->hash == hash && m_keyEqualFunc(key, n->data.first));
+		return (n->hash == hash && !n->is_stale(m_generation) && m_keyEqualFunc(key, n->data.first));
+	}
+
+	void clear_nodes(int_to_type<false>)
+	{
+		node* endNode = m_nodes + m_capacity;
+		for (node* iter = m_nodes; iter != endNode; ++iter)
+		{
+			if (iter)
+			{
+				if (iter->is_occupied(m_generation))
+				{
+					rde::destruct(&iter->data);
+				}
+				// We can make them unused, because we clear whole hash_map,
+				// so we can guarantee there'll be no holes.
+				iter->hash = node::kUnusedHash;
+			}
+		}
+	}
+	void clear_nodes(int_to_type<true>)
+	{
+		if (m_capacity == 0)
+			return;
+		// Everything tagged with previous generation is unused from now on.
+		// Only once per 4G clears we have to sweep the table, so that stale
+		// nodes from 'this' generation (before wrap-around) don't come back to life.
+		if (++m_generation == 0)
+		{
+			node* endNode = m_nodes + m_capacity;
+			for (node* iter = m_nodes; iter != endNode; ++iter)
+				iter->hash = node::kUnusedHash;
+		}
 	}
 
 	node*			m_nodes;
 	size_type		m_size;
 	size_type		m_capacity;
 	std::uint32_t	m_capacityMask;
+	std::uint32_t	m_generation;
 	size_type		m_numUsed;
+	const rehash_executor*	m_rehashExecutor;
 	THashFunc       m_hashFunc;
 	TKeyEqualFunc	m_keyEqualFunc;
 	TAllocator      m_allocator;
@@ -550,9 +702,10 @@ private:
 template<typename TKey, typename TValue,
 	class THashFunc,
 	class TKeyEqualFunc,
-	class TAllocator
+	class TAllocator,
+	bool TGenerationalClear
 >
-typename hash_map<TKey, TValue, THashFunc, TKeyEqualFunc, TAllocator>::node hash_map<TKey, TValue, THashFunc, TKeyEqualFunc, TAllocator>::ms_emptyNode;
+typename hash_map<TKey, TValue, THashFunc, TKeyEqualFunc, TAllocator, TGenerationalClear>::node hash_map<TKey, TValue, THashFunc, TKeyEqualFunc, TAllocator, TGenerationalClear>::ms_emptyNode;
 
 } // namespace rde
 
@@ -0,0 +1,117 @@
+#ifndef RDESTL_INTRUSIVE_MPSC_QUEUE_H
+#define RDESTL_INTRUSIVE_MPSC_QUEUE_H
+
+#include "intrusive_slist.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Unbounded lock-free multi-producer/single-consumer FIFO queue (D. Vyukov's
+// intrusive design). Links elements through intrusive_slist_node, so there
+// are no allocations. Queue doesn't own elements.
+// - any number of threads may push (one exchange, wait-free),
+// - exactly one thread may pop/call empty.
+// Pop may return 0 for a short moment while a producer is in the middle
+// of push (element is linked in, but not reachable yet), consumer will
+// see it on next try.
+// Element can be in one queue/list at a time, node is "not in list" again
+// after it's popped.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<class T>
+class intrusive_mpsc_queue
+{
+public:
+	typedef T		node_type;
+	typedef T		value_type;
+	typedef size_t	size_type;
+
+	intrusive_mpsc_queue()
+	:	m_head(&m_stub),
+		m_tail(&m_stub)
+	{
+		m_stub.next = 0;
+	}
+
+	// Producer side, any thread.
+	void push(value_type* v)
+	{
+		push_node(v);
+	}
+
+	// Consumer side.
+	// @return 0 if queue is empty (or producer hasn't finished its push yet).
+	value_type* pop()
+	{
+		intrusive_slist_node* tail = m_tail;
+		intrusive_slist_node* next = internal::atomic_next(tail).load(std::memory_order_acquire);
+		if (tail == &m_stub)
+		{
+			if (next == 0)
+				return 0;
+			m_tail = next;
+			tail = next;
+			next = internal::atomic_next(next).load(std::memory_order_acquire);
+		}
+		if (next == 0)
+		{
+			// tail is the last element we can see. If someone pushed after it, just
+			// wait for the link, otherwise put stub behind it, so it can be taken.
+			if (tail != m_head.load(std::memory_order_acquire))
+				return 0;
+			push_node(&m_stub);
+			next = internal::atomic_next(tail).load(std::memory_order_acquire);
+			if (next == 0)
+				return 0;
+		}
+		m_tail = next;
+		tail->next = tail;
+		return upcast(tail);
+	}
+	// Pops up to n elements, returns number of elements popped.
+	size_type pop_n(value_type** out, size_type n)
+	{
+		size_type i(0);
+		while (i < n && (out[i] = pop()) != 0)
+			++i;
+		return i;
+	}
+	// Consumer side only.
+	bool empty() const
+	{
+		return m_tail == &m_stub && internal::atomic_next(const_cast<intrusive_slist_node*>(m_tail)).load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	intrusive_mpsc_queue(const intrusive_mpsc_queue&);
+	intrusive_mpsc_queue& operator=(const intrusive_mpsc_queue&);
+
+	void push_node(intrusive_slist_node* n)
+	{
+		internal::atomic_next(n).store(0, std::memory_order_relaxed);
+		intrusive_slist_node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+		internal::atomic_next(prev).store(n, std::memory_order_release);
+	}
+	static RDE_FORCEINLINE value_type* upcast(intrusive_slist_node* n)
+	{
+		return static_cast<value_type*>(n);
+	}
+
+	// Producers and consumer on separate cache lines.
+	// Producers.
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<intrusive_slist_node*>	m_head;
+	// Consumer.
+	alignas(RDE_CACHE_LINE_SIZE) intrusive_slist_node*				m_tail;
+	intrusive_slist_node											m_stub;
+};
+static_assert(alignof(intrusive_mpsc_queue<intrusive_slist_node>) == RDE_CACHE_LINE_SIZE &&
+	sizeof(intrusive_mpsc_queue<intrusive_slist_node>) >= 2 * RDE_CACHE_LINE_SIZE,
+	"intrusive_mpsc_queue producers and consumer should be on separate cache lines");
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_INTRUSIVE_MPSC_QUEUE_H
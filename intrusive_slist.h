@@ -1,6 +1,7 @@
 #ifndef RDESTL_INTRUSIVE_SLIST_H
 #define RDESTL_INTRUSIVE_SLIST_H
 
+#include <atomic>
 #include "iterator.h"
 #include "type_traits.h"
 
@@ -20,6 +21,18 @@ struct intrusive_slist_node
 	intrusive_slist_node*	next;
 };
 
+namespace internal
+{
+	static_assert(sizeof(std::atomic<intrusive_slist_node*>) == sizeof(intrusive_slist_node*),
+		"atomic must be layout compatible");
+	// Lock-free containers (intrusive_mpsc_queue, intrusive_stack) treat
+	// the link as atomic, node can still be moved to intrusive_slist later.
+	RDE_FORCEINLINE std::atomic<intrusive_slist_node*>& atomic_next(intrusive_slist_node* n)
+	{
+		return *reinterpret_cast<std::atomic<intrusive_slist_node*>*>(&n->next);
+	}
+} // namespace internal
+
 //=============================================================================
 template<typename Pointer, typename Reference>
 class intrusive_slist_iterator
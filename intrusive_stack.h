@@ -0,0 +1,122 @@
+#ifndef RDESTL_INTRUSIVE_STACK_H
+#define RDESTL_INTRUSIVE_STACK_H
+
+#include <cstdint>
+#include "intrusive_slist.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Lock-free LIFO stack (Treiber) linking elements through intrusive_slist_node.
+// No allocations, doesn't own elements, any thread may push/pop.
+// ABA: top pointer is stored together with a version tag (upper 16 bits
+// of 64-bit word on 64-bit platforms, that's where user-space pointers have
+// zeroes; 32 bits next to the pointer on 32-bit platforms), bumped on every
+// change, so single 64-bit CAS is enough.
+// @note: pop reads next link of the top node, which may be popped by other
+// thread in the meantime. Memory of elements has to stay readable while
+// stack is in use (pool, free list etc.), don't free it back to the OS.
+template<class T>
+class intrusive_stack
+{
+	typedef std::uint64_t	tagged_ptr;
+public:
+	typedef T		node_type;
+	typedef T		value_type;
+	typedef size_t	size_type;
+
+	intrusive_stack()
+	:	m_top(0)
+	{
+	}
+
+	void push(value_type* v)
+	{
+		push_chain(v, v);
+	}
+	// Pushes already linked (through next) chain of elements, first..last,
+	// with single CAS. first ends up on top.
+	void push_chain(value_type* first, value_type* last)
+	{
+		tagged_ptr top = m_top.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			internal::atomic_next(last).store(get_ptr(top), std::memory_order_relaxed);
+			if (m_top.compare_exchange_weak(top, make(first, top), std::memory_order_release,
+				std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+	}
+	// @return 0 if stack is empty.
+	value_type* pop()
+	{
+		tagged_ptr top = m_top.load(std::memory_order_acquire);
+		for (;;)
+		{
+			intrusive_slist_node* n = get_ptr(top);
+			if (n == 0)
+				return 0;
+			intrusive_slist_node* next = internal::atomic_next(n).load(std::memory_order_relaxed);
+			if (m_top.compare_exchange_weak(top, make(next, top), std::memory_order_acquire,
+				std::memory_order_acquire))
+			{
+				// Other poppers may still read it, their CAS fails (tag changed).
+				internal::atomic_next(n).store(n, std::memory_order_relaxed);
+				return upcast(n);
+			}
+		}
+	}
+	// Takes all elements at once. Returns top, remaining elements can be
+	// reached by next links (last one has next == 0).
+	value_type* pop_all()
+	{
+		tagged_ptr top = m_top.load(std::memory_order_relaxed);
+		while (!m_top.compare_exchange_weak(top, make(0, top), std::memory_order_acquire,
+			std::memory_order_relaxed))
+		{
+		}
+		return upcast(get_ptr(top));
+	}
+
+	// Approximate if other threads are pushing/popping.
+	bool empty_approx() const
+	{
+		return get_ptr(m_top.load(std::memory_order_relaxed)) == 0;
+	}
+
+private:
+	intrusive_stack(const intrusive_stack&);
+	intrusive_stack& operator=(const intrusive_stack&);
+
+	enum
+	{
+		kTagShift	= sizeof(void*) == 8 ? 48 : 32
+	};
+	static const tagged_ptr kPtrMask = (tagged_ptr(1) << kTagShift) - 1;
+
+	// Pointer n, tag of previous value + 1.
+	static RDE_FORCEINLINE tagged_ptr make(intrusive_slist_node* n, tagged_ptr prev)
+	{
+		const tagged_ptr p = tagged_ptr(reinterpret_cast<std::uintptr_t>(n));
+		RDE_ASSERT((p & ~kPtrMask) == 0);
+		return (((prev >> kTagShift) + 1) << kTagShift) | p;
+	}
+	static RDE_FORCEINLINE intrusive_slist_node* get_ptr(tagged_ptr t)
+	{
+		return reinterpret_cast<intrusive_slist_node*>(std::uintptr_t(t & kPtrMask));
+	}
+	static RDE_FORCEINLINE value_type* upcast(intrusive_slist_node* n)
+	{
+		return static_cast<value_type*>(n);
+	}
+
+	std::atomic<tagged_ptr>	m_top;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_INTRUSIVE_STACK_H
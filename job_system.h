@@ -0,0 +1,579 @@
+#ifndef RDESTL_JOB_SYSTEM_H
+#define RDESTL_JOB_SYSTEM_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "allocator.h"
+#include "futex.h"
+#include "intrusive_stack.h"
+#include "mpmc_queue.h"
+#include "vector.h"
+
+namespace rde
+{
+struct job;
+namespace internal
+{
+	struct job_pool;
+}
+
+//=============================================================================
+// Tracks group of jobs. Every job run with given counter increments it,
+// finished job decrements it. Continuations (run_after) are started when
+// it drops to 0. Has to outlive its jobs (job_system::wait guarantees that).
+struct job_counter
+{
+	job_counter(): pending(0), finishing(0), continuations(0) {}
+
+	bool done() const	{ return pending.load(std::memory_order_acquire) == 0; }
+
+	std::atomic<std::uint32_t>	pending;
+	// Number of threads still touching the counter after decrementing it.
+	std::atomic<std::uint32_t>	finishing;
+	std::atomic<job*>			continuations;
+
+private:
+	job_counter(const job_counter&);
+	job_counter& operator=(const job_counter&);
+};
+
+//=============================================================================
+// Two cache lines. Function object is stored in place.
+// Node link (next) is used by free lists/continuation lists.
+struct job: public intrusive_slist_node
+{
+	static const size_t	kSize = 2 * RDE_CACHE_LINE_SIZE;
+	static const size_t	kDataSize = kSize - 4 * sizeof(void*);
+
+	// Calls and destroys function object.
+	void				(*invoke)(job*);
+	job_counter*		counter;
+	// Pool job was allocated from, it's returned there once done.
+	internal::job_pool*	owner;
+	alignas(sizeof(void*) * 2) unsigned char	data[kDataSize];
+};
+static_assert(sizeof(job) == job::kSize, "job should take exactly kSize bytes");
+
+namespace internal
+{
+	//=========================================================================
+	// Jobs allocated by one worker (or by threads that are not workers).
+	struct job_pool
+	{
+		job_pool(): freeJobs(0) {}
+
+		// Owner only.
+		job*					freeJobs;
+		// Full line, pools aren't necessarily cache line aligned.
+		char					pad[RDE_CACHE_LINE_SIZE];
+		// Jobs freed by other threads, owner takes them all back once
+		// freeJobs runs out.
+		intrusive_stack<job>	returned;
+	};
+
+	//=========================================================================
+	// Chase-Lev work stealing deque (fixed size version, from Le et al.,
+	// "Correct and Efficient Work-Stealing for Weak Memory Models").
+	// Owner pushes/pops at the bottom, other threads steal from the top.
+	template<size_t TCapacity>
+	class work_stealing_deque
+	{
+		static_assert((TCapacity & (TCapacity - 1)) == 0, "capacity must be power of two");
+	public:
+		work_stealing_deque(): m_top(0), m_bottom(0)
+		{
+			for (size_t i = 0; i < TCapacity; ++i)
+				m_jobs[i].store(0, std::memory_order_relaxed);
+		}
+
+		// Owner only. False if full.
+		bool push(job* j)
+		{
+			const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+			const std::int64_t t = m_top.load(std::memory_order_acquire);
+			if (b - t >= std::int64_t(TCapacity))
+				return false;
+			m_jobs[b & (TCapacity - 1)].store(j, std::memory_order_relaxed);
+			m_bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+		// Owner only.
+		job* pop()
+		{
+			const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t t = m_top.load(std::memory_order_relaxed);
+			if (t > b)
+			{
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+				return 0;
+			}
+			job* j = m_jobs[b & (TCapacity - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last one, race with thieves.
+				if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					j = 0;
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return j;
+		}
+		// Any thread.
+		job* steal()
+		{
+			std::int64_t t = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return 0;
+			job* j = m_jobs[t & (TCapacity - 1)].load(std::memory_order_relaxed);
+			if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return 0;
+			return j;
+		}
+		// Approximate.
+		size_t size() const
+		{
+			const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+			const std::int64_t t = m_top.load(std::memory_order_relaxed);
+			return b > t ? size_t(b - t) : 0;
+		}
+
+	private:
+		std::atomic<std::int64_t>	m_top;
+		char						m_pad[RDE_CACHE_LINE_SIZE - sizeof(std::atomic<std::int64_t>)];
+		std::atomic<std::int64_t>	m_bottom;
+		std::atomic<job*>			m_jobs[TCapacity];
+	};
+
+	template<class TFunc>
+	void invoke_job(job* j)
+	{
+		TFunc* f = reinterpret_cast<TFunc*>(&j->data[0]);
+		(*f)();
+		f->~TFunc();
+	}
+} // namespace internal
+
+//=============================================================================
+// Work stealing thread pool.
+// - every worker has its own Chase-Lev deque, new jobs go to the bottom of
+//   the current worker's deque (LIFO, cache friendly), idle workers steal
+//   from the top of others' (oldest, usually biggest pieces of work),
+// - threads that are not workers submit through global injection queue,
+// - thread that creates job_system is worker 0, it only runs jobs inside
+//   of wait() (other threads that wait help too, but can only steal). Thread
+//   can be worker 0 of several systems at the same time,
+// - jobs (and captured function objects, up to job::kDataSize bytes) come from
+//   per-worker free lists, refilled from TAllocator in blocks, so steady state
+//   doesn't allocate. Job run by other thread (stolen) is returned to the
+//   worker that allocated it,
+// - idle workers spin for a while, then sleep on a futex.
+// Not copyable. Destroy it when there are no jobs in flight.
+#pragma warning(push)
+// structure was padded due to alignment specifier (injection queue)
+#pragma warning(disable: 4324)
+template<class TAllocator = rde::allocator>
+class basic_job_system
+{
+	static const size_t	kDequeCapacity = 4096;
+	static const size_t	kJobsPerBlock = 64;
+	static const int	kSpinCount = 64;
+
+	typedef vector<void*, TAllocator>	blocks_t;
+
+	struct worker
+	{
+		explicit worker(const TAllocator& allocator)
+			: blocks(allocator),
+			rng(0x9E3779B9u),
+			index(0)
+		{
+		}
+
+		internal::work_stealing_deque<kDequeCapacity>	jobs;
+		internal::job_pool	pool;
+		// Owner only.
+		blocks_t			blocks;
+		std::uint32_t		rng;
+		size_t				index;
+		char				pad[RDE_CACHE_LINE_SIZE];
+	};
+	// Thread's worker, if it's one of the extra threads of this system.
+	struct tls_slot
+	{
+		const basic_job_system*	system;
+		worker*					w;
+	};
+
+public:
+	typedef TAllocator	allocator_type;
+	typedef size_t		size_type;
+
+	// numThreads - number of extra threads, by default one less than
+	// number of hardware threads (creating thread is a worker too).
+	explicit basic_job_system(size_type numThreads = default_num_threads(),
+		const allocator_type& allocator = allocator_type())
+		: m_numWorkers(numThreads + 1),
+		m_injection(1024, allocator),
+		m_numSleeping(0),
+		m_wakeEpoch(0),
+		m_quit(false),
+		m_threads(0),
+		m_owner(std::this_thread::get_id()),
+		m_allocator(allocator),
+		m_external(allocator)
+	{
+		m_workers = static_cast<worker*>(m_allocator.allocate(sizeof(worker) * m_numWorkers));
+		for (size_type i = 0; i < m_numWorkers; ++i)
+		{
+			new (&m_workers[i]) worker(m_allocator);
+			m_workers[i].index = i;
+			m_workers[i].rng += std::uint32_t(i) * 0x85EBCA6Bu;
+		}
+		if (numThreads)
+		{
+			m_threads = static_cast<std::thread*>(m_allocator.allocate(sizeof(std::thread) * numThreads));
+			for (size_type i = 0; i < numThreads; ++i)
+				new (&m_threads[i]) std::thread(&basic_job_system::worker_main, this, &m_workers[i + 1]);
+		}
+	}
+	~basic_job_system()
+	{
+		m_quit.store(true, std::memory_order_seq_cst);
+		m_wakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+		futex_wake_all(&m_wakeEpoch);
+		for (size_type i = 0; i + 1 < m_numWorkers; ++i)
+		{
+			m_threads[i].join();
+			m_threads[i].~thread();
+		}
+		if (m_threads)
+			m_allocator.deallocate(m_threads, sizeof(std::thread) * (m_numWorkers - 1));
+		for (size_type i = 0; i < m_numWorkers; ++i)
+		{
+			free_blocks(m_workers[i]);
+			m_workers[i].~worker();
+		}
+		m_allocator.deallocate(m_workers, sizeof(worker) * m_numWorkers);
+		free_blocks(m_external);
+	}
+
+	static size_type default_num_threads()
+	{
+		const unsigned int n = std::thread::hardware_concurrency();
+		return n > 1 ? n - 1 : 0;
+	}
+	size_type num_workers() const	{ return m_numWorkers; }
+
+	// Starts func() asynchronously, counter is incremented now and decremented
+	// once func is done. Function object is copied into job (has to fit).
+	template<class TFunc>
+	void run(job_counter& counter, const TFunc& func)
+	{
+		job* j = make_job(&counter, func);
+		submit(j);
+	}
+	// Starts func() once dependency drops to 0 (immediately if it's 0 already).
+	// counter (optional) tracks the continuation itself.
+	template<class TFunc>
+	void run_after(job_counter& dependency, job_counter* counter, const TFunc& func)
+	{
+		job* j = make_job(counter, func);
+		job* head = dependency.continuations.load(std::memory_order_relaxed);
+		do
+		{
+			j->next = head;
+		} while (!dependency.continuations.compare_exchange_weak(head, j,
+			std::memory_order_release, std::memory_order_relaxed));
+		// Dependency could've finished before we got here, then it's up to us.
+		if (dependency.pending.load(std::memory_order_seq_cst) == 0)
+			start_continuations(dependency);
+	}
+	// Helps running jobs until counter drops to 0.
+	void wait(job_counter& counter)
+	{
+		worker* w = current_worker();
+		int spins(0);
+		while (counter.pending.load(std::memory_order_acquire) != 0)
+		{
+			if (job* j = find_job(w))
+			{
+				execute(j, w);
+				spins = 0;
+			}
+			else if (++spins > kSpinCount)
+			{
+				std::this_thread::yield();
+			}
+		}
+		// Last finisher may still be reading the counter.
+		while (counter.finishing.load(std::memory_order_acquire) != 0)
+			std::this_thread::yield();
+	}
+
+	// Calls func(first, last) for subranges of [begin, end), returns when all
+	// are done. Ranges are split in halves only while current worker's deque
+	// is (almost) empty, ie. when others could use more work, then processed
+	// in grain sized chunks. grain == 0 - picked automatically.
+	template<class TFunc>
+	void parallel_for(size_type begin, size_type end, const TFunc& func, size_type grain = 0)
+	{
+		if (begin >= end)
+			return;
+		if (grain == 0)
+		{
+			grain = (end - begin) / (m_numWorkers * 8);
+			if (grain == 0)
+				grain = 1;
+		}
+		if (m_numWorkers == 1 || end - begin <= grain)
+		{
+			func(begin, end);
+			return;
+		}
+		job_counter counter;
+		run_range(counter, begin, end, grain, &func);
+		wait(counter);
+	}
+
+private:
+	basic_job_system(const basic_job_system&);
+	basic_job_system& operator=(const basic_job_system&);
+
+	template<class TFunc>
+	void run_range(job_counter& counter, size_type begin, size_type end, size_type grain, const TFunc* func)
+	{
+		run(counter, [this, &counter, begin, end, grain, func]()
+		{
+			split_range(counter, begin, end, grain, func);
+		});
+	}
+	template<class TFunc>
+	void split_range(job_counter& counter, size_type begin, size_type end, size_type grain, const TFunc* func)
+	{
+		worker* w = current_worker();
+		while (begin < end)
+		{
+			if (end - begin > grain && (w == 0 || w->jobs.size() < 2))
+			{
+				const size_type mid = begin + (end - begin) / 2;
+				run_range(counter, mid, end, grain, func);
+				end = mid;
+				continue;
+			}
+			const size_type chunkEnd = (end - begin > grain ? begin + grain : end);
+			(*func)(begin, chunkEnd);
+			begin = chunkEnd;
+		}
+	}
+
+	template<class TFunc>
+	job* make_job(job_counter* counter, const TFunc& func)
+	{
+		static_assert(sizeof(TFunc) <= job::kDataSize, "function object too big for job");
+		static_assert(alignof(TFunc) <= alignof(job), "function object alignment too big for job");
+		job* j = allocate_job(current_worker());
+		new (&j->data[0]) TFunc(func);
+		j->invoke = &internal::invoke_job<TFunc>;
+		j->counter = counter;
+		j->next = 0;
+		if (counter)
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		return j;
+	}
+	void submit(job* j)
+	{
+		worker* w = current_worker();
+		const bool queued = (w ? w->jobs.push(j) : m_injection.try_push(j));
+		if (!queued)
+		{
+			// Queues full, no point in adding more parallelism, just run it.
+			execute(j, w);
+			return;
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_numSleeping.load(std::memory_order_relaxed) != 0)
+		{
+			m_wakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+			futex_wake_one(&m_wakeEpoch);
+		}
+	}
+	job* find_job(worker* w)
+	{
+		job* j(0);
+		if (w && (j = w->jobs.pop()) != 0)
+			return j;
+		if (m_injection.try_pop(j))
+			return j;
+		// Steal, starting from random victim.
+		std::uint32_t r = (w ? next_random(w->rng) : std::uint32_t(reinterpret_cast<uintptr_t>(&j) >> 4));
+		const size_type start = r % m_numWorkers;
+		for (size_type i = 0; i < m_numWorkers; ++i)
+		{
+			worker& victim = m_workers[(start + i) % m_numWorkers];
+			if (&victim != w && (j = victim.jobs.steal()) != 0)
+				return j;
+		}
+		return 0;
+	}
+	void execute(job* j, worker* w)
+	{
+		j->invoke(j);
+		job_counter* counter = j->counter;
+		free_job(j, w);
+		if (counter)
+		{
+			counter->finishing.fetch_add(1, std::memory_order_relaxed);
+			if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				start_continuations(*counter);
+			counter->finishing.fetch_sub(1, std::memory_order_release);
+		}
+	}
+	void start_continuations(job_counter& counter)
+	{
+		job* j = counter.continuations.exchange(0, std::memory_order_acquire);
+		while (j)
+		{
+			job* next = static_cast<job*>(j->next);
+			j->next = 0;
+			submit(j);
+			j = next;
+		}
+	}
+
+	void worker_main(worker* w)
+	{
+		bind_thread(w);
+		while (!m_quit.load(std::memory_order_relaxed))
+		{
+			job* j = find_job(w);
+			for (int i = 0; j == 0 && i < kSpinCount; ++i)
+			{
+				std::this_thread::yield();
+				j = find_job(w);
+			}
+			if (j == 0)
+			{
+				const std::uint32_t epoch = m_wakeEpoch.load(std::memory_order_seq_cst);
+				m_numSleeping.fetch_add(1, std::memory_order_seq_cst);
+				// Re-check, submitter might've missed us.
+				j = find_job(w);
+				if (j == 0 && !m_quit.load(std::memory_order_seq_cst))
+					futex_wait(&m_wakeEpoch, epoch);
+				m_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+			}
+			if (j)
+				execute(j, w);
+		}
+		bind_thread(0);
+	}
+
+	job* allocate_job(worker* w)
+	{
+		if (w == 0)
+		{
+			std::lock_guard<std::mutex> lock(m_externalLock);
+			return pop_free_job(m_external);
+		}
+		return pop_free_job(*w);
+	}
+	void free_job(job* j, worker* w)
+	{
+		internal::job_pool& pool = (w ? w->pool : m_external.pool);
+		if (j->owner != &pool)
+		{
+			// Keeping it would grow our free list, while owner keeps allocating.
+			j->owner->returned.push(j);
+			return;
+		}
+		if (w == 0)
+		{
+			std::lock_guard<std::mutex> lock(m_externalLock);
+			j->next = pool.freeJobs;
+			pool.freeJobs = j;
+			return;
+		}
+		j->next = pool.freeJobs;
+		pool.freeJobs = j;
+	}
+	job* pop_free_job(worker& w)
+	{
+		internal::job_pool& pool = w.pool;
+		if (pool.freeJobs == 0)
+			pool.freeJobs = pool.returned.pop_all();
+		if (pool.freeJobs == 0)
+		{
+			job* block = static_cast<job*>(m_allocator.allocate(sizeof(job) * kJobsPerBlock));
+			w.blocks.push_back(block);
+			for (size_type i = 0; i < kJobsPerBlock; ++i)
+			{
+				new (&block[i]) job;
+				block[i].owner = &pool;
+				block[i].next = pool.freeJobs;
+				pool.freeJobs = &block[i];
+			}
+		}
+		job* j = pool.freeJobs;
+		pool.freeJobs = static_cast<job*>(j->next);
+		return j;
+	}
+	void free_blocks(worker& w)
+	{
+		for (typename blocks_t::iterator it = w.blocks.begin(); it != w.blocks.end(); ++it)
+			m_allocator.deallocate(*it, sizeof(job) * kJobsPerBlock);
+		w.blocks.clear();
+		w.pool.freeJobs = 0;
+		w.pool.returned.pop_all();
+	}
+
+	static tls_slot& tls()
+	{
+		static thread_local tls_slot s_slot = { 0, 0 };
+		return s_slot;
+	}
+	void bind_thread(worker* w)
+	{
+		tls().system = (w ? this : 0);
+		tls().w = w;
+	}
+	worker* current_worker() const
+	{
+		const tls_slot& slot = tls();
+		if (slot.system == this)
+			return slot.w;
+		// Creating thread isn't bound through tls (it has only one slot per
+		// TAllocator), so other systems it creates/destroys don't unbind it.
+		return std::this_thread::get_id() == m_owner ? &m_workers[0] : 0;
+	}
+	static std::uint32_t next_random(std::uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	worker*						m_workers;
+	size_type					m_numWorkers;
+	mpmc_queue<job*, TAllocator>	m_injection;
+	std::atomic<std::uint32_t>	m_numSleeping;
+	std::atomic<std::uint32_t>	m_wakeEpoch;
+	std::atomic<bool>			m_quit;
+	std::thread*				m_threads;
+	// Thread that created the system, worker 0.
+	const std::thread::id		m_owner;
+	TAllocator					m_allocator;
+	// Job pool for threads that are not workers.
+	std::mutex					m_externalLock;
+	worker						m_external;
+};
+#pragma warning(pop)
+typedef basic_job_system<>	job_system;
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_JOB_SYSTEM_H
@@ -0,0 +1,285 @@
+#ifndef RDESTL_MPMC_QUEUE_H
+#define RDESTL_MPMC_QUEUE_H
+
+#include <atomic>
+#include "algorithm.h"
+#include "allocator.h"
+#include "futex.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Bounded lock-free multi-producer/multi-consumer queue (D. Vyukov's design).
+// Every slot has a sequence number, that tells if it's ready to be written
+// (sequence == position) or read (sequence == position + 1), so producers
+// and consumers only contend on their own position counter.
+// Capacity is rounded up to power of two, storage comes from TAllocator.
+// try_* functions never block, see blocking_mpmc_queue for blocking version.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename T, class TAllocator = rde::allocator>
+class mpmc_queue
+{
+	struct cell
+	{
+		std::atomic<size_t>			sequence;
+		alignas(T) unsigned char	data[sizeof(T)];
+	};
+public:
+	typedef T			value_type;
+	typedef size_t		size_type;
+	typedef TAllocator	allocator_type;
+
+	explicit mpmc_queue(size_type capacity, const allocator_type& allocator = allocator_type())
+		: m_allocator(allocator),
+		m_mask(internal::round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+		m_enqueuePos(0),
+		m_dequeuePos(0)
+	{
+		m_cells = static_cast<cell*>(m_allocator.allocate(sizeof(cell) * (m_mask + 1)));
+		for (size_type i = 0; i <= m_mask; ++i)
+			new (&m_cells[i].sequence) std::atomic<size_t>(i);
+	}
+	// Not thread-safe, no other thread may use the queue at this point.
+	~mpmc_queue()
+	{
+		const size_type tail = m_enqueuePos.load(std::memory_order_acquire);
+		for (size_type i = m_dequeuePos.load(std::memory_order_relaxed); i != tail; ++i)
+			rde::destruct(element(m_cells[i & m_mask]));
+		m_allocator.deallocate(m_cells, sizeof(cell) * (m_mask + 1));
+	}
+
+	bool try_push(const T& v)
+	{
+		return try_emplace(v);
+	}
+	template<class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		size_type pos = m_enqueuePos.load(std::memory_order_relaxed);
+		cell* c;
+		for (;;)
+		{
+			c = &m_cells[pos & m_mask];
+			const size_type seq = c->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+			if (diff == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;	// full
+			}
+			else
+			{
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		rde::construct_args(element(*c), std::forward<Args>(args)...);
+		c->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+	bool try_pop(T& out)
+	{
+		size_type pos = m_dequeuePos.load(std::memory_order_relaxed);
+		cell* c;
+		for (;;)
+		{
+			c = &m_cells[pos & m_mask];
+			const size_type seq = c->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;	// empty
+			}
+			else
+			{
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		T* p = element(*c);
+		out = std::move(*p);
+		rde::destruct(p);
+		c->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+	// Pushes values until queue is full, returns number of elements pushed.
+	size_type push_n(const T* values, size_type n)
+	{
+		size_type i(0);
+		while (i < n && try_push(values[i]))
+			++i;
+		return i;
+	}
+	// Pops until queue is empty or n elements are popped, returns number of elements popped.
+	size_type pop_n(T* out, size_type n)
+	{
+		size_type i(0);
+		while (i < n && try_pop(out[i]))
+			++i;
+		return i;
+	}
+
+	// Approximate if other threads are pushing/popping.
+	size_type size_approx() const
+	{
+		const size_type head = m_dequeuePos.load(std::memory_order_acquire);
+		const size_type tail = m_enqueuePos.load(std::memory_order_acquire);
+		return tail > head ? tail - head : 0;
+	}
+	bool empty_approx() const	{ return size_approx() == 0; }
+	size_type capacity() const	{ return m_mask + 1; }
+
+private:
+	mpmc_queue(const mpmc_queue&);
+	mpmc_queue& operator=(const mpmc_queue&);
+
+	RDE_FORCEINLINE static T* element(cell& c)	{ return reinterpret_cast<T*>(&c.data[0]); }
+
+	// Every group starts on its own cache line.
+	// Read-only after construction.
+	TAllocator												m_allocator;
+	cell*													m_cells;
+	size_type												m_mask;
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<size_type>	m_enqueuePos;
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<size_type>	m_dequeuePos;
+};
+// Read-only data, enqueue and dequeue positions on separate cache lines.
+static_assert(alignof(mpmc_queue<int>) == RDE_CACHE_LINE_SIZE &&
+	sizeof(mpmc_queue<int>) >= 3 * RDE_CACHE_LINE_SIZE, "mpmc_queue positions should be cache line aligned");
+
+//=============================================================================
+// mpmc_queue + push/pop that sleep (futex) while queue is full/empty.
+// Non-blocking try_* functions are still available.
+// Wake-ups are only issued if there's someone waiting, so uncontended
+// push/pop costs 2 extra atomic operations.
+template<typename T, class TAllocator = rde::allocator>
+class blocking_mpmc_queue: public mpmc_queue<T, TAllocator>
+{
+	typedef mpmc_queue<T, TAllocator>	base_queue;
+public:
+	typedef typename base_queue::size_type		size_type;
+	typedef typename base_queue::allocator_type	allocator_type;
+
+	explicit blocking_mpmc_queue(size_type capacity, const allocator_type& allocator = allocator_type())
+		: base_queue(capacity, allocator),
+		m_numPushed(0),
+		m_numPopped(0),
+		m_waitingConsumers(0),
+		m_waitingProducers(0)
+	{
+	}
+
+	bool try_push(const T& v)
+	{
+		if (!base_queue::try_push(v))
+			return false;
+		notify_pushed();
+		return true;
+	}
+	bool try_pop(T& out)
+	{
+		if (!base_queue::try_pop(out))
+			return false;
+		notify_popped();
+		return true;
+	}
+	size_type push_n(const T* values, size_type n)
+	{
+		const size_type pushed = base_queue::push_n(values, n);
+		if (pushed)
+			notify_pushed(pushed);
+		return pushed;
+	}
+	size_type pop_n(T* out, size_type n)
+	{
+		const size_type popped = base_queue::pop_n(out, n);
+		if (popped)
+			notify_popped(popped);
+		return popped;
+	}
+	// Blocks while queue is full.
+	void push(const T& v)
+	{
+		for (;;)
+		{
+			if (try_push(v))
+				return;
+			const std::uint32_t popped = m_numPopped.load(std::memory_order_seq_cst);
+			if (try_push(v))
+				return;
+			m_waitingProducers.fetch_add(1, std::memory_order_seq_cst);
+			futex_wait(&m_numPopped, popped);
+			m_waitingProducers.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+	// Blocks while queue is empty.
+	void pop(T& out)
+	{
+		for (;;)
+		{
+			if (try_pop(out))
+				return;
+			const std::uint32_t pushed = m_numPushed.load(std::memory_order_seq_cst);
+			if (try_pop(out))
+				return;
+			m_waitingConsumers.fetch_add(1, std::memory_order_seq_cst);
+			futex_wait(&m_numPushed, pushed);
+			m_waitingConsumers.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+	// Wakes all waiting threads (on shutdown). They'll go back to sleep
+	// unless something changed, so caller usually pushes sentinel values first.
+	void wake_all()
+	{
+		m_numPushed.fetch_add(1, std::memory_order_seq_cst);
+		m_numPopped.fetch_add(1, std::memory_order_seq_cst);
+		futex_wake_all(&m_numPushed);
+		futex_wake_all(&m_numPopped);
+	}
+
+private:
+	void notify_pushed(size_type n = 1)
+	{
+		m_numPushed.fetch_add(1, std::memory_order_seq_cst);
+		if (m_waitingConsumers.load(std::memory_order_seq_cst) != 0)
+		{
+			if (n == 1)
+				futex_wake_one(&m_numPushed);
+			else
+				futex_wake_all(&m_numPushed);
+		}
+	}
+	void notify_popped(size_type n = 1)
+	{
+		m_numPopped.fetch_add(1, std::memory_order_seq_cst);
+		if (m_waitingProducers.load(std::memory_order_seq_cst) != 0)
+		{
+			if (n == 1)
+				futex_wake_one(&m_numPopped);
+			else
+				futex_wake_all(&m_numPopped);
+		}
+	}
+
+	// Wait words, bumped on every push/pop.
+	std::atomic<std::uint32_t>	m_numPushed;
+	std::atomic<std::uint32_t>	m_numPopped;
+	std::atomic<std::uint32_t>	m_waitingConsumers;
+	std::atomic<std::uint32_t>	m_waitingProducers;
+};
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_MPMC_QUEUE_H
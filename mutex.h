@@ -0,0 +1,332 @@
+#ifndef RDESTL_MUTEX_H
+#define RDESTL_MUTEX_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "futex.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#	include <intrin.h>
+#endif
+
+namespace rde
+{
+// Spin-wait hint (pause on x86, yield on ARM), lets the other hyper-thread run
+// and saves power while spinning.
+RDE_FORCEINLINE void cpu_pause()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#elif defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+	__yield();
+#elif defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+//=============================================================================
+// Test-and-test-and-set spin lock with exponential backoff.
+// Threads never sleep, only use it for very short critical sections.
+// 4 bytes, BasicLockable (works with std::lock_guard etc.).
+class spin_mutex
+{
+public:
+	spin_mutex(): m_locked(0) {}
+
+	void lock()
+	{
+		if (m_locked.exchange(1, std::memory_order_acquire) == 0)
+			return;
+		lock_contended();
+	}
+	bool try_lock()
+	{
+		return m_locked.load(std::memory_order_relaxed) == 0 &&
+			m_locked.exchange(1, std::memory_order_acquire) == 0;
+	}
+	void unlock()
+	{
+		m_locked.store(0, std::memory_order_release);
+	}
+
+private:
+	spin_mutex(const spin_mutex&);
+	spin_mutex& operator=(const spin_mutex&);
+
+	static const int	kMaxBackoff = 64;
+
+	void lock_contended()
+	{
+		int backoff(1);
+		for (;;)
+		{
+			// Wait until it looks free (read only, cache line stays shared).
+			while (m_locked.load(std::memory_order_relaxed) != 0)
+			{
+				if (backoff <= kMaxBackoff)
+				{
+					for (int i = 0; i < backoff; ++i)
+						cpu_pause();
+					backoff <<= 1;
+				}
+				else
+				{
+					// Holder probably got preempted.
+					std::this_thread::yield();
+				}
+			}
+			if (m_locked.exchange(1, std::memory_order_acquire) == 0)
+				return;
+		}
+	}
+
+	std::atomic<std::uint32_t>	m_locked;
+};
+
+//=============================================================================
+// Spins for a while, then sleeps on a futex (WaitOnAddress on Windows).
+// States: 0 - unlocked, 1 - locked, 2 - locked, (possibly) with sleepers.
+// Unlock only goes to the kernel if someone might be sleeping.
+// 4 bytes, BasicLockable.
+class adaptive_mutex
+{
+public:
+	adaptive_mutex(): m_state(0) {}
+
+	void lock()
+	{
+		std::uint32_t expected(0);
+		if (m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+			return;
+		lock_contended();
+	}
+	bool try_lock()
+	{
+		std::uint32_t expected(0);
+		return m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire);
+	}
+	void unlock()
+	{
+		if (m_state.exchange(0, std::memory_order_release) == 2)
+			futex_wake_one(&m_state);
+	}
+
+private:
+	adaptive_mutex(const adaptive_mutex&);
+	adaptive_mutex& operator=(const adaptive_mutex&);
+
+	static const int	kSpinCount = 100;
+
+	void lock_contended()
+	{
+		for (int i = 0; i < kSpinCount; ++i)
+		{
+			cpu_pause();
+			std::uint32_t expected(0);
+			if (m_state.load(std::memory_order_relaxed) == 0 &&
+				m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+			{
+				return;
+			}
+		}
+		// From now on we don't know if there are other sleepers, so mark as 2.
+		while (m_state.exchange(2, std::memory_order_acquire) != 0)
+			futex_wait(&m_state, 2);
+	}
+
+	std::atomic<std::uint32_t>	m_state;
+};
+
+//=============================================================================
+// Reader/writer lock, writer preferring: once writer is waiting, new readers
+// wait as well (existing ones finish), so writers don't starve.
+// Spins briefly, then sleeps on a futex. 16 bytes.
+// Lockable (lock/unlock) + lock_shared/unlock_shared.
+class shared_mutex
+{
+public:
+	shared_mutex(): m_state(0), m_writersWaiting(0), m_generation(0), m_sleepers(0) {}
+
+	// Exclusive.
+	void lock()
+	{
+		if (try_lock())
+			return;
+		m_writersWaiting.fetch_add(1, std::memory_order_seq_cst);
+		for (int spins = 0; ; ++spins)
+		{
+			const std::uint32_t gen = m_generation.load(std::memory_order_seq_cst);
+			std::uint32_t s = m_state.load(std::memory_order_seq_cst);
+			if (s == 0 && m_state.compare_exchange_strong(s, kWriter, std::memory_order_acquire))
+				break;
+			wait(gen, spins);
+		}
+		m_writersWaiting.fetch_sub(1, std::memory_order_relaxed);
+	}
+	bool try_lock()
+	{
+		std::uint32_t expected(0);
+		return m_state.compare_exchange_strong(expected, kWriter, std::memory_order_acquire);
+	}
+	void unlock()
+	{
+		m_state.store(0, std::memory_order_seq_cst);
+		wake();
+	}
+
+	// Shared.
+	void lock_shared()
+	{
+		for (int spins = 0; ; ++spins)
+		{
+			const std::uint32_t gen = m_generation.load(std::memory_order_seq_cst);
+			std::uint32_t s = m_state.load(std::memory_order_seq_cst);
+			if ((s & kWriter) == 0 && m_writersWaiting.load(std::memory_order_seq_cst) == 0)
+			{
+				if (m_state.compare_exchange_weak(s, s + 1, std::memory_order_acquire))
+					return;
+				continue;
+			}
+			wait(gen, spins);
+		}
+	}
+	bool try_lock_shared()
+	{
+		std::uint32_t s = m_state.load(std::memory_order_relaxed);
+		return (s & kWriter) == 0 && m_writersWaiting.load(std::memory_order_relaxed) == 0 &&
+			m_state.compare_exchange_strong(s, s + 1, std::memory_order_acquire);
+	}
+	void unlock_shared()
+	{
+		m_state.fetch_sub(1, std::memory_order_seq_cst);
+		wake();
+	}
+
+private:
+	shared_mutex(const shared_mutex&);
+	shared_mutex& operator=(const shared_mutex&);
+
+	static const std::uint32_t	kWriter = 0x80000000;
+	static const int			kSpinCount = 100;
+
+	// Waits for an unlock that happened after gen was read.
+	// Sleeping on m_state itself could miss a wakeup: state can go through
+	// unlock and lock again (e.g. reader count back to the same value)
+	// before waiter gets to futex_wait, which then sleeps on a value that's
+	// "unchanged", even though lock was released in the meantime.
+	void wait(std::uint32_t gen, int spins)
+	{
+		if (spins < kSpinCount)
+		{
+			cpu_pause();
+			return;
+		}
+		m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+		futex_wait(&m_generation, gen);
+		m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+	void wake()
+	{
+		m_generation.fetch_add(1, std::memory_order_seq_cst);
+		if (m_sleepers.load(std::memory_order_seq_cst) != 0)
+			futex_wake_all(&m_generation);
+	}
+
+	// Writer bit + number of readers.
+	std::atomic<std::uint32_t>	m_state;
+	std::atomic<std::uint32_t>	m_writersWaiting;
+	// Incremented by every unlock, waiters sleep on it.
+	std::atomic<std::uint32_t>	m_generation;
+	std::atomic<std::uint32_t>	m_sleepers;
+};
+
+namespace internal
+{
+	// Shared lock if mutex supports it, exclusive otherwise.
+	template<class TMutex>
+	auto lock_shared(TMutex& m, int) -> decltype(m.lock_shared())	{ m.lock_shared(); }
+	template<class TMutex>
+	void lock_shared(TMutex& m, long)								{ m.lock(); }
+	template<class TMutex>
+	auto unlock_shared(TMutex& m, int) -> decltype(m.unlock_shared())	{ m.unlock_shared(); }
+	template<class TMutex>
+	void unlock_shared(TMutex& m, long)									{ m.unlock(); }
+} // namespace internal
+
+//=============================================================================
+// Value that can only be accessed with mutex held:
+//	rde::locked<rde::vector<int> > v;
+//	v.lock()->push_back(5);
+//	v.with_lock([](rde::vector<int>& v) { ... });
+// with_shared_lock only gives const access, readers run in parallel if TMutex
+// has lock_shared/unlock_shared (shared_mutex), otherwise it's exclusive.
+template<typename T, class TMutex = adaptive_mutex>
+class locked
+{
+public:
+	typedef T		value_type;
+	typedef TMutex	mutex_type;
+
+	// Keeps mutex locked while alive.
+	class access
+	{
+	public:
+		access(access&& rhs): m_owner(rhs.m_owner)	{ rhs.m_owner = 0; }
+		~access()
+		{
+			if (m_owner)
+				m_owner->m_mutex.unlock();
+		}
+
+		T* operator->() const	{ return &m_owner->m_value; }
+		T& operator*() const	{ return m_owner->m_value; }
+
+	private:
+		friend class locked;
+		explicit access(locked& owner): m_owner(&owner)	{ owner.m_mutex.lock(); }
+		access(const access&);
+		access& operator=(const access&);
+
+		locked*	m_owner;
+	};
+
+	locked(): m_value() {}
+	explicit locked(const T& value): m_value(value) {}
+
+	access lock()	{ return access(*this); }
+
+	template<class TFunc>
+	auto with_lock(TFunc f) -> decltype(f(*static_cast<T*>(0)))
+	{
+		std::lock_guard<TMutex> guard(m_mutex);
+		return f(m_value);
+	}
+	template<class TFunc>
+	auto with_shared_lock(TFunc f) const -> decltype(f(*static_cast<const T*>(0)))
+	{
+		shared_guard guard(m_mutex);
+		return f(m_value);
+	}
+
+private:
+	locked(const locked&);
+	locked& operator=(const locked&);
+
+	struct shared_guard
+	{
+		explicit shared_guard(TMutex& m): mutex(m)	{ internal::lock_shared(mutex, 0); }
+		~shared_guard()								{ internal::unlock_shared(mutex, 0); }
+		TMutex&	mutex;
+	};
+
+	mutable TMutex	m_mutex;
+	T				m_value;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_MUTEX_H
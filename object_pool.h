@@ -0,0 +1,411 @@
+#ifndef RDESTL_OBJECT_POOL_H
+#define RDESTL_OBJECT_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "algorithm.h"
+#include "allocator.h"
+#include "per_thread.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Thread-safe pool of fixed size blocks.
+// - blocks are carved from slabs (kSlabSize bytes, at least kMinBlocksPerSlab
+//   blocks) that come from TAllocator. Slab is given back as soon as all its blocks
+//   are free (one empty slab is kept around, so we don't thrash at the boundary),
+// - every thread works with its own cache (magazine) of free blocks, allocate
+//   and deallocate only touch thread's own cache line. Cache is refilled
+//   from/flushed to slabs (under lock) kBatchSize blocks at a time, so blocks
+//   freed by other threads go back in batches as well,
+// - threads are mapped to kNumCaches caches. If two threads share a cache
+//   and collide, loser goes straight to slabs instead of waiting.
+// Doesn't call constructors/destructors, see object_pool.
+// Every block is preceded by a pointer to its slab (padded to alignment).
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<class TAllocator = rde::allocator>
+class block_pool
+{
+	enum
+	{
+		// Cache takes 4 cache lines.
+		kCacheBlocks	= (4 * RDE_CACHE_LINE_SIZE - sizeof(std::uint32_t) * 2) / sizeof(void*)
+	};
+	struct slab
+	{
+		slab*			prev;
+		slab*			next;
+		void*			freeList;
+		char*			blocks;
+		std::uint32_t	numFree;
+		std::uint32_t	numCarved;
+	};
+	struct alignas(RDE_CACHE_LINE_SIZE) cache
+	{
+		std::atomic<bool>	busy;
+		std::uint32_t		count;
+		void*				blocks[kCacheBlocks];
+	};
+	static_assert(sizeof(cache) == 4 * RDE_CACHE_LINE_SIZE, "cache should take exactly 4 cache lines");
+public:
+	typedef TAllocator	allocator_type;
+	typedef size_t		size_type;
+
+	static const size_type		kSlabSize = 16 * 1024;
+	static const std::uint32_t	kMinBlocksPerSlab = 8;
+	static const std::uint32_t	kMagazineSize = kCacheBlocks;
+	static const std::uint32_t	kBatchSize = kMagazineSize / 2;
+	static const std::uint32_t	kNumCaches = 32;
+
+	explicit block_pool(size_type blockSize, size_type alignment = sizeof(void*),
+		const allocator_type& allocator = allocator_type())
+	:	m_blockSize(blockSize),
+		m_partial(0),
+		m_full(0),
+		m_spare(0),
+		m_numSlabs(0),
+		m_allocator(allocator)
+	{
+		RDE_ASSERT((alignment & (alignment - 1)) == 0);
+		if (alignment < sizeof(void*))
+			alignment = sizeof(void*);
+		if (m_blockSize < sizeof(void*))
+			m_blockSize = sizeof(void*);
+		m_alignment = alignment;
+		m_headerSize = (alignment > sizeof(slab*) ? alignment : sizeof(slab*));
+		m_stride = (m_headerSize + m_blockSize + alignment - 1) & ~(alignment - 1);
+		m_blocksPerSlab = std::uint32_t((kSlabSize - sizeof(slab) - alignment) / m_stride);
+		if (m_blocksPerSlab < kMinBlocksPerSlab)
+			m_blocksPerSlab = kMinBlocksPerSlab;
+		m_slabBytes = sizeof(slab) + alignment + m_stride * m_blocksPerSlab;
+		for (std::uint32_t i = 0; i < kNumCaches; ++i)
+		{
+			m_caches[i].busy.store(false, std::memory_order_relaxed);
+			m_caches[i].count = 0;
+		}
+	}
+	// @pre no other thread is using the pool. Doesn't care about blocks
+	// that weren't given back.
+	~block_pool()
+	{
+		free_slabs(m_partial);
+		free_slabs(m_full);
+		if (m_spare)
+			free_slab(m_spare);
+	}
+
+	// @return 0 if TAllocator is out of memory.
+	void* allocate()
+	{
+		cache& c = this_thread_cache();
+		if (!c.busy.exchange(true, std::memory_order_acquire))
+		{
+			if (c.count == 0)
+				c.count = refill(c.blocks, kBatchSize);
+			void* p = (c.count ? c.blocks[--c.count] : 0);
+			c.busy.store(false, std::memory_order_release);
+			return p;
+		}
+		void* p(0);
+		refill(&p, 1);
+		return p;
+	}
+	void deallocate(void* p)
+	{
+		if (p == 0)
+			return;
+		cache& c = this_thread_cache();
+		if (!c.busy.exchange(true, std::memory_order_acquire))
+		{
+			if (c.count == kMagazineSize)
+			{
+				c.count -= kBatchSize;
+				flush(c.blocks + c.count, kBatchSize);
+			}
+			c.blocks[c.count++] = p;
+			c.busy.store(false, std::memory_order_release);
+			return;
+		}
+		flush(&p, 1);
+	}
+
+	// Moves all cached blocks back to slabs and releases empty slabs.
+	// Caches that are in use at the moment are skipped.
+	void trim()
+	{
+		for (std::uint32_t i = 0; i < kNumCaches; ++i)
+		{
+			cache& c = m_caches[i];
+			if (!c.busy.exchange(true, std::memory_order_acquire))
+			{
+				flush(c.blocks, c.count);
+				c.count = 0;
+				c.busy.store(false, std::memory_order_release);
+			}
+		}
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_spare)
+		{
+			free_slab(m_spare);
+			m_spare = 0;
+		}
+	}
+
+	size_type block_size() const		{ return m_blockSize; }
+	size_type blocks_per_slab() const	{ return m_blocksPerSlab; }
+	// Slabs allocated from TAllocator at the moment (including spare one).
+	size_type num_slabs() const
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_numSlabs;
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	block_pool(const block_pool&);
+	block_pool& operator=(const block_pool&);
+
+	RDE_FORCEINLINE cache& this_thread_cache()
+	{
+		return m_caches[internal::this_thread_index() & (kNumCaches - 1)];
+	}
+	RDE_FORCEINLINE slab*& owner(void* p) const
+	{
+		return *reinterpret_cast<slab**>(static_cast<char*>(p) - m_headerSize);
+	}
+
+	// Takes up to n blocks from slabs, returns number of blocks taken.
+	std::uint32_t refill(void** out, std::uint32_t n)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		std::uint32_t i(0);
+		while (i < n)
+		{
+			slab* s = m_partial;
+			if (s == 0)
+			{
+				s = m_spare ? m_spare : new_slab();
+				if (s == 0)
+					break;
+				m_spare = 0;
+				link(m_partial, s);
+			}
+			while (i < n && s->numFree > 0)
+			{
+				void* p;
+				if (s->freeList)
+				{
+					p = s->freeList;
+					s->freeList = *static_cast<void**>(p);
+				}
+				else
+				{
+					p = s->blocks + s->numCarved * m_stride;
+					owner(p) = s;
+					++s->numCarved;
+				}
+				--s->numFree;
+				out[i++] = p;
+			}
+			if (s->numFree == 0)
+			{
+				unlink(m_partial, s);
+				link(m_full, s);
+			}
+		}
+		return i;
+	}
+	void flush(void** blocks, std::uint32_t n)
+	{
+		if (n == 0)
+			return;
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (std::uint32_t i = 0; i < n; ++i)
+		{
+			void* p = blocks[i];
+			slab* s = owner(p);
+			*static_cast<void**>(p) = s->freeList;
+			s->freeList = p;
+			if (s->numFree++ == 0)
+			{
+				unlink(m_full, s);
+				link(m_partial, s);
+			}
+			if (s->numFree == m_blocksPerSlab)
+			{
+				unlink(m_partial, s);
+				if (m_spare == 0)
+					m_spare = s;
+				else
+					free_slab(s);
+			}
+		}
+	}
+
+	slab* new_slab()
+	{
+		char* mem = static_cast<char*>(m_allocator.allocate(m_slabBytes));
+		if (mem == 0)
+			return 0;
+		slab* s = reinterpret_cast<slab*>(mem);
+		s->prev = s->next = 0;
+		s->freeList = 0;
+		// First block has to be aligned, header goes right before it.
+		const std::uintptr_t firstBlock = (std::uintptr_t(mem + sizeof(slab) + m_headerSize) + m_alignment - 1) & ~std::uintptr_t(m_alignment - 1);
+		s->blocks = reinterpret_cast<char*>(firstBlock);
+		s->numFree = m_blocksPerSlab;
+		s->numCarved = 0;
+		++m_numSlabs;
+		return s;
+	}
+	void free_slab(slab* s)
+	{
+		m_allocator.deallocate(s, m_slabBytes);
+		--m_numSlabs;
+	}
+	void free_slabs(slab* s)
+	{
+		while (s)
+		{
+			slab* next = s->next;
+			free_slab(s);
+			s = next;
+		}
+	}
+	static void link(slab*& head, slab* s)
+	{
+		s->prev = 0;
+		s->next = head;
+		if (head)
+			head->prev = s;
+		head = s;
+	}
+	static void unlink(slab*& head, slab* s)
+	{
+		if (s->prev)
+			s->prev->next = s->next;
+		else
+			head = s->next;
+		if (s->next)
+			s->next->prev = s->prev;
+		s->prev = s->next = 0;
+	}
+
+	cache				m_caches[kNumCaches];
+	size_type			m_blockSize;
+	size_type			m_alignment;
+	size_type			m_headerSize;
+	size_type			m_stride;
+	size_type			m_slabBytes;
+	std::uint32_t		m_blocksPerSlab;
+	mutable std::mutex	m_lock;
+	slab*				m_partial;
+	slab*				m_full;
+	slab*				m_spare;
+	size_type			m_numSlabs;
+	TAllocator			m_allocator;
+};
+
+//=============================================================================
+// block_pool for objects of type T.
+template<typename T, class TAllocator = rde::allocator>
+class object_pool: public block_pool<TAllocator>
+{
+	typedef block_pool<TAllocator>	base_pool;
+public:
+	typedef T	value_type;
+
+	explicit object_pool(const TAllocator& allocator = TAllocator())
+	:	base_pool(sizeof(T), alignof(T), allocator)
+	{
+	}
+
+	// Raw memory for one T.
+	T* allocate()
+	{
+		return static_cast<T*>(base_pool::allocate());
+	}
+	void deallocate(T* p)
+	{
+		base_pool::deallocate(p);
+	}
+
+	template<class... Args>
+	T* create(Args&&... args)
+	{
+		T* p = allocate();
+		if (p)
+			rde::construct_args(p, std::forward<Args>(args)...);
+		return p;
+	}
+	void destroy(T* p)
+	{
+		if (p)
+		{
+			rde::destruct(p);
+			deallocate(p);
+		}
+	}
+};
+#pragma warning(pop)
+
+//=============================================================================
+// Allocator concept on top of block_pool, for node based containers (list, map...):
+//	rde::block_pool<> pool(64);
+//	rde::list<int, rde::pool_allocator<> > l((rde::pool_allocator<>(&pool)));
+// Requests bigger than pool's block size (and all requests if there's no pool,
+// e.g. default constructed allocator) go to operator new.
+template<class TAllocator = rde::allocator>
+class pool_allocator
+{
+public:
+	typedef block_pool<TAllocator>	pool_type;
+
+	explicit pool_allocator(pool_type* pool = 0, const char* name = "POOL")
+	:	m_pool(pool),
+		m_name(name)
+	{
+	}
+
+	void* allocate(size_t bytes, int /*flags*/ = 0)
+	{
+		if (m_pool && bytes <= m_pool->block_size())
+			return m_pool->allocate();
+		return operator new(bytes);
+	}
+	void deallocate(void* ptr, size_t bytes)
+	{
+		if (m_pool && bytes <= m_pool->block_size())
+			m_pool->deallocate(ptr);
+		else
+			operator delete(ptr);
+	}
+
+	const char* get_name() const	{ return m_name; }
+	pool_type* get_pool() const		{ return m_pool; }
+
+private:
+	pool_type*	m_pool;
+	const char*	m_name;
+};
+
+template<class TAllocator>
+inline bool operator==(const pool_allocator<TAllocator>& lhs, const pool_allocator<TAllocator>& rhs)
+{
+	return lhs.get_pool() == rhs.get_pool();
+}
+template<class TAllocator>
+inline bool operator!=(const pool_allocator<TAllocator>& lhs, const pool_allocator<TAllocator>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_OBJECT_POOL_H
@@ -64,6 +64,14 @@ struct is_pod<pair<T1, T2>>
 	};
 };
 
+template<typename T1, typename T2>
+struct is_trivially_relocatable<pair<T1, T2>>
+{
+	enum {
+		value = is_trivially_relocatable<T1>::value && is_trivially_relocatable<T2>::value
+	};
+};
+
 //-----------------------------------------------------------------------------
 template<typename T1, typename T2>
 pair<T1, T2> make_pair(const T1& a, const T2& b)
@@ -0,0 +1,374 @@
+#ifndef RDESTL_PARALLEL_ALGORITHM_H
+#define RDESTL_PARALLEL_ALGORITHM_H
+
+#include <atomic>
+#include "functional.h"
+#include "job_system.h"
+#include "sort.h"
+#include "vector.h"
+
+// Ranges smaller than this are processed serially.
+#ifndef RDE_PARALLEL_THRESHOLD
+#	define RDE_PARALLEL_THRESHOLD	8192
+#endif
+
+namespace rde
+{
+//=============================================================================
+// Parallel algorithms. Executor has to provide:
+//	size_t num_workers() const;
+//	void parallel_for(size_t begin, size_t end, const TFunc& func, size_t grain);
+// (func(first, last) called for subranges, returns when everything is done),
+// job_system does. Versions without executor use default_job_system().
+
+// Runs everything on calling thread.
+struct serial_executor
+{
+	size_t num_workers() const	{ return 1; }
+	template<class TFunc>
+	void parallel_for(size_t begin, size_t end, const TFunc& func, size_t /*grain*/ = 0)
+	{
+		if (begin < end)
+			func(begin, end);
+	}
+};
+
+// Created on first use, uses all hardware threads. Thread that makes the first
+// call (directly or through one of the algorithms below) becomes its worker 0,
+// other threads submit as external threads (they only steal while waiting).
+inline job_system& default_job_system()
+{
+	static job_system s_jobSystem;
+	return s_jobSystem;
+}
+
+namespace internal
+{
+	// Splits n elements into few chunks per worker.
+	struct parallel_chunks
+	{
+		template<class TExecutor>
+		parallel_chunks(const TExecutor& exec, size_t n_)
+			: n(n_)
+		{
+			const size_t minChunkSize = RDE_PARALLEL_THRESHOLD / 4;
+			size_t numChunks = exec.num_workers() * 4;
+			if (numChunks > n / minChunkSize)
+				numChunks = n / minChunkSize;
+			if (numChunks == 0)
+				numChunks = 1;
+			size = (n + numChunks - 1) / numChunks;
+			count = (n + size - 1) / size;
+		}
+		size_t begin(size_t chunk) const	{ return chunk * size; }
+		size_t end(size_t chunk) const		{ return chunk * size + size < n ? chunk * size + size : n; }
+
+		size_t	n;
+		size_t	size;
+		size_t	count;
+	};
+
+	template<class TExecutor>
+	bool run_serially(const TExecutor& exec, size_t n)
+	{
+		return n < RDE_PARALLEL_THRESHOLD || exec.num_workers() < 2;
+	}
+
+	// Merges sorted [first1, last1) and [first2, last2) into result.
+	template<typename T, class TPredicate>
+	void merge(const T* first1, const T* last1, const T* first2, const T* last2, T* result, TPredicate pred)
+	{
+		while (first1 != last1 && first2 != last2)
+		{
+			if (pred(*first2, *first1))
+				*result++ = *first2++;
+			else
+				*result++ = *first1++;
+		}
+		while (first1 != last1)
+			*result++ = *first1++;
+		while (first2 != last2)
+			*result++ = *first2++;
+	}
+} // namespace internal
+
+//-----------------------------------------------------------------------------
+// Calls f(x) for every element.
+template<class TExecutor, typename T, class TFunc>
+void parallel_for_each(TExecutor& exec, T* first, T* last, TFunc f)
+{
+	const size_t n = size_t(last - first);
+	if (internal::run_serially(exec, n))
+	{
+		for (; first != last; ++first)
+			f(*first);
+		return;
+	}
+	exec.parallel_for(0, n, [first, &f](size_t b, size_t e)
+	{
+		for (size_t i = b; i < e; ++i)
+			f(first[i]);
+	}, RDE_PARALLEL_THRESHOLD / 4);
+}
+
+//-----------------------------------------------------------------------------
+// result[i] = op(first[i]). result may be equal to first.
+template<class TExecutor, typename T, typename TResult, class TFunc>
+void parallel_transform(TExecutor& exec, const T* first, const T* last, TResult* result, TFunc op)
+{
+	const size_t n = size_t(last - first);
+	if (internal::run_serially(exec, n))
+	{
+		for (size_t i = 0; i < n; ++i)
+			result[i] = op(first[i]);
+		return;
+	}
+	exec.parallel_for(0, n, [first, result, &op](size_t b, size_t e)
+	{
+		for (size_t i = b; i < e; ++i)
+			result[i] = op(first[i]);
+	}, RDE_PARALLEL_THRESHOLD / 4);
+}
+
+//-----------------------------------------------------------------------------
+// Folds range with op (has to be associative), init is only used once.
+template<class TExecutor, typename T, typename TValue, class TFunc>
+TValue parallel_reduce(TExecutor& exec, const T* first, const T* last, TValue init, TFunc op)
+{
+	const size_t n = size_t(last - first);
+	if (internal::run_serially(exec, n))
+	{
+		for (; first != last; ++first)
+			init = op(init, *first);
+		return init;
+	}
+	const internal::parallel_chunks chunks(exec, n);
+	vector<TValue> partials;
+	partials.resize(chunks.count);
+	exec.parallel_for(0, chunks.count, [first, &op, &chunks, &partials](size_t c0, size_t c1)
+	{
+		for (size_t c = c0; c < c1; ++c)
+		{
+			const T* p = first + chunks.begin(c);
+			const T* pEnd = first + chunks.end(c);
+			TValue sum = *p++;
+			for (; p != pEnd; ++p)
+				sum = op(sum, *p);
+			partials[c] = sum;
+		}
+	}, 1);
+	for (size_t c = 0; c < chunks.count; ++c)
+		init = op(init, partials[c]);
+	return init;
+}
+
+//-----------------------------------------------------------------------------
+// result[i] = first[0] op first[1] op ... op first[i]. op has to be associative.
+// Two passes: chunk totals, then chunks again with offsets.
+template<class TExecutor, typename T, class TFunc>
+void parallel_inclusive_scan(TExecutor& exec, const T* first, const T* last, T* result, TFunc op)
+{
+	const size_t n = size_t(last - first);
+	if (n == 0)
+		return;
+	if (internal::run_serially(exec, n))
+	{
+		T sum = first[0];
+		result[0] = sum;
+		for (size_t i = 1; i < n; ++i)
+		{
+			sum = op(sum, first[i]);
+			result[i] = sum;
+		}
+		return;
+	}
+	const internal::parallel_chunks chunks(exec, n);
+	vector<T> totals;
+	totals.resize(chunks.count);
+	exec.parallel_for(0, chunks.count, [first, &op, &chunks, &totals](size_t c0, size_t c1)
+	{
+		for (size_t c = c0; c < c1; ++c)
+		{
+			const size_t e = chunks.end(c);
+			size_t i = chunks.begin(c);
+			T sum = first[i];
+			for (++i; i < e; ++i)
+				sum = op(sum, first[i]);
+			totals[c] = sum;
+		}
+	}, 1);
+	// totals[c] = everything before chunk c + 1.
+	for (size_t c = 1; c < chunks.count; ++c)
+		totals[c] = op(totals[c - 1], totals[c]);
+	exec.parallel_for(0, chunks.count, [first, result, &op, &chunks, &totals](size_t c0, size_t c1)
+	{
+		for (size_t c = c0; c < c1; ++c)
+		{
+			const size_t e = chunks.end(c);
+			size_t i = chunks.begin(c);
+			T sum = (c == 0 ? first[i] : op(totals[c - 1], first[i]));
+			result[i] = sum;
+			for (++i; i < e; ++i)
+			{
+				sum = op(sum, first[i]);
+				result[i] = sum;
+			}
+		}
+	}, 1);
+}
+
+//-----------------------------------------------------------------------------
+// First element equal to val, or last. Chunks past already found element
+// are skipped.
+template<class TExecutor, typename T, typename TValue>
+T* parallel_find(TExecutor& exec, T* first, T* last, const TValue& val)
+{
+	const size_t n = size_t(last - first);
+	if (internal::run_serially(exec, n))
+		return rde::find(first, last, val);
+	const internal::parallel_chunks chunks(exec, n);
+	std::atomic<size_t> found(n);
+	exec.parallel_for(0, chunks.count, [first, &val, &chunks, &found](size_t c0, size_t c1)
+	{
+		for (size_t c = c0; c < c1; ++c)
+		{
+			const size_t e = chunks.end(c);
+			for (size_t i = chunks.begin(c); i < e; ++i)
+			{
+				// Check every now and then if earlier chunk already found it.
+				if ((i & 1023) == 0 && i > found.load(std::memory_order_relaxed))
+					return;
+				if (first[i] == val)
+				{
+					size_t prev = found.load(std::memory_order_relaxed);
+					while (i < prev && !found.compare_exchange_weak(prev, i, std::memory_order_relaxed))
+						;
+					break;
+				}
+			}
+		}
+	}, 1);
+	return first + found.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// Chunks are sorted in parallel (quick_sort), then merged pairwise, all
+// merges of one level in parallel. Needs temporary copy of the range.
+template<class TExecutor, typename T, class TPredicate>
+void parallel_sort(TExecutor& exec, T* first, T* last, TPredicate pred)
+{
+	const size_t n = size_t(last - first);
+	if (internal::run_serially(exec, n))
+	{
+		quick_sort(first, last, pred);
+		return;
+	}
+	const internal::parallel_chunks chunks(exec, n);
+	exec.parallel_for(0, chunks.count, [first, &pred, &chunks](size_t c0, size_t c1)
+	{
+		for (size_t c = c0; c < c1; ++c)
+			quick_sort(first + chunks.begin(c), first + chunks.end(c), pred);
+	}, 1);
+
+	vector<T> buffer(first, last);
+	T* src = first;
+	T* dst = buffer.begin();
+	for (size_t width = chunks.size; width < n; width *= 2)
+	{
+		const size_t numPairs = (n + 2 * width - 1) / (2 * width);
+		exec.parallel_for(0, numPairs, [src, dst, n, width, &pred](size_t p0, size_t p1)
+		{
+			for (size_t p = p0; p < p1; ++p)
+			{
+				const size_t lo = p * 2 * width;
+				const size_t mid = (lo + width < n ? lo + width : n);
+				const size_t hi = (mid + width < n ? mid + width : n);
+				internal::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, pred);
+			}
+		}, 1);
+		rde::swap(src, dst);
+	}
+	if (src != first)
+		parallel_transform(exec, src, src + n, first, [](const T& x) { return x; });
+}
+template<class TExecutor, typename T>
+void parallel_sort(TExecutor& exec, T* first, T* last)
+{
+	parallel_sort(exec, first, last, less<T>());
+}
+
+//-----------------------------------------------------------------------------
+// Default executor versions.
+template<typename T, class TFunc>
+void parallel_for_each(T* first, T* last, TFunc f)
+{
+	parallel_for_each(default_job_system(), first, last, f);
+}
+template<typename T, typename TResult, class TFunc>
+void parallel_transform(const T* first, const T* last, TResult* result, TFunc op)
+{
+	parallel_transform(default_job_system(), first, last, result, op);
+}
+template<typename T, typename TValue, class TFunc>
+TValue parallel_reduce(const T* first, const T* last, TValue init, TFunc op)
+{
+	return parallel_reduce(default_job_system(), first, last, init, op);
+}
+template<typename T, class TFunc>
+void parallel_inclusive_scan(const T* first, const T* last, T* result, TFunc op)
+{
+	parallel_inclusive_scan(default_job_system(), first, last, result, op);
+}
+template<typename T, typename TValue>
+T* parallel_find(T* first, T* last, const TValue& val)
+{
+	return parallel_find(default_job_system(), first, last, val);
+}
+template<typename T, class TPredicate>
+void parallel_sort(T* first, T* last, TPredicate pred)
+{
+	parallel_sort(default_job_system(), first, last, pred);
+}
+template<typename T>
+void parallel_sort(T* first, T* last)
+{
+	parallel_sort(default_job_system(), first, last, less<T>());
+}
+
+//-----------------------------------------------------------------------------
+// Whole vector versions (default executor).
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy, class TFunc>
+void parallel_for_each(vector<T, TAllocator, TStorage, TGrowthPolicy>& v, TFunc f)
+{
+	parallel_for_each(v.begin(), v.end(), f);
+}
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy, typename TResult, class TFunc>
+void parallel_transform(const vector<T, TAllocator, TStorage, TGrowthPolicy>& v, TResult* result, TFunc op)
+{
+	parallel_transform(v.begin(), v.end(), result, op);
+}
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy, typename TValue, class TFunc>
+TValue parallel_reduce(const vector<T, TAllocator, TStorage, TGrowthPolicy>& v, TValue init, TFunc op)
+{
+	return parallel_reduce(v.begin(), v.end(), init, op);
+}
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy, typename TValue>
+T* parallel_find(vector<T, TAllocator, TStorage, TGrowthPolicy>& v, const TValue& val)
+{
+	return parallel_find(v.begin(), v.end(), val);
+}
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy, class TPredicate>
+void parallel_sort(vector<T, TAllocator, TStorage, TGrowthPolicy>& v, TPredicate pred)
+{
+	parallel_sort(v.begin(), v.end(), pred);
+}
+template<typename T, class TAllocator, class TStorage, class TGrowthPolicy>
+void parallel_sort(vector<T, TAllocator, TStorage, TGrowthPolicy>& v)
+{
+	parallel_sort(v.begin(), v.end(), less<T>());
+}
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_PARALLEL_ALGORITHM_H
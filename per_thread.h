@@ -0,0 +1,142 @@
+#ifndef RDESTL_PER_THREAD_H
+#define RDESTL_PER_THREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "rdestl_common.h"
+#include "vector.h"
+
+namespace rde
+{
+namespace internal
+{
+	// Hands out smallest free index, indices of finished threads are reused,
+	// so they stay below max number of threads alive at the same time.
+	class thread_index_registry
+	{
+	public:
+		static std::uint32_t acquire()
+		{
+			thread_index_registry& r = instance();
+			std::lock_guard<std::mutex> lock(r.m_lock);
+			if (r.m_free.empty())
+				return r.m_numIndices++;
+			// Keep free list sorted (descending), so we reuse lowest index.
+			const std::uint32_t index = r.m_free.back();
+			r.m_free.pop_back();
+			return index;
+		}
+		static void release(std::uint32_t index)
+		{
+			thread_index_registry& r = instance();
+			std::lock_guard<std::mutex> lock(r.m_lock);
+			rde::vector<std::uint32_t>::iterator it = r.m_free.begin();
+			while (it != r.m_free.end() && *it > index)
+				++it;
+			r.m_free.insert(it, index);
+		}
+
+	private:
+		thread_index_registry(): m_numIndices(0) {}
+
+		// Never destroyed, threads may still finish during static destruction
+		// (e.g. workers of a static job_system).
+		static thread_index_registry& instance()
+		{
+			alignas(thread_index_registry) static unsigned char s_storage[sizeof(thread_index_registry)];
+			static thread_index_registry* s_registry = new (s_storage) thread_index_registry();
+			return *s_registry;
+		}
+
+		std::mutex					m_lock;
+		std::uint32_t				m_numIndices;
+		rde::vector<std::uint32_t>	m_free;
+	};
+	struct thread_index_holder
+	{
+		thread_index_holder(): index(thread_index_registry::acquire())	{}
+		~thread_index_holder()	{ thread_index_registry::release(index); }
+
+		const std::uint32_t	index;
+	};
+
+	// Small, dense, per-thread number.
+	inline std::uint32_t this_thread_index()
+	{
+		static thread_local thread_index_holder s_holder;
+		return s_holder.index;
+	}
+} // namespace internal
+
+//=============================================================================
+// One T per thread, each on its own cache line(s), so threads can update their
+// own copy without bouncing cache lines. Meant for thread-local scratch/stats
+// that are combined once writers are done (after join, job_system::wait etc.).
+// Threads are mapped to slots by internal::this_thread_index, slot of a thread
+// that's finished goes to the next thread that starts (values are kept).
+// Same as sharded_counter, if more than TMaxThreads threads use it at the same
+// time, some of them share a slot (access to T is not synchronized, so that's
+// only safe if caller serializes it).
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename T, int TMaxThreads = 64>
+class per_thread
+{
+	static_assert((TMaxThreads & (TMaxThreads - 1)) == 0, "number of slots must be power of two");
+
+	struct alignas(RDE_CACHE_LINE_SIZE) slot
+	{
+		T	value;
+	};
+	static_assert(sizeof(slot) == (sizeof(T) + RDE_CACHE_LINE_SIZE - 1) / RDE_CACHE_LINE_SIZE * RDE_CACHE_LINE_SIZE,
+		"slot should be T rounded up to whole cache lines");
+public:
+	typedef T	value_type;
+
+	per_thread()
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+			m_slots[i].value = T();
+	}
+	explicit per_thread(const T& init)
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+			m_slots[i].value = init;
+	}
+
+	// Calling thread's copy.
+	T& local()
+	{
+		return m_slots[internal::this_thread_index() & (TMaxThreads - 1)].value;
+	}
+
+	int size() const							{ return TMaxThreads; }
+	T& operator[](int i)						{ RDE_ASSERT(i >= 0 && i < TMaxThreads); return m_slots[i].value; }
+	const T& operator[](int i) const			{ RDE_ASSERT(i >= 0 && i < TMaxThreads); return m_slots[i].value; }
+
+	// @return op(...op(op(init, slot0), slot1)..., slotN-1).
+	template<typename TResult, class TFunc>
+	TResult combine(TResult init, TFunc op) const
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+			init = op(init, m_slots[i].value);
+		return init;
+	}
+	template<class TFunc>
+	void for_each(TFunc f)
+	{
+		for (int i = 0; i < TMaxThreads; ++i)
+			f(m_slots[i].value);
+	}
+
+private:
+	slot	m_slots[TMaxThreads];
+};
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_PER_THREAD_H
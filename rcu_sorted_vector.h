@@ -0,0 +1,313 @@
+#ifndef RDESTL_RCU_SORTED_VECTOR_H
+#define RDESTL_RCU_SORTED_VECTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "epoch.h"
+#include "sorted_vector.h"
+
+namespace rde
+{
+
+// Sorted key/value table for read-mostly data (routing, configuration) that is
+// looked up all the time and only changes every now and then (RCU style).
+// - every version of the table is an immutable, sorted array (snapshot),
+// - readers binary search current snapshot without locks, entering/leaving
+//   read section only writes to reader's own cache line (see epoch_domain),
+// - writers collect changes in update_batch and commit it: new array is built
+//   on the side (O(n + m log m), n - table size, m - batch size) and published
+//   with a single pointer store. Commits are serialized with a mutex,
+// - replaced snapshots are freed once no reader can see them anymore.
+// Readers see either the old or the new version, never a mix.
+// Every reading thread needs its own reader handle, up to TMaxReaders at a time.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename TKey, typename TValue,
+	class TCompare		= rde::less<TKey>,
+	class TAllocator	= rde::allocator,
+	int TMaxReaders		= 64
+>
+class rcu_sorted_vector
+{
+	typedef epoch_domain<TAllocator, TMaxReaders + 1>	domain_t;
+
+public:
+	typedef TKey					key_type;
+	typedef TValue					mapped_type;
+	typedef pair<TKey, TValue>		value_type;
+	typedef TAllocator				allocator_type;
+	typedef size_t					size_type;
+
+	// One version of the table. Never modified once published.
+	class snapshot
+	{
+		friend class rcu_sorted_vector;
+		typedef rde::vector<value_type, TAllocator>	storage_t;
+	public:
+		typedef const value_type*	const_iterator;
+
+		const_iterator begin() const	{ return m_data.begin(); }
+		const_iterator end() const		{ return m_data.end(); }
+		size_type size() const			{ return m_data.size(); }
+		bool empty() const				{ return m_data.empty(); }
+		// Number of commits this version is a result of.
+		std::uint64_t version() const	{ return m_version; }
+
+		const_iterator find(const key_type& k) const
+		{
+			const_iterator i(lower_bound(k));
+			if (i != end() && m_compare(k, *i))
+				i = end();
+			return i;
+		}
+		const_iterator lower_bound(const key_type& k) const
+		{
+			return rde::lower_bound(begin(), end(), k, m_compare);
+		}
+		const_iterator upper_bound(const key_type& k) const
+		{
+			return rde::upper_bound(begin(), end(), k, m_compare);
+		}
+
+	private:
+		snapshot(std::uint64_t version, const allocator_type& allocator)
+		:	m_data(allocator),
+			m_version(version)
+		{
+		}
+		snapshot(const snapshot&);
+		snapshot& operator=(const snapshot&);
+
+		storage_t										m_data;
+		const std::uint64_t								m_version;
+		internal::compare_func<value_type, TCompare>	m_compare;
+	};
+
+	// Lookup handle, one per reading thread. Not thread-safe itself.
+	class reader
+	{
+	public:
+		explicit reader(const rcu_sorted_vector& table)
+		:	m_table(table),
+			m_participant(table.m_domain)
+		{
+		}
+
+		bool find(const key_type& k, mapped_type& out_value)
+		{
+			typename domain_t::guard g(m_participant);
+			const snapshot* s = m_table.current();
+			typename snapshot::const_iterator it = s->find(k);
+			if (it == s->end())
+				return false;
+			out_value = it->second;
+			return true;
+		}
+		bool contains(const key_type& k)
+		{
+			typename domain_t::guard g(m_participant);
+			const snapshot* s = m_table.current();
+			return s->find(k) != s->end();
+		}
+		// Calls f(const snapshot&) on current version (for range queries,
+		// iteration etc). Snapshot must not be used after f returns.
+		template<class TFunc>
+		auto read(TFunc f) -> decltype(f(*static_cast<const snapshot*>(0)))
+		{
+			typename domain_t::guard g(m_participant);
+			return f(*m_table.current());
+		}
+
+	private:
+		reader(const reader&);
+		reader& operator=(const reader&);
+
+		const rcu_sorted_vector&		m_table;
+		typename domain_t::participant	m_participant;
+	};
+
+	// List of changes, applied in order by commit (last change to given key wins).
+	class update_batch
+	{
+		friend class rcu_sorted_vector;
+		struct change
+		{
+			value_type		kv;
+			std::uint32_t	order;
+			bool			erase;
+		};
+	public:
+		explicit update_batch(const allocator_type& allocator = allocator_type())
+		:	m_changes(allocator),
+			m_clear(false)
+		{
+		}
+
+		// Inserts or overwrites.
+		void insert(const key_type& k, const mapped_type& v)	{ add(value_type(k, v), false); }
+		void erase(const key_type& k)							{ add(value_type(k, mapped_type()), true); }
+		// Removes everything that's in the table (and all changes so far),
+		// changes that follow are applied to empty table.
+		void clear()
+		{
+			m_changes.clear();
+			m_clear = true;
+		}
+
+		bool empty() const		{ return m_changes.empty() && !m_clear; }
+		size_type size() const	{ return m_changes.size(); }
+
+	private:
+		void add(const value_type& kv, bool erase)
+		{
+			change c = { kv, std::uint32_t(m_changes.size()), erase };
+			m_changes.push_back(c);
+		}
+		void reset()
+		{
+			m_changes.clear();
+			m_clear = false;
+		}
+
+		rde::vector<change, TAllocator>	m_changes;
+		bool							m_clear;
+	};
+
+	explicit rcu_sorted_vector(const allocator_type& allocator = allocator_type())
+	:	m_allocator(allocator),
+		m_domain(allocator),
+		m_writer(m_domain)
+	{
+		m_current.store(new_snapshot(0), std::memory_order_relaxed);
+	}
+	// @pre no readers.
+	~rcu_sorted_vector()
+	{
+		free_snapshot(m_current.load(std::memory_order_relaxed));
+	}
+
+	// Applies batch and publishes new version, batch is emptied.
+	// Thread-safe (commits are serialized).
+	void commit(update_batch& batch)
+	{
+		if (batch.empty())
+			return;
+		std::lock_guard<std::mutex> lock(m_writeLock);
+		snapshot* old = m_current.load(std::memory_order_relaxed);
+		snapshot* s = new_snapshot(old->version() + 1);
+		merge(batch.m_clear ? 0 : old, batch.m_changes, s->m_data);
+		batch.reset();
+
+		// Readers entering from now on only see new version.
+		m_current.store(s, std::memory_order_seq_cst);
+		m_writer.retire(old);
+		m_writer.collect();
+	}
+	// Single change, same cost as committing a whole batch.
+	void insert(const key_type& k, const mapped_type& v)
+	{
+		update_batch batch(m_allocator);
+		batch.insert(k, v);
+		commit(batch);
+	}
+	void erase(const key_type& k)
+	{
+		update_batch batch(m_allocator);
+		batch.erase(k);
+		commit(batch);
+	}
+
+	// Frees replaced versions that are no longer visible to readers.
+	void reclaim()
+	{
+		std::lock_guard<std::mutex> lock(m_writeLock);
+		m_writer.collect();
+	}
+	// Replaced versions, not freed yet (some reader still might be using them).
+	size_type retired_count() const
+	{
+		std::lock_guard<std::mutex> lock(m_writeLock);
+		return m_writer.pending();
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	typedef typename update_batch::change	change;
+
+	struct change_compare
+	{
+		bool operator()(const change& lhs, const change& rhs) const
+		{
+			if (TCompare()(lhs.kv.first, rhs.kv.first))
+				return true;
+			if (TCompare()(rhs.kv.first, lhs.kv.first))
+				return false;
+			return lhs.order < rhs.order;
+		}
+	};
+
+	rcu_sorted_vector(const rcu_sorted_vector&);
+	rcu_sorted_vector& operator=(const rcu_sorted_vector&);
+
+	const snapshot* current() const
+	{
+		return m_current.load(std::memory_order_acquire);
+	}
+
+	// out = (old or nothing) + changes, sorted.
+	static void merge(const snapshot* old, rde::vector<change, TAllocator>& changes,
+		typename snapshot::storage_t& out)
+	{
+		rde::quick_sort(changes.begin(), changes.end(), change_compare());
+		const value_type* first = old ? old->begin() : 0;
+		const value_type* last = old ? old->end() : 0;
+		out.reserve((last - first) + changes.size());
+		TCompare compare;
+		const change* c = changes.begin();
+		while (c != changes.end())
+		{
+			const key_type& k = c->kv.first;
+			while (first != last && compare(first->first, k))
+				out.push_back(*first++);
+			if (first != last && !compare(k, first->first))
+				++first;
+			// Only last change to this key matters.
+			while (c + 1 != changes.end() && !compare(k, c[1].kv.first))
+				++c;
+			if (!c->erase)
+				out.push_back(c->kv);
+			++c;
+		}
+		out.insert_range(out.end(), first, last);
+	}
+
+	snapshot* new_snapshot(std::uint64_t version)
+	{
+		return new (m_allocator.allocate(sizeof(snapshot))) snapshot(version, m_allocator);
+	}
+	void free_snapshot(snapshot* s)
+	{
+		rde::destruct(s);
+		m_allocator.deallocate(s, sizeof(snapshot));
+	}
+
+	// Read by every lookup, kept away from writer's data.
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<snapshot*>			m_current;
+	alignas(RDE_CACHE_LINE_SIZE) TAllocator						m_allocator;
+	mutable domain_t											m_domain;
+	mutable std::mutex											m_writeLock;
+	// Used by committing thread (under m_writeLock) to retire replaced versions.
+	typename domain_t::participant								m_writer;
+};
+// Current version pointer on its own cache line.
+static_assert(alignof(rcu_sorted_vector<int, int>) == RDE_CACHE_LINE_SIZE,
+	"rcu_sorted_vector should be cache line aligned");
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_RCU_SORTED_VECTOR_H
@@ -2,6 +2,7 @@
 #define RDESTL_H
 
 #include "rdestl_common.h"
+#include "deque.h"
 #include "vector.h"
 #include "hash_map.h"
 #include "rde_string.h"
@@ -14,19 +15,5 @@
 #include "utility.h"
 #include "sstream.h"
 
-namespace rde
-{
-template<
-	typename T,
-	class TAllocator = rde::allocator,
-	class TStorage = standard_vector_storage<T, TAllocator>
->
-struct deque: public vector<T, TAllocator, TStorage>
-{
-	// TODO
-};
-
-} // namespace rde
-
 //-----------------------------------------------------------------------------
 #endif // #ifndef RDESTL_H
@@ -72,11 +72,26 @@ namespace rde
 
 #endif // #if RDESTL_STANDALONE
 
+#ifndef RDE_CACHE_LINE_SIZE
+#	define RDE_CACHE_LINE_SIZE	64
+#endif
+
 namespace rde
 {
 
 enum e_noinitialize { noinitialize };
 
+namespace internal
+{
+	inline size_t round_up_pow2(size_t n)
+	{
+		size_t r(1);
+		while (r < n)
+			r <<= 1;
+		return r;
+	}
+} // namespace internal
+
 } // namespace rde
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,380 @@
+#ifndef RDESTL_RING_BUFFER_H
+#define RDESTL_RING_BUFFER_H
+
+#include "algorithm.h"
+#include "allocator.h"
+#include "int_to_type.h"
+#include "type_traits.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Up to two contiguous ranges (second one is used when data wraps around).
+template<typename T>
+struct ring_buffer_spans
+{
+	size_t size() const	{ return firstSize + secondSize; }
+
+	T*		first;
+	size_t	firstSize;
+	T*		second;
+	size_t	secondSize;
+};
+
+namespace internal
+{
+	//=========================================================================
+	// Fixed capacity, elements live inside of the object.
+	template<typename T, size_t TCapacity, class TAllocator>
+	struct ring_buffer_storage
+	{
+		static_assert((TCapacity & (TCapacity - 1)) == 0, "ring_buffer capacity must be power of two");
+
+		explicit ring_buffer_storage(const TAllocator&) {}
+
+		RDE_FORCEINLINE T* buffer()					{ return reinterpret_cast<T*>(&m_data[0]); }
+		RDE_FORCEINLINE const T* buffer() const		{ return reinterpret_cast<const T*>(&m_data[0]); }
+		RDE_FORCEINLINE size_t capacity() const		{ return TCapacity; }
+
+		// Can't grow, it's an error to go over capacity.
+		bool reallocate(size_t /*newCapacity*/, size_t /*head*/, size_t /*size*/)
+		{
+			RDE_ASSERT(!"ring_buffer: fixed capacity exceeded");
+			return false;
+		}
+		void release() {}
+		bool can_grow() const	{ return false; }
+
+		alignas(T) unsigned char	m_data[TCapacity * sizeof(T)];
+	};
+
+	//=========================================================================
+	// Heap storage, capacity is power of two and doubles when full.
+	template<typename T, class TAllocator>
+	struct ring_buffer_storage<T, 0, TAllocator>
+	{
+		explicit ring_buffer_storage(const TAllocator& allocator)
+			: m_data(0),
+			m_capacity(0),
+			m_allocator(allocator)
+		{
+		}
+
+		RDE_FORCEINLINE T* buffer()					{ return m_data; }
+		RDE_FORCEINLINE const T* buffer() const		{ return m_data; }
+		RDE_FORCEINLINE size_t capacity() const		{ return m_capacity; }
+
+		// Relocates [head, head + size) to the beginning of new buffer.
+		bool reallocate(size_t newCapacity, size_t head, size_t size)
+		{
+			size_t capacity = m_capacity ? m_capacity : 16;
+			while (capacity < newCapacity)
+				capacity *= 2;
+			T* newData = static_cast<T*>(m_allocator.allocate(capacity * sizeof(T)));
+			if (m_data)
+			{
+				const size_t firstSize = (head + size <= m_capacity ? size : m_capacity - head);
+				rde::relocate_n(m_data + head, firstSize, newData);
+				rde::relocate_n(m_data, size - firstSize, newData + firstSize);
+				m_allocator.deallocate(m_data, m_capacity * sizeof(T));
+			}
+			m_data = newData;
+			m_capacity = capacity;
+			return true;
+		}
+		void release()
+		{
+			if (m_data)
+				m_allocator.deallocate(m_data, m_capacity * sizeof(T));
+			m_data = 0;
+			m_capacity = 0;
+		}
+		bool can_grow() const	{ return true; }
+
+		T*			m_data;
+		size_t		m_capacity;
+		TAllocator	m_allocator;
+	};
+} // namespace internal
+
+//=============================================================================
+// FIFO circular buffer. Capacity is always power of two, so index wrapping is
+// just a mask.
+// TCapacity > 0 - fixed capacity, no allocations, pushing to a full buffer is
+// an error (use push_back_overwrite to drop oldest elements instead).
+// TCapacity == 0 - buffer grows (doubles) when full.
+template<typename T, size_t TCapacity = 0, class TAllocator = rde::allocator>
+class ring_buffer: private internal::ring_buffer_storage<T, TCapacity, TAllocator>
+{
+	typedef internal::ring_buffer_storage<T, TCapacity, TAllocator>	storage;
+public:
+	typedef T							value_type;
+	typedef size_t						size_type;
+	typedef TAllocator					allocator_type;
+	typedef ring_buffer_spans<T>		spans;
+	typedef ring_buffer_spans<const T>	const_spans;
+
+	explicit ring_buffer(const allocator_type& allocator = allocator_type())
+		: storage(allocator),
+		m_head(0),
+		m_size(0)
+	{
+	}
+	// @note: allocator is not copied from rhs.
+	ring_buffer(const ring_buffer& rhs, const allocator_type& allocator = allocator_type())
+		: storage(allocator),
+		m_head(0),
+		m_size(0)
+	{
+		copy(rhs);
+	}
+	ring_buffer(ring_buffer&& rhs)
+		: storage(rhs.get_allocator_for_move()),
+		m_head(0),
+		m_size(0)
+	{
+		take(rhs, int_to_type<TCapacity == 0>());
+	}
+	~ring_buffer()
+	{
+		clear();
+		storage::release();
+	}
+
+	ring_buffer& operator=(const ring_buffer& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			copy(rhs);
+		}
+		return *this;
+	}
+	ring_buffer& operator=(ring_buffer&& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			take(rhs, int_to_type<TCapacity == 0>());
+		}
+		return *this;
+	}
+
+	size_type size() const		{ return m_size; }
+	size_type capacity() const	{ return storage::capacity(); }
+	bool empty() const			{ return m_size == 0; }
+	bool full() const			{ return m_size == capacity(); }
+
+	// i-th element from the front (oldest).
+	T& operator[](size_type i)				{ RDE_ASSERT(i < m_size); return storage::buffer()[wrap(m_head + i)]; }
+	const T& operator[](size_type i) const	{ RDE_ASSERT(i < m_size); return storage::buffer()[wrap(m_head + i)]; }
+	T& front()				{ RDE_ASSERT(!empty()); return storage::buffer()[m_head]; }
+	const T& front() const	{ RDE_ASSERT(!empty()); return storage::buffer()[m_head]; }
+	T& back()				{ RDE_ASSERT(!empty()); return (*this)[m_size - 1]; }
+	const T& back() const	{ RDE_ASSERT(!empty()); return (*this)[m_size - 1]; }
+
+	void push_back(const T& v)
+	{
+		if (full() && !grow(m_size + 1))
+			return;
+		rde::copy_construct(storage::buffer() + wrap(m_head + m_size), v);
+		++m_size;
+	}
+	template<class... Args>
+	void emplace_back(Args&&... args)
+	{
+		if (full() && !grow(m_size + 1))
+			return;
+		rde::construct_args(storage::buffer() + wrap(m_head + m_size), std::forward<Args>(args)...);
+		++m_size;
+	}
+	// Never grows, replaces oldest element if buffer is full (history, telemetry).
+	// Growable buffer with no capacity yet allocates once.
+	void push_back_overwrite(const T& v)
+	{
+		if (capacity() == 0)
+		{
+			push_back(v);
+		}
+		else if (full())
+		{
+			storage::buffer()[m_head] = v;
+			m_head = wrap(m_head + 1);
+		}
+		else
+		{
+			rde::copy_construct(storage::buffer() + wrap(m_head + m_size), v);
+			++m_size;
+		}
+	}
+	void pop_front()
+	{
+		RDE_ASSERT(!empty());
+		rde::destruct(storage::buffer() + m_head);
+		m_head = wrap(m_head + 1);
+		--m_size;
+		if (m_size == 0)
+			m_head = 0;
+	}
+	void pop_back()
+	{
+		RDE_ASSERT(!empty());
+		--m_size;
+		rde::destruct(storage::buffer() + wrap(m_head + m_size));
+	}
+	void clear()
+	{
+		const spans s = readable();
+		rde::destruct_n(s.first, s.firstSize);
+		rde::destruct_n(s.second, s.secondSize);
+		m_head = 0;
+		m_size = 0;
+	}
+	void reserve(size_type n)
+	{
+		if (n > capacity())
+			grow(n);
+	}
+
+	// Appends n elements (at most 2 block copies).
+	// Returns number of elements pushed (less than n only if fixed buffer is full).
+	size_type push_back_n(const T* values, size_type n)
+	{
+		if (m_size + n > capacity() && storage::can_grow())
+			grow(m_size + n);
+		if (n > capacity() - m_size)
+			n = capacity() - m_size;
+		const spans s = free_spans(n);
+		internal::copy_construct_n(values, s.firstSize, s.first, int_to_type<has_trivial_copy<T>::value>());
+		internal::copy_construct_n(values + s.firstSize, s.secondSize, s.second, int_to_type<has_trivial_copy<T>::value>());
+		m_size += n;
+		return n;
+	}
+	// Moves up to n oldest elements to out, returns number of elements popped.
+	size_type pop_front_n(T* out, size_type n)
+	{
+		if (n > m_size)
+			n = m_size;
+		const spans s = readable();
+		const size_type firstSize = (n < s.firstSize ? n : s.firstSize);
+		for (size_type i = 0; i < firstSize; ++i)
+			out[i] = std::move(s.first[i]);
+		for (size_type i = firstSize; i < n; ++i)
+			out[i] = std::move(s.second[i - firstSize]);
+		consume(n);
+		return n;
+	}
+
+	// Contents, oldest first.
+	spans readable()
+	{
+		spans s;
+		s.first = storage::buffer() + m_head;
+		s.firstSize = (m_head + m_size <= capacity() ? m_size : capacity() - m_head);
+		s.second = storage::buffer();
+		s.secondSize = m_size - s.firstSize;
+		return s;
+	}
+	const_spans readable() const
+	{
+		spans s = const_cast<ring_buffer*>(this)->readable();
+		const_spans cs = { s.first, s.firstSize, s.second, s.secondSize };
+		return cs;
+	}
+	// Pops n oldest elements (after processing readable() in place).
+	void consume(size_type n)
+	{
+		RDE_ASSERT(n <= m_size);
+		const spans s = readable();
+		const size_type firstSize = (n < s.firstSize ? n : s.firstSize);
+		rde::destruct_n(s.first, firstSize);
+		rde::destruct_n(s.second, n - firstSize);
+		m_head = wrap(m_head + n);
+		m_size -= n;
+		if (m_size == 0)
+			m_head = 0;
+	}
+	// Uninitialized space for up to n new elements (less if fixed buffer
+	// doesn't have room). Fill it (I/O, memcpy) and call commit.
+	spans writable(size_type n)
+	{
+		static_assert(has_trivial_constructor<T>::value && has_trivial_destructor<T>::value,
+			"writable() is only for POD types");
+		if (m_size + n > capacity() && storage::can_grow())
+			grow(m_size + n);
+		if (n > capacity() - m_size)
+			n = capacity() - m_size;
+		return free_spans(n);
+	}
+	// Adds n elements written to writable() spans.
+	void commit(size_type n)
+	{
+		RDE_ASSERT(m_size + n <= capacity());
+		m_size += n;
+	}
+
+private:
+	RDE_FORCEINLINE size_type wrap(size_type i) const	{ return i & (capacity() - 1); }
+
+	spans free_spans(size_type n)
+	{
+		spans s;
+		const size_type tail = wrap(m_head + m_size);
+		s.first = storage::buffer() + tail;
+		s.firstSize = (tail + n <= capacity() ? n : capacity() - tail);
+		s.second = storage::buffer();
+		s.secondSize = n - s.firstSize;
+		return s;
+	}
+	bool grow(size_type minCapacity)
+	{
+		if (!storage::reallocate(minCapacity, m_head, m_size))
+			return false;
+		m_head = 0;
+		return true;
+	}
+	void copy(const ring_buffer& rhs)
+	{
+		reserve(rhs.m_size);
+		const const_spans s = rhs.readable();
+		for (size_type i = 0; i < s.firstSize; ++i)
+			push_back(s.first[i]);
+		for (size_type i = 0; i < s.secondSize; ++i)
+			push_back(s.second[i]);
+	}
+	// Growable - steal the buffer.
+	// @pre own elements destroyed
+	void take(ring_buffer& rhs, int_to_type<true>)
+	{
+		storage::release();
+		rde::swap(this->m_data, rhs.m_data);
+		rde::swap(this->m_capacity, rhs.m_capacity);
+		// Buffer has to be freed by allocator that created it.
+		rde::swap(this->m_allocator, rhs.m_allocator);
+		m_head = rhs.m_head;
+		m_size = rhs.m_size;
+		rhs.m_head = rhs.m_size = 0;
+	}
+	// Fixed - elements have to be moved one by one.
+	void take(ring_buffer& rhs, int_to_type<false>)
+	{
+		const spans s = rhs.readable();
+		for (size_type i = 0; i < s.firstSize; ++i)
+			emplace_back(std::move(s.first[i]));
+		for (size_type i = 0; i < s.secondSize; ++i)
+			emplace_back(std::move(s.second[i]));
+		rhs.clear();
+	}
+	allocator_type get_allocator_for_move() const	{ return get_allocator_for_move(int_to_type<TCapacity == 0>()); }
+	allocator_type get_allocator_for_move(int_to_type<true>) const	{ return this->m_allocator; }
+	allocator_type get_allocator_for_move(int_to_type<false>) const	{ return allocator_type(); }
+
+	size_type	m_head;
+	size_type	m_size;
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_RING_BUFFER_H
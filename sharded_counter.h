@@ -0,0 +1,190 @@
+#ifndef RDESTL_SHARDED_COUNTER_H
+#define RDESTL_SHARDED_COUNTER_H
+
+#include <atomic>
+#include <thread>
+#include "per_thread.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Counter for values updated from many threads (metrics, statistics).
+// Every thread adds to its own, cache line sized shard (one uncontended atomic
+// add, no cache line bouncing), value() sums all shards.
+// Threads are mapped to shards by internal::this_thread_index, if there's more
+// than TNumShards threads, some of them share a shard (still correct, just slower).
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<int TNumShards = 64>
+class basic_sharded_counter
+{
+	static_assert((TNumShards & (TNumShards - 1)) == 0, "number of shards must be power of two");
+
+	struct alignas(RDE_CACHE_LINE_SIZE) shard
+	{
+		std::atomic<std::int64_t>	value;
+	};
+	static_assert(sizeof(shard) == RDE_CACHE_LINE_SIZE, "shard should take exactly one cache line");
+public:
+	basic_sharded_counter()
+	{
+		reset();
+	}
+
+	void add(std::int64_t n)
+	{
+		local_shard().value.fetch_add(n, std::memory_order_relaxed);
+	}
+	void increment()	{ add(1); }
+	void decrement()	{ add(-1); }
+
+	// Approximate while other threads are adding.
+	std::int64_t value() const
+	{
+		std::int64_t sum(0);
+		for (int i = 0; i < TNumShards; ++i)
+			sum += m_shards[i].value.load(std::memory_order_relaxed);
+		return sum;
+	}
+	// Not atomic with respect to add.
+	void reset()
+	{
+		for (int i = 0; i < TNumShards; ++i)
+			m_shards[i].value.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	basic_sharded_counter(const basic_sharded_counter&);
+	basic_sharded_counter& operator=(const basic_sharded_counter&);
+
+	RDE_FORCEINLINE shard& local_shard()
+	{
+		return m_shards[internal::this_thread_index() & (TNumShards - 1)];
+	}
+
+	shard	m_shards[TNumShards];
+};
+#pragma warning(pop)
+typedef basic_sharded_counter<>	sharded_counter;
+
+//=============================================================================
+template<typename T>
+struct accumulator_stats
+{
+	accumulator_stats(): count(0), sum(), min(), max() {}
+
+	T mean() const	{ return count ? T(sum / T(count)) : T(); }
+
+	void add(const T& v)
+	{
+		if (count == 0)
+			min = max = v;
+		else if (v < min)
+			min = v;
+		else if (max < v)
+			max = v;
+		sum += v;
+		++count;
+	}
+	void merge(const accumulator_stats& rhs)
+	{
+		if (rhs.count == 0)
+			return;
+		if (count == 0 || rhs.min < min)
+			min = rhs.min;
+		if (count == 0 || max < rhs.max)
+			max = rhs.max;
+		sum += rhs.sum;
+		count += rhs.count;
+	}
+
+	std::uint64_t	count;
+	T				sum;
+	T				min;
+	T				max;
+};
+
+//=============================================================================
+// Count/sum/min/max of samples coming from many threads (timings, sizes...).
+// Same sharding as sharded_counter, every shard has its own tiny lock (so T
+// doesn't have to be atomic), it's only contended if threads share a shard
+// or someone is reading stats at the moment.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename T, int TNumShards = 64>
+class sharded_accumulator
+{
+	static_assert((TNumShards & (TNumShards - 1)) == 0, "number of shards must be power of two");
+
+	struct alignas(RDE_CACHE_LINE_SIZE) shard
+	{
+		std::atomic<bool>		busy;
+		accumulator_stats<T>	stats;
+	};
+	static_assert(sizeof(shard) % RDE_CACHE_LINE_SIZE == 0, "shard should take whole cache lines");
+public:
+	typedef accumulator_stats<T>	stats_type;
+
+	sharded_accumulator()
+	{
+		for (int i = 0; i < TNumShards; ++i)
+			m_shards[i].busy.store(false, std::memory_order_relaxed);
+	}
+
+	void add(const T& v)
+	{
+		shard& s = m_shards[internal::this_thread_index() & (TNumShards - 1)];
+		lock(s);
+		s.stats.add(v);
+		unlock(s);
+	}
+
+	// All samples so far.
+	stats_type stats() const
+	{
+		stats_type result;
+		for (int i = 0; i < TNumShards; ++i)
+		{
+			shard& s = m_shards[i];
+			lock(s);
+			result.merge(s.stats);
+			unlock(s);
+		}
+		return result;
+	}
+	void reset()
+	{
+		for (int i = 0; i < TNumShards; ++i)
+		{
+			shard& s = m_shards[i];
+			lock(s);
+			s.stats = stats_type();
+			unlock(s);
+		}
+	}
+
+private:
+	sharded_accumulator(const sharded_accumulator&);
+	sharded_accumulator& operator=(const sharded_accumulator&);
+
+	static RDE_FORCEINLINE void lock(shard& s)
+	{
+		while (s.busy.exchange(true, std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+	static RDE_FORCEINLINE void unlock(shard& s)
+	{
+		s.busy.store(false, std::memory_order_release);
+	}
+
+	mutable shard	m_shards[TNumShards];
+};
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_SHARDED_COUNTER_H
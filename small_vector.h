@@ -0,0 +1,214 @@
+#ifndef RDESTL_SMALL_VECTOR_H
+#define RDESTL_SMALL_VECTOR_H
+
+#include "vector.h"
+
+namespace rde
+{
+
+//=============================================================================
+// First TCapacity elements live inside of the object, bigger vectors are moved
+// (relocated) to the heap. Heap storage is given back if it shrinks again.
+template<typename T, class TAllocator, size_t TCapacity>
+struct small_vector_storage
+{
+	static_assert(TCapacity > 0, "small_vector needs inline capacity");
+
+	explicit small_vector_storage(const TAllocator& allocator)
+		: m_begin(inline_begin()),
+		m_end(m_begin),
+		m_capacityEnd(m_begin + TCapacity),
+		m_allocator(allocator)
+	{
+	}
+	small_vector_storage(small_vector_storage&& rhs)
+		: m_allocator(rhs.m_allocator)
+	{
+		take(rhs);
+	}
+	explicit small_vector_storage(e_noinitialize)
+	{
+	}
+
+	small_vector_storage& operator=(small_vector_storage&& rhs)
+	{
+		destroy(m_begin, base_vector::size_type(m_end - m_begin));
+		take(rhs);
+		return *this;
+	}
+
+	// @note	Heap capacity is always > TCapacity, newCapacity <= TCapacity brings
+	//			elements back in place.
+	void reallocate(base_vector::size_type newCapacity, base_vector::size_type oldSize)
+	{
+		const base_vector::size_type newSize = oldSize < newCapacity ? oldSize : newCapacity;
+		T* newBegin;
+		if (newCapacity <= TCapacity)
+		{
+			if (is_inline())
+			{
+				// Cant shrink inline storage.
+				rde::destruct_n(m_begin + newSize, oldSize - newSize);
+				m_end = m_begin + newSize;
+				return;
+			}
+			newBegin = inline_begin();
+			newCapacity = TCapacity;
+		}
+		else
+		{
+			newBegin = static_cast<T*>(m_allocator.allocate(newCapacity * sizeof(T)));
+		}
+		rde::relocate_n(m_begin, newSize, newBegin);
+		rde::destruct_n(m_begin + newSize, oldSize - newSize);
+		release_heap();
+		m_begin = newBegin;
+		m_end = m_begin + newSize;
+		m_capacityEnd = m_begin + newCapacity;
+		RDE_ASSERT(invariant());
+	}
+
+	// Reallocates memory, doesnt copy contents of old buffer.
+	void reallocate_discard_old(base_vector::size_type newCapacity)
+	{
+		if (newCapacity > base_vector::size_type(m_capacityEnd - m_begin))
+		{
+			const base_vector::size_type currSize((base_vector::size_type)(m_end - m_begin));
+			T* newBegin = static_cast<T*>(m_allocator.allocate(newCapacity * sizeof(T)));
+			destroy(m_begin, currSize);
+			m_begin = newBegin;
+			m_end = m_begin + currSize;
+			m_capacityEnd = m_begin + newCapacity;
+		}
+		RDE_ASSERT(invariant());
+	}
+	void destroy(T* ptr, base_vector::size_type n)
+	{
+		rde::destruct_n(ptr, n);
+		release_heap();
+	}
+	void reset()
+	{
+		release_heap();
+		m_begin = m_end = inline_begin();
+		m_capacityEnd = m_begin + TCapacity;
+	}
+	bool invariant() const
+	{
+		return m_end >= m_begin;
+	}
+	RDE_FORCEINLINE void record_high_watermark()
+	{
+		// empty
+	}
+	base_vector::size_type get_high_watermark() const
+	{
+		return TCapacity;
+	}
+
+	RDE_FORCEINLINE bool is_inline() const
+	{
+		return m_begin == inline_begin();
+	}
+	RDE_FORCEINLINE T* inline_begin()				{ return reinterpret_cast<T*>(&m_data[0]); }
+	RDE_FORCEINLINE const T* inline_begin() const	{ return reinterpret_cast<const T*>(&m_data[0]); }
+
+	void release_heap()
+	{
+		if (!is_inline())
+			m_allocator.deallocate(m_begin, (m_capacityEnd - m_begin) * sizeof(T));
+	}
+	// @pre	own elements destroyed
+	void take(small_vector_storage& rhs)
+	{
+		if (rhs.is_inline())
+		{
+			const base_vector::size_type n = base_vector::size_type(rhs.m_end - rhs.m_begin);
+			m_begin = inline_begin();
+			rde::relocate_n(rhs.m_begin, n, m_begin);
+			m_end = m_begin + n;
+			m_capacityEnd = m_begin + TCapacity;
+			rhs.m_end = rhs.m_begin;
+		}
+		else
+		{
+			m_begin = rhs.m_begin;
+			m_end = rhs.m_end;
+			m_capacityEnd = rhs.m_capacityEnd;
+			rhs.m_begin = rhs.m_end = rhs.inline_begin();
+			rhs.m_capacityEnd = rhs.m_begin + TCapacity;
+		}
+	}
+
+	T*				m_begin;
+	T*				m_end;
+	T*				m_capacityEnd;
+	TAllocator		m_allocator;
+	// Not T[], because we need uninitialized memory.
+	alignas(T) unsigned char	m_data[TCapacity * sizeof(T)];
+};
+
+//=============================================================================
+template<typename T, size_t TCapacity, class TAllocator = rde::allocator>
+class small_vector: public vector<T, TAllocator, small_vector_storage<T, TAllocator, TCapacity>>
+{
+	typedef vector<T, TAllocator, small_vector_storage<T, TAllocator, TCapacity>>	base_vector;
+public:
+	typedef TAllocator								allocator_type;
+	typedef typename base_vector::size_type			size_type;
+	typedef T										value_type;
+	static const size_type							kInlineCapacity = TCapacity;
+
+	explicit small_vector(const allocator_type& allocator = allocator_type())
+		: base_vector(allocator)
+	{
+		/**/
+	}
+	explicit small_vector(size_type initialSize, const allocator_type& allocator = allocator_type())
+		: base_vector(initialSize, allocator)
+	{
+		/**/
+	}
+	small_vector(const T* first, const T* last, const allocator_type& allocator = allocator_type())
+		: base_vector(first, last, allocator)
+	{
+		/**/
+	}
+	// @note: allocator is not copied from rhs.
+	small_vector(const small_vector& rhs, const allocator_type& allocator = allocator_type())
+		: base_vector(rhs, allocator)
+	{
+		/**/
+	}
+	small_vector(small_vector&& rhs)
+		: base_vector(std::move(rhs))
+	{
+		/**/
+	}
+	explicit small_vector(e_noinitialize n)
+		: base_vector(n)
+	{
+		/**/
+	}
+
+	small_vector& operator=(const small_vector& rhs)
+	{
+		if (&rhs != this)
+			base_vector::copy(rhs);
+		return *this;
+	}
+	small_vector& operator=(small_vector&& rhs)
+	{
+		base_vector::operator=(std::move(rhs));
+		return *this;
+	}
+
+	// True if elements are stored in place (no heap memory used).
+	// Heap capacity is always bigger than TCapacity.
+	bool is_inline() const	{ return this->capacity() == TCapacity; }
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_SMALL_VECTOR_H
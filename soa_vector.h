@@ -0,0 +1,362 @@
+#ifndef RDESTL_SOA_VECTOR_H
+#define RDESTL_SOA_VECTOR_H
+
+#include <tuple>
+#include "allocator.h"
+#include "sort.h"
+#include "vector.h"
+
+namespace rde
+{
+
+//=============================================================================
+// Structure-of-arrays vector. Every column (Ts) lives in its own array, arrays
+// are cache line aligned and share one size/capacity (and one allocation).
+// Loops that only need some of the fields only touch those arrays.
+// Rows are pushed/read as whole (tuple of fields), columns can be accessed
+// directly with column<I>(). Reallocation invalidates column pointers.
+template<class TAllocator, typename... Ts>
+class basic_soa_vector
+{
+	static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+public:
+	typedef size_t				size_type;
+	typedef TAllocator			allocator_type;
+	typedef std::tuple<Ts...>	value_type;
+	static const size_type		kNumColumns = sizeof...(Ts);
+	static const size_type		kColumnAlignment = RDE_CACHE_LINE_SIZE;
+	static const size_type		kInitialCapacity = 16;
+
+	template<size_t I>
+	using column_type = typename std::tuple_element<I, value_type>::type;
+
+	// Contiguous range of one column.
+	template<typename T>
+	class column_span
+	{
+	public:
+		column_span(T* data, size_type size): m_data(data), m_size(size) {}
+
+		T* data() const							{ return m_data; }
+		size_type size() const					{ return m_size; }
+		T* begin() const						{ return m_data; }
+		T* end() const							{ return m_data + m_size; }
+		T& operator[](size_type i) const		{ RDE_ASSERT(i < m_size); return m_data[i]; }
+
+	private:
+		T*			m_data;
+		size_type	m_size;
+	};
+
+	explicit basic_soa_vector(const allocator_type& allocator = allocator_type())
+		: m_block(0),
+		m_blockBytes(0),
+		m_size(0),
+		m_capacity(0),
+		m_columns(),
+		m_allocator(allocator)
+	{
+	}
+	// @note: allocator is not copied from rhs.
+	basic_soa_vector(const basic_soa_vector& rhs, const allocator_type& allocator = allocator_type())
+		: m_block(0),
+		m_blockBytes(0),
+		m_size(0),
+		m_capacity(0),
+		m_columns(),
+		m_allocator(allocator)
+	{
+		copy(rhs);
+	}
+	basic_soa_vector(basic_soa_vector&& rhs)
+		: m_block(0),
+		m_blockBytes(0),
+		m_size(0),
+		m_capacity(0),
+		m_columns(),
+		m_allocator(rhs.m_allocator)
+	{
+		swap(rhs);
+	}
+	~basic_soa_vector()
+	{
+		clear();
+		if (m_block)
+			m_allocator.deallocate(m_block, m_blockBytes);
+	}
+
+	basic_soa_vector& operator=(const basic_soa_vector& rhs)
+	{
+		if (&rhs != this)
+		{
+			clear();
+			copy(rhs);
+		}
+		return *this;
+	}
+	basic_soa_vector& operator=(basic_soa_vector&& rhs)
+	{
+		swap(rhs);
+		return *this;
+	}
+	// @note: allocators are not swapped.
+	void swap(basic_soa_vector& rhs)
+	{
+		rde::swap(m_block, rhs.m_block);
+		rde::swap(m_blockBytes, rhs.m_blockBytes);
+		rde::swap(m_size, rhs.m_size);
+		rde::swap(m_capacity, rhs.m_capacity);
+		std::swap(m_columns, rhs.m_columns);
+	}
+
+	size_type size() const		{ return m_size; }
+	size_type capacity() const	{ return m_capacity; }
+	bool empty() const			{ return m_size == 0; }
+
+	void push_back(const Ts&... values)
+	{
+		if (m_size == m_capacity)
+			reallocate(m_capacity == 0 ? kInitialCapacity : m_capacity * 2);
+		construct_row(m_size, std::index_sequence_for<Ts...>(), values...);
+		++m_size;
+	}
+	void push_back(const value_type& row)
+	{
+		push_back_tuple(row, std::index_sequence_for<Ts...>());
+	}
+	void pop_back()
+	{
+		RDE_ASSERT(!empty());
+		--m_size;
+		const size_type last = m_size;
+		for_each_column([last](auto* column) { rde::destruct(column + last); });
+	}
+	// Moves last row into i-th one.
+	void erase_unordered(size_type i)
+	{
+		RDE_ASSERT(i < m_size);
+		const size_type last = m_size - 1;
+		if (i != last)
+			for_each_column([i, last](auto* column) { column[i] = std::move(column[last]); });
+		pop_back();
+	}
+	void clear()
+	{
+		const size_type n = m_size;
+		for_each_column([n](auto* column) { rde::destruct_n(column, n); });
+		m_size = 0;
+	}
+	void reserve(size_type n)
+	{
+		if (n > m_capacity)
+			reallocate(n);
+	}
+	// New rows are value-initialized.
+	void resize(size_type n)
+	{
+		reserve(n);
+		const size_type prevSize = m_size;
+		if (n > prevSize)
+			for_each_column([prevSize, n](auto* column) { for (size_type i = prevSize; i < n; ++i) rde::construct_args(column + i); });
+		else
+			for_each_column([prevSize, n](auto* column) { rde::destruct_n(column + n, prevSize - n); });
+		m_size = n;
+	}
+
+	template<size_t I>
+	column_type<I>* column_data()				{ return std::get<I>(m_columns); }
+	template<size_t I>
+	const column_type<I>* column_data() const	{ return std::get<I>(m_columns); }
+	template<size_t I>
+	column_span<column_type<I> > column()		{ return column_span<column_type<I> >(column_data<I>(), m_size); }
+	template<size_t I>
+	column_span<const column_type<I> > column() const
+	{
+		return column_span<const column_type<I> >(column_data<I>(), m_size);
+	}
+	template<size_t I>
+	column_type<I>& get(size_type i)				{ RDE_ASSERT(i < m_size); return column_data<I>()[i]; }
+	template<size_t I>
+	const column_type<I>& get(size_type i) const	{ RDE_ASSERT(i < m_size); return column_data<I>()[i]; }
+	// Copy of the whole i-th row.
+	value_type row(size_type i) const
+	{
+		RDE_ASSERT(i < m_size);
+		return make_row(i, std::index_sequence_for<Ts...>());
+	}
+
+	// Reorders all columns, so that new i-th row is old indices[i]-th row.
+	// @pre indices is a permutation of [0, size())
+	void permute(const std::uint32_t* indices)
+	{
+		if (m_size == 0)
+			return;
+		columns_t newColumns;
+		size_type newBlockBytes;
+		void* newBlock = allocate_block(m_capacity, newColumns, newBlockBytes);
+		const size_type n = m_size;
+		for_each_column_pair(newColumns, [indices, n](auto* dst, auto* src)
+		{
+			for (size_type i = 0; i < n; ++i)
+				rde::construct_args(dst + i, std::move(src[indices[i]]));
+			rde::destruct_n(src, n);
+		});
+		m_allocator.deallocate(m_block, m_blockBytes);
+		m_block = newBlock;
+		m_blockBytes = newBlockBytes;
+		m_columns = newColumns;
+	}
+	// Sorts rows, pred(rowA, rowB) compares row indices.
+	// Index permutation is computed once and applied to all columns.
+	template<class TPredicate>
+	void sort(TPredicate pred)
+	{
+		vector<std::uint32_t, TAllocator> indices(m_allocator);
+		indices.resize_default_init(m_size);
+		for (size_type i = 0; i < m_size; ++i)
+			indices[i] = std::uint32_t(i);
+		rde::quick_sort(indices.begin(), indices.end(), row_predicate<TPredicate>(pred));
+		permute(indices.begin());
+	}
+	// Sorts rows by I-th column (using operator<).
+	template<size_t I>
+	void sort_by_column()
+	{
+		sort(column_less<I>(column_data<I>()));
+	}
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	typedef std::tuple<Ts*...>	columns_t;
+
+	template<class TPredicate>
+	struct row_predicate
+	{
+		explicit row_predicate(const TPredicate& p): pred(p) {}
+		bool operator()(std::uint32_t a, std::uint32_t b) const	{ return pred(size_type(a), size_type(b)); }
+		TPredicate	pred;
+	};
+	template<size_t I>
+	struct column_less
+	{
+		explicit column_less(const column_type<I>* c): column(c) {}
+		bool operator()(size_type a, size_type b) const	{ return column[a] < column[b]; }
+		const column_type<I>*	column;
+	};
+
+	template<class TFunc, size_t... Is>
+	void for_each_column(TFunc f, std::index_sequence<Is...>)
+	{
+		int dummy[] = { 0, (f(std::get<Is>(m_columns)), 0)... };
+		(void)dummy;
+	}
+	template<class TFunc>
+	void for_each_column(TFunc f)
+	{
+		for_each_column(f, std::index_sequence_for<Ts...>());
+	}
+	// Calls f(dst column, this column) for every column.
+	template<class TFunc, size_t... Is>
+	void for_each_column_pair(columns_t& dst, TFunc f, std::index_sequence<Is...>)
+	{
+		int dummy[] = { 0, (f(std::get<Is>(dst), std::get<Is>(m_columns)), 0)... };
+		(void)dummy;
+	}
+	template<class TFunc>
+	void for_each_column_pair(columns_t& dst, TFunc f)
+	{
+		for_each_column_pair(dst, f, std::index_sequence_for<Ts...>());
+	}
+
+	template<size_t... Is>
+	void construct_row(size_type i, std::index_sequence<Is...>, const Ts&... values)
+	{
+		int dummy[] = { 0, (rde::copy_construct(std::get<Is>(m_columns) + i, values), 0)... };
+		(void)dummy;
+	}
+	template<size_t... Is>
+	void push_back_tuple(const value_type& row, std::index_sequence<Is...>)
+	{
+		push_back(std::get<Is>(row)...);
+	}
+	template<size_t... Is>
+	value_type make_row(size_type i, std::index_sequence<Is...>) const
+	{
+		return value_type(std::get<Is>(m_columns)[i]...);
+	}
+
+	static size_type align_column(size_type offset)
+	{
+		return (offset + kColumnAlignment - 1) & ~(kColumnAlignment - 1);
+	}
+	template<size_t... Is>
+	static void place_columns(char* base, size_type capacity, columns_t& columns, std::index_sequence<Is...>)
+	{
+		size_type offset(0);
+		int dummy[] = { 0, (std::get<Is>(columns) = reinterpret_cast<column_type<Is>*>(base + offset),
+			offset = align_column(offset + capacity * sizeof(column_type<Is>)), 0)... };
+		(void)dummy;
+	}
+	template<size_t... Is>
+	static size_type block_bytes(size_type capacity, std::index_sequence<Is...>)
+	{
+		size_type offset(0);
+		int dummy[] = { 0, (offset = align_column(offset + capacity * sizeof(column_type<Is>)), 0)... };
+		(void)dummy;
+		// Allocator doesn't do big alignments, so pad and align base manually.
+		return offset + kColumnAlignment - 1;
+	}
+	void* allocate_block(size_type capacity, columns_t& columns, size_type& bytes)
+	{
+		bytes = block_bytes(capacity, std::index_sequence_for<Ts...>());
+		void* block = m_allocator.allocate(bytes);
+		char* base = reinterpret_cast<char*>(align_column(reinterpret_cast<uintptr_t>(block)));
+		place_columns(base, capacity, columns, std::index_sequence_for<Ts...>());
+		return block;
+	}
+	void reallocate(size_type newCapacity)
+	{
+		RDE_ASSERT(newCapacity >= m_size);
+		columns_t newColumns;
+		size_type newBlockBytes;
+		void* newBlock = allocate_block(newCapacity, newColumns, newBlockBytes);
+		if (m_block)
+		{
+			const size_type n = m_size;
+			for_each_column_pair(newColumns, [n](auto* dst, auto* src) { rde::relocate_n(src, n, dst); });
+			m_allocator.deallocate(m_block, m_blockBytes);
+		}
+		m_block = newBlock;
+		m_blockBytes = newBlockBytes;
+		m_columns = newColumns;
+		m_capacity = newCapacity;
+	}
+	void copy(const basic_soa_vector& rhs)
+	{
+		reserve(rhs.m_size);
+		const size_type n = rhs.m_size;
+		columns_t rhsColumns = rhs.m_columns;
+		for_each_column_pair(rhsColumns, [n](auto* src, auto* dst)
+		{
+			for (size_type i = 0; i < n; ++i)
+				rde::copy_construct(dst + i, src[i]);
+		});
+		m_size = n;
+	}
+
+	void*			m_block;
+	size_type		m_blockBytes;
+	size_type		m_size;
+	size_type		m_capacity;
+	columns_t		m_columns;
+	TAllocator		m_allocator;
+};
+
+template<typename... Ts>
+using soa_vector = basic_soa_vector<rde::allocator, Ts...>;
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_SOA_VECTOR_H
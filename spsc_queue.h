@@ -0,0 +1,207 @@
+#ifndef RDESTL_SPSC_QUEUE_H
+#define RDESTL_SPSC_QUEUE_H
+
+#include <atomic>
+#include "algorithm.h"
+#include "allocator.h"
+
+namespace rde
+{
+namespace internal
+{
+	// Fixed capacity, elements live inside of the queue object.
+	template<typename T, size_t TCapacity, class TAllocator>
+	struct spsc_queue_storage
+	{
+		static_assert((TCapacity & (TCapacity - 1)) == 0, "spsc_queue capacity must be power of two");
+
+		spsc_queue_storage(size_t /*capacity*/, const TAllocator&) {}
+
+		RDE_FORCEINLINE T* buffer()				{ return reinterpret_cast<T*>(&m_data[0]); }
+		RDE_FORCEINLINE size_t capacity() const	{ return TCapacity; }
+
+		alignas(T) unsigned char	m_data[TCapacity * sizeof(T)];
+	};
+	// Capacity given at construction (rounded up to power of two), never grows.
+	template<typename T, class TAllocator>
+	struct spsc_queue_storage<T, 0, TAllocator>
+	{
+		spsc_queue_storage(size_t capacity, const TAllocator& allocator)
+			: m_capacity(round_up_pow2(capacity)),
+			m_allocator(allocator)
+		{
+			m_data = static_cast<T*>(m_allocator.allocate(m_capacity * sizeof(T)));
+		}
+		~spsc_queue_storage()
+		{
+			m_allocator.deallocate(m_data, m_capacity * sizeof(T));
+		}
+
+		RDE_FORCEINLINE T* buffer()				{ return m_data; }
+		RDE_FORCEINLINE size_t capacity() const	{ return m_capacity; }
+
+		T*			m_data;
+		size_t		m_capacity;
+		TAllocator	m_allocator;
+	};
+} // namespace internal
+
+//=============================================================================
+// Lock-free single-producer/single-consumer bounded queue.
+// - exactly one thread may push (try_push/try_emplace/push_n),
+// - exactly one (other) thread may pop (try_pop/pop_n).
+// Producer and consumer indices live on separate cache lines. Each side keeps
+// a cached copy of the other one's index and only reloads it (cross-core
+// traffic) when queue looks full/empty.
+// TCapacity > 0 - fixed capacity (power of two), storage is part of the object.
+// TCapacity == 0 - capacity passed to constructor, rounded up to power of two.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename T, size_t TCapacity = 0, class TAllocator = rde::allocator>
+class spsc_queue: private internal::spsc_queue_storage<T, TCapacity, TAllocator>
+{
+	typedef internal::spsc_queue_storage<T, TCapacity, TAllocator>	storage;
+public:
+	typedef T			value_type;
+	typedef size_t		size_type;
+	typedef TAllocator	allocator_type;
+
+	explicit spsc_queue(size_type capacity = TCapacity, const allocator_type& allocator = allocator_type())
+		: storage(capacity, allocator),
+		m_mask(storage::capacity() - 1),
+		m_tail(0),
+		m_headCache(0),
+		m_head(0),
+		m_tailCache(0)
+	{
+		RDE_ASSERT(storage::capacity() > 0);
+	}
+	// Not thread-safe, no other thread may use the queue at this point.
+	~spsc_queue()
+	{
+		const size_type tail = m_tail.load(std::memory_order_acquire);
+		for (size_type i = m_head.load(std::memory_order_relaxed); i != tail; ++i)
+			rde::destruct(storage::buffer() + (i & m_mask));
+	}
+
+	// Producer side.
+	bool try_push(const T& v)
+	{
+		const size_type tail = m_tail.load(std::memory_order_relaxed);
+		if (!has_room(tail, 1))
+			return false;
+		rde::copy_construct(storage::buffer() + (tail & m_mask), v);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	template<class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		const size_type tail = m_tail.load(std::memory_order_relaxed);
+		if (!has_room(tail, 1))
+			return false;
+		rde::construct_args(storage::buffer() + (tail & m_mask), std::forward<Args>(args)...);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	// Pushes up to n elements (as many as fit), publishes them all at once.
+	// Returns number of elements pushed.
+	size_type push_n(const T* values, size_type n)
+	{
+		const size_type tail = m_tail.load(std::memory_order_relaxed);
+		size_type room = capacity() - (tail - m_headCache);
+		if (room < n)
+		{
+			m_headCache = m_head.load(std::memory_order_acquire);
+			room = capacity() - (tail - m_headCache);
+		}
+		if (n > room)
+			n = room;
+		for (size_type i = 0; i < n; ++i)
+			rde::copy_construct(storage::buffer() + ((tail + i) & m_mask), values[i]);
+		m_tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	// Consumer side.
+	bool try_pop(T& out)
+	{
+		const size_type head = m_head.load(std::memory_order_relaxed);
+		if (!has_data(head, 1))
+			return false;
+		T* slot = storage::buffer() + (head & m_mask);
+		out = std::move(*slot);
+		rde::destruct(slot);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	// Pops up to n elements, returns number of elements popped.
+	size_type pop_n(T* out, size_type n)
+	{
+		const size_type head = m_head.load(std::memory_order_relaxed);
+		size_type available = m_tailCache - head;
+		if (available < n)
+		{
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			available = m_tailCache - head;
+		}
+		if (n > available)
+			n = available;
+		for (size_type i = 0; i < n; ++i)
+		{
+			T* slot = storage::buffer() + ((head + i) & m_mask);
+			out[i] = std::move(*slot);
+			rde::destruct(slot);
+		}
+		m_head.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+	// Approximate if called while other thread is pushing/popping.
+	size_type size_approx() const
+	{
+		const size_type head = m_head.load(std::memory_order_acquire);
+		return m_tail.load(std::memory_order_acquire) - head;
+	}
+	bool empty_approx() const		{ return size_approx() == 0; }
+	size_type capacity() const		{ return m_mask + 1; }
+
+private:
+	spsc_queue(const spsc_queue&);
+	spsc_queue& operator=(const spsc_queue&);
+
+	RDE_FORCEINLINE bool has_room(size_type tail, size_type n)
+	{
+		if (tail - m_headCache + n <= capacity())
+			return true;
+		m_headCache = m_head.load(std::memory_order_acquire);
+		return tail - m_headCache + n <= capacity();
+	}
+	RDE_FORCEINLINE bool has_data(size_type head, size_type n)
+	{
+		if (m_tailCache - head >= n)
+			return true;
+		m_tailCache = m_tail.load(std::memory_order_acquire);
+		return m_tailCache - head >= n;
+	}
+
+	// Every group starts on its own cache line (mask is also kept away from inline elements).
+	// Read-only after construction.
+	alignas(RDE_CACHE_LINE_SIZE) size_type					m_mask;
+	// Producer.
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<size_type>	m_tail;
+	size_type												m_headCache;
+	// Consumer.
+	alignas(RDE_CACHE_LINE_SIZE) std::atomic<size_type>	m_head;
+	size_type												m_tailCache;
+};
+// Storage, mask, producer and consumer on separate cache lines.
+static_assert(alignof(spsc_queue<int>) == RDE_CACHE_LINE_SIZE &&
+	sizeof(spsc_queue<int>) >= 4 * RDE_CACHE_LINE_SIZE, "spsc_queue groups should be cache line aligned");
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_SPSC_QUEUE_H
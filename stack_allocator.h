@@ -33,6 +33,17 @@ public:
 		RDE_ASSERT(ptr == 0 || (ptr >= &m_buffer[0] && ptr < &m_buffer[TBytes]));
 		sizeof(ptr);
 	}
+	// Only the most recent allocation can grow.
+	bool try_expand(void* ptr, size_t oldBytes, size_t newBytes)
+	{
+		if (static_cast<char*>(ptr) + oldBytes != &m_buffer[0] + m_bufferTop)
+			return false;
+		const size_t extraBytes = newBytes - oldBytes;
+		if (m_bufferTop + extraBytes > TBytes)
+			return false;
+		m_bufferTop += extraBytes;
+		return true;
+	}
 
 	const char* get_name() const { return m_name; }
 
@@ -0,0 +1,423 @@
+#ifndef RDESTL_SWMR_HASH_MAP_H
+#define RDESTL_SWMR_HASH_MAP_H
+
+#include <atomic>
+#include <type_traits>
+#include "algorithm.h"
+#include "allocator.h"
+#include "functional.h"
+#include "pair.h"
+#include "rhash.h"
+#include "vector.h"
+
+namespace rde
+{
+
+// Single-writer/multi-reader hash map for read-mostly tables.
+// - exactly one thread may modify the map (insert/erase/clear/reclaim),
+// - any number of threads may look up concurrently, through reader handles.
+// Lookups never take locks nor write to shared memory (apart from reader's own,
+// cache line sized slot), so they scale with number of cores. Every bucket is
+// guarded by a sequence lock, reader only retries if writer modifies the very
+// bucket it's looking at.
+// Old bucket arrays (after grow) are freed once every registered reader is done
+// with them (epoch based reclamation), so readers never touch freed memory.
+// Keys and values are copied in and out, they have to be trivially copyable.
+// Load factor is 7/8th, same as hash_map.
+#pragma warning(push)
+// structure was padded due to alignment specifier
+#pragma warning(disable: 4324)
+template<typename TKey, typename TValue,
+	class THashFunc		= rde::hash<TKey>,
+	class TKeyEqualFunc	= rde::equal_to<TKey>,
+	class TAllocator	= rde::allocator,
+	int TMaxReaders		= 64
+>
+class swmr_hash_map
+{
+	struct node
+	{
+		static const hash_value_t kUnusedHash	= 0xFFFFFFFF;
+		static const hash_value_t kDeletedHash	= 0xFFFFFFFE;
+
+		RDE_FORCEINLINE bool is_unused() const		{ return hash == kUnusedHash; }
+		RDE_FORCEINLINE bool is_deleted() const		{ return hash == kDeletedHash; }
+		RDE_FORCEINLINE bool is_occupied() const	{ return hash < kDeletedHash; }
+
+		// Odd while writer is modifying this node.
+		std::atomic<std::uint32_t>	sequence;
+		hash_value_t				hash;
+		TKey						key;
+		TValue						value;
+	};
+	struct table
+	{
+		node*			nodes;
+		std::uint32_t	capacity;
+		std::uint32_t	capacityMask;
+		// Epoch in which this table was replaced.
+		std::uint64_t	retireEpoch;
+	};
+	// Cache line per reader, so readers never write to the same line.
+	struct alignas(RDE_CACHE_LINE_SIZE) reader_slot
+	{
+		// 0 if reader is not inside of lookup, global epoch at the beginning of lookup otherwise.
+		std::atomic<std::uint64_t>	epoch;
+		std::atomic<bool>			registered;
+	};
+	static_assert(sizeof(reader_slot) == RDE_CACHE_LINE_SIZE, "reader slot should take exactly one cache line");
+
+public:
+	typedef TKey			key_type;
+	typedef TValue			mapped_type;
+	typedef TAllocator		allocator_type;
+	typedef size_t			size_type;
+
+	static_assert(std::is_trivially_copyable<TKey>::value && std::is_trivially_copyable<TValue>::value,
+		"swmr_hash_map requires trivially copyable keys and values");
+
+	static const size_type	kInitialCapacity = 64;
+	static const int		kInvalidReader = -1;
+
+	// Lookup handle, one per reading thread. Not thread-safe itself.
+	class reader
+	{
+	public:
+		explicit reader(const swmr_hash_map& map)
+			: m_map(map),
+			m_id(map.register_reader())
+		{
+			/**/
+		}
+		~reader()
+		{
+			m_map.unregister_reader(m_id);
+		}
+
+		bool find(const key_type& key, mapped_type& out_value) const
+		{
+			return m_map.find(m_id, key, out_value);
+		}
+		bool contains(const key_type& key) const
+		{
+			mapped_type unused;
+			return m_map.find(m_id, key, unused);
+		}
+
+	private:
+		reader(const reader&);
+		reader& operator=(const reader&);
+
+		const swmr_hash_map&	m_map;
+		const int				m_id;
+	};
+
+	explicit swmr_hash_map(const allocator_type& allocator = allocator_type())
+		: m_epoch(1),
+		m_size(0),
+		m_numUsed(0),
+		m_retired(allocator),
+		m_allocator(allocator)
+	{
+		m_table.store(allocate_table(kInitialCapacity));
+		for (int i = 0; i < TMaxReaders; ++i)
+		{
+			m_readers[i].epoch.store(0, std::memory_order_relaxed);
+			m_readers[i].registered.store(false, std::memory_order_relaxed);
+		}
+	}
+	// @pre no readers.
+	~swmr_hash_map()
+	{
+		free_table(m_table.load(std::memory_order_relaxed));
+		for (typename retired_tables_t::iterator it = m_retired.begin(); it != m_retired.end(); ++it)
+			free_table(*it);
+	}
+
+	// Reader-side interface, safe to call concurrently with writer.
+	// @return reader id to be passed to find, kInvalidReader if out of slots.
+	int register_reader() const
+	{
+		for (int i = 0; i < TMaxReaders; ++i)
+		{
+			bool expected(false);
+			if (!m_readers[i].registered.load(std::memory_order_relaxed) &&
+				m_readers[i].registered.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				return i;
+			}
+		}
+		RDE_ASSERT(!"swmr_hash_map: too many readers");
+		return kInvalidReader;
+	}
+	void unregister_reader(int reader_id) const
+	{
+		if (reader_id == kInvalidReader)
+			return;
+		RDE_ASSERT(reader_id >= 0 && reader_id < TMaxReaders);
+		m_readers[reader_id].epoch.store(0, std::memory_order_release);
+		m_readers[reader_id].registered.store(false, std::memory_order_release);
+	}
+	bool find(int reader_id, const key_type& key, mapped_type& out_value) const
+	{
+		if (reader_id == kInvalidReader)
+			return false;
+		RDE_ASSERT(reader_id >= 0 && reader_id < TMaxReaders);
+		reader_slot& slot = m_readers[reader_id];
+		slot.epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+		const bool found = lookup(*m_table.load(std::memory_order_seq_cst), key, out_value);
+		slot.epoch.store(0, std::memory_order_release);
+		return found;
+	}
+
+	// Writer-side interface.
+	// Inserts new element or overwrites value of existing one.
+	// @return true if new element was inserted.
+	bool insert(const key_type& key, const mapped_type& value)
+	{
+		table* t = m_table.load(std::memory_order_relaxed);
+		if (m_numUsed * 8 >= t->capacity * 7)
+			t = grow();
+
+		const hash_value_t hash = hash_func(key);
+		std::uint32_t i = hash & t->capacityMask;
+		node* n = t->nodes + i;
+		node* freeNode(0);
+		std::uint32_t numProbes(0);
+		while (!n->is_unused())
+		{
+			if (n->hash == hash && m_keyEqualFunc(key, n->key))
+			{
+				write_node(n, hash, key, value);
+				return false;
+			}
+			if (n->is_deleted() && freeNode == 0)
+				freeNode = n;
+			++numProbes;
+			i = (i + numProbes) & t->capacityMask;
+			n = t->nodes + i;
+		}
+		if (freeNode == 0)
+		{
+			freeNode = n;
+			++m_numUsed;
+		}
+		write_node(freeNode, hash, key, value);
+		++m_size;
+		reclaim();
+		return true;
+	}
+	bool erase(const key_type& key)
+	{
+		table* t = m_table.load(std::memory_order_relaxed);
+		const hash_value_t hash = hash_func(key);
+		std::uint32_t i = hash & t->capacityMask;
+		node* n = t->nodes + i;
+		std::uint32_t numProbes(0);
+		while (!n->is_unused())
+		{
+			if (n->hash == hash && m_keyEqualFunc(key, n->key))
+			{
+				begin_write(n);
+				n->hash = node::kDeletedHash;
+				end_write(n);
+				--m_size;
+				reclaim();
+				return true;
+			}
+			++numProbes;
+			i = (i + numProbes) & t->capacityMask;
+			n = t->nodes + i;
+		}
+		return false;
+	}
+	// Replaces bucket array with an empty one, old one is reclaimed later.
+	void clear()
+	{
+		if (m_size == 0 && m_numUsed == 0)
+			return;
+		table* t = m_table.load(std::memory_order_relaxed);
+		publish(allocate_table(t->capacity));
+		m_size = 0;
+		m_numUsed = 0;
+	}
+	// Frees bucket arrays that no reader can see anymore.
+	// Called automatically by writer operations, explicit calls are only needed
+	// to release memory sooner when the map is no longer modified.
+	void reclaim()
+	{
+		if (m_retired.empty())
+			return;
+		const std::uint64_t minEpoch = min_reader_epoch();
+		for (size_type i = 0; i < m_retired.size(); )
+		{
+			table* t = m_retired[i];
+			if (t->retireEpoch <= minEpoch)
+			{
+				free_table(t);
+				m_retired.erase_unordered(m_retired.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	// Writer only (no synchronization).
+	size_type size() const			{ return m_size; }
+	bool empty() const				{ return m_size == 0; }
+	size_type bucket_count() const	{ return m_table.load(std::memory_order_relaxed)->capacity; }
+	size_type retired_count() const	{ return m_retired.size(); }
+
+	const allocator_type& get_allocator() const	{ return m_allocator; }
+
+private:
+	typedef rde::vector<table*, TAllocator>	retired_tables_t;
+
+	swmr_hash_map(const swmr_hash_map&);
+	swmr_hash_map& operator=(const swmr_hash_map&);
+
+	bool lookup(const table& t, const key_type& key, mapped_type& out_value) const
+	{
+		const hash_value_t hash = hash_func(key);
+		std::uint32_t i = hash & t.capacityMask;
+		std::uint32_t numProbes(0);
+		for (;;)
+		{
+			const node* n = t.nodes + i;
+			std::uint32_t seq;
+			hash_value_t nodeHash;
+			bool match;
+			// Sequence lock read side: retry if writer touched this node in the meantime.
+			do
+			{
+				do
+				{
+					seq = n->sequence.load(std::memory_order_acquire);
+				} while (seq & 1);
+				nodeHash = n->hash;
+				match = (nodeHash == hash && m_keyEqualFunc(key, n->key));
+				if (match)
+					out_value = n->value;
+				std::atomic_thread_fence(std::memory_order_acquire);
+			} while (n->sequence.load(std::memory_order_relaxed) != seq);
+
+			if (match)
+				return true;
+			if (nodeHash == node::kUnusedHash)
+				return false;
+			++numProbes;
+			i = (i + numProbes) & t.capacityMask;
+		}
+	}
+
+	RDE_FORCEINLINE void begin_write(node* n)
+	{
+		n->sequence.store(n->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+	RDE_FORCEINLINE void end_write(node* n)
+	{
+		n->sequence.store(n->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	void write_node(node* n, hash_value_t hash, const key_type& key, const mapped_type& value)
+	{
+		begin_write(n);
+		n->key = key;
+		n->value = value;
+		n->hash = hash;
+		end_write(n);
+	}
+
+	table* grow()
+	{
+		const table* oldTable = m_table.load(std::memory_order_relaxed);
+		// Mostly deleted nodes? Just rehash in place (well, to the same size).
+		const std::uint32_t newCapacity = (m_size * 2 >= oldTable->capacity ? oldTable->capacity * 2 : oldTable->capacity);
+		table* newTable = allocate_table(newCapacity);
+		for (const node* it = oldTable->nodes, *itEnd = oldTable->nodes + oldTable->capacity; it != itEnd; ++it)
+		{
+			if (!it->is_occupied())
+				continue;
+			std::uint32_t i = it->hash & newTable->capacityMask;
+			node* n = newTable->nodes + i;
+			std::uint32_t numProbes(0);
+			while (!n->is_unused())
+			{
+				++numProbes;
+				i = (i + numProbes) & newTable->capacityMask;
+				n = newTable->nodes + i;
+			}
+			n->hash = it->hash;
+			n->key = it->key;
+			n->value = it->value;
+		}
+		m_numUsed = m_size;
+		publish(newTable);
+		return newTable;
+	}
+	void publish(table* newTable)
+	{
+		table* oldTable = m_table.load(std::memory_order_relaxed);
+		m_table.store(newTable, std::memory_order_seq_cst);
+		// Readers that start after this increment are guaranteed to see new table.
+		oldTable->retireEpoch = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+		m_retired.push_back(oldTable);
+		reclaim();
+	}
+	// @return oldest epoch that is still observed by any reader.
+	std::uint64_t min_reader_epoch() const
+	{
+		std::uint64_t minEpoch = m_epoch.load(std::memory_order_seq_cst);
+		for (int i = 0; i < TMaxReaders; ++i)
+		{
+			const std::uint64_t e = m_readers[i].epoch.load(std::memory_order_seq_cst);
+			if (e != 0 && e < minEpoch)
+				minEpoch = e;
+		}
+		return minEpoch;
+	}
+
+	table* allocate_table(std::uint32_t capacity)
+	{
+		RDE_ASSERT((capacity & (capacity - 1)) == 0);	// Must be power-of-two
+		table* t = static_cast<table*>(m_allocator.allocate(sizeof(table)));
+		t->nodes = static_cast<node*>(m_allocator.allocate(sizeof(node) * capacity));
+		t->capacity = capacity;
+		t->capacityMask = capacity - 1;
+		t->retireEpoch = 0;
+		for (std::uint32_t i = 0; i < capacity; ++i)
+		{
+			::new (static_cast<void*>(&t->nodes[i].sequence)) std::atomic<std::uint32_t>(0);
+			t->nodes[i].hash = node::kUnusedHash;
+		}
+		return t;
+	}
+	void free_table(table* t)
+	{
+		m_allocator.deallocate(t->nodes, sizeof(node) * t->capacity);
+		m_allocator.deallocate(t, sizeof(table));
+	}
+
+	RDE_FORCEINLINE hash_value_t hash_func(const key_type& key) const
+	{
+		return m_hashFunc(key) & 0xFFFFFFFD;
+	}
+
+	mutable reader_slot			m_readers[TMaxReaders];
+	std::atomic<table*>			m_table;
+	std::atomic<std::uint64_t>	m_epoch;
+	size_type					m_size;
+	size_type					m_numUsed;
+	retired_tables_t			m_retired;
+	THashFunc					m_hashFunc;
+	TKeyEqualFunc				m_keyEqualFunc;
+	TAllocator					m_allocator;
+};
+#pragma warning(pop)
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_SWMR_HASH_MAP_H
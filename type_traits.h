@@ -1,6 +1,8 @@
 #ifndef RDESTL_TYPETRAITS_H
 #define RDESTL_TYPETRAITS_H
 
+#include <type_traits>
+
 namespace rde
 {
 template<typename T> struct is_integral
@@ -83,6 +85,18 @@ template<typename T> struct has_trivial_destructor
 	};
 };
 
+// Object can be moved to another memory location with memcpy, without running
+// move constructor for the new object/destructor for the old one.
+// Detected for trivially copyable types, specialize for types that don't point
+// into themselves (see vector.h).
+template<typename T> struct is_trivially_relocatable
+{
+	enum
+	{
+		value = has_trivial_copy<T>::value || std::is_trivially_copyable<T>::value
+	};
+};
+
 template<typename T> struct has_cheap_compare
 {
 	enum
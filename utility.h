@@ -105,6 +105,34 @@ namespace internal
 		Sys::MemCpy(result, first, n * sizeof(T));
 	}
 
+	template<typename T>
+	void relocate_n(T* first, size_t n, T* result, int_to_type<false>)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			new (result + i) T(std::move(first[i]));
+			(first + i)->~T();
+		}
+	}
+	template<typename T>
+	void relocate_n(T* first, size_t n, T* result, int_to_type<true>)
+	{
+		RDE_ASSERT(result >= first + n || result < first);
+		Sys::MemCpy(result, first, n * sizeof(T));
+	}
+
+	template<typename T> RDE_FORCEINLINE
+	void relocate(T* mem, T* from, int_to_type<false>)
+	{
+		new (mem) T(std::move(*from));
+		from->~T();
+	}
+	template<typename T> RDE_FORCEINLINE
+	void relocate(T* mem, T* from, int_to_type<true>)
+	{
+		Sys::MemCpy(mem, from, sizeof(T));
+	}
+
 	template<typename T>
 	void destruct_n(T* first, size_t n, int_to_type<false>)
 	{
@@ -166,6 +194,18 @@ namespace internal
 		// trivial ctor, nothing to do.
 	}
 
+	template<typename T>
+	void default_construct_n(T* to, size_t count, int_to_type<false>)
+	{
+		for (size_t i = 0; i < count; ++i)
+			new (to + i) T;
+	}
+	template<typename T> inline
+	void default_construct_n(T*, size_t, int_to_type<true>)
+	{
+		// trivial ctor, memory stays as it is.
+	}
+
 	// Tests if all elements in range are ordered according to pred.
 	template<class TIter, class TPred>
 	void test_ordering(TIter first, TIter last, const TPred& pred)
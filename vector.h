@@ -15,6 +15,45 @@ struct base_vector
 	static const size_type	npos = size_type(-1);
 };
 
+//=============================================================================
+// Growth policies, compute new capacity when vector runs out of space.
+// @param capacity		current capacity (elements)
+// @param minCapacity	capacity required
+struct vector_growth_double
+{
+	static base_vector::size_type next_capacity(base_vector::size_type capacity,
+		base_vector::size_type minCapacity, base_vector::size_type /*elementSize*/)
+	{
+		const base_vector::size_type c = capacity * 2;
+		return minCapacity > c ? minCapacity : c;
+	}
+};
+// Less memory wasted, but more reallocations.
+struct vector_growth_one_and_half
+{
+	static base_vector::size_type next_capacity(base_vector::size_type capacity,
+		base_vector::size_type minCapacity, base_vector::size_type /*elementSize*/)
+	{
+		const base_vector::size_type c = capacity + capacity / 2;
+		return minCapacity > c ? minCapacity : c;
+	}
+};
+// Doubles, then rounds size of buffer up to whole pages (only once it's bigger
+// than one page). Works well with allocators that can expand in place.
+template<base_vector::size_type TPageSize = 4096>
+struct vector_growth_page_rounded
+{
+	static base_vector::size_type next_capacity(base_vector::size_type capacity,
+		base_vector::size_type minCapacity, base_vector::size_type elementSize)
+	{
+		const base_vector::size_type c = vector_growth_double::next_capacity(capacity, minCapacity, elementSize);
+		const base_vector::size_type bytes = c * elementSize;
+		if (bytes <= TPageSize)
+			return c;
+		return ((bytes + TPageSize - 1) & ~(TPageSize - 1)) / elementSize;
+	}
+};
+
 //=============================================================================
 // Standard vector storage.
 // Dynamic allocation, can grow, can shrink.
@@ -51,13 +90,18 @@ struct standard_vector_storage
 
 	void reallocate(base_vector::size_type newCapacity, base_vector::size_type oldSize)
 	{
+		const base_vector::size_type oldCapacity = base_vector::size_type(m_capacityEnd - m_begin);
+		if (m_begin && newCapacity > oldCapacity && try_grow_in_place(newCapacity, oldCapacity, oldSize))
+			return;
+
 		T* newBegin = static_cast<T*>(m_allocator.allocate(newCapacity * sizeof(T)));
 		const base_vector::size_type newSize = oldSize < newCapacity ? oldSize : newCapacity;
 		// Copy old data if needed.
 		if (m_begin)
 		{
-			rde::move_construct_n(m_begin, newSize, newBegin);
-			destroy(m_begin, oldSize);
+			rde::relocate_n(m_begin, newSize, newBegin);
+			rde::destruct_n(m_begin + newSize, oldSize - newSize);
+			m_allocator.deallocate(m_begin, oldCapacity * sizeof(T));
 		}
 		m_begin = newBegin;
 		m_end = m_begin + newSize;
@@ -65,6 +109,29 @@ struct standard_vector_storage
 		RDE_ASSERT(invariant());
 	}
 
+	// Uses optional allocator hooks, so that elements don't have to be moved one by one.
+	bool try_grow_in_place(base_vector::size_type newCapacity, base_vector::size_type oldCapacity,
+		base_vector::size_type oldSize)
+	{
+		if (allocator_try_expand(m_allocator, m_begin, oldCapacity * sizeof(T), newCapacity * sizeof(T)))
+		{
+			m_capacityEnd = m_begin + newCapacity;
+			return true;
+		}
+		// realloc may move elements bitwise.
+		if (!is_trivially_relocatable<T>::value)
+			return false;
+		T* newBegin = static_cast<T*>(allocator_reallocate(m_allocator, m_begin,
+			oldCapacity * sizeof(T), newCapacity * sizeof(T)));
+		if (newBegin == 0)
+			return false;
+		m_begin = newBegin;
+		m_end = m_begin + oldSize;
+		m_capacityEnd = m_begin + newCapacity;
+		RDE_ASSERT(invariant());
+		return true;
+	}
+
 	// Reallocates memory, doesnt copy contents of old buffer.
 	void reallocate_discard_old(base_vector::size_type newCapacity)
 	{
@@ -78,15 +145,17 @@ struct standard_vector_storage
 		m_capacityEnd = m_begin + newCapacity;
 		RDE_ASSERT(invariant());
 	}
+	// Destructs n elements, frees whole block (capacity, not size).
 	void destroy(T* ptr, base_vector::size_type n)
 	{
+		RDE_ASSERT(ptr == m_begin);
 		rde::destruct_n(ptr, n);
-		m_allocator.deallocate(ptr, n * sizeof(T));
+		m_allocator.deallocate(ptr, (m_capacityEnd - m_begin) * sizeof(T));
 	}
 	void reset()
 	{
 		if (m_begin)
-			m_allocator.deallocate(m_begin, (m_end - m_begin) * sizeof(T));
+			m_allocator.deallocate(m_begin, (m_capacityEnd - m_begin) * sizeof(T));
 
 		m_begin = m_end = 0;
 		m_capacityEnd = 0;
@@ -109,9 +178,11 @@ struct standard_vector_storage
 //=============================================================================
 // Simplified vector class.
 // Mimics std::vector.
+// TGrowthPolicy decides how capacity grows (vector_growth_double/_one_and_half/_page_rounded).
 template<typename T,
 	class TAllocator = rde::allocator,
-	class TStorage   = standard_vector_storage<T, TAllocator>
+	class TStorage   = standard_vector_storage<T, TAllocator>,
+	class TGrowthPolicy = vector_growth_double
 >
 class vector: public base_vector, private TStorage
 {
@@ -328,27 +399,35 @@ public:
 			grow();
 			pos = m_begin + index;
 		}
-		else
-		{
-			rde::construct(m_end);
-		}
 
 		// @note: conditional vs empty loop, what's better?
 		if (m_end > pos)
 		{
-			if (!has_trivial_copy<T>::value)
+			if (!is_trivially_relocatable<T>::value)
 			{
 				const size_type prevSize = size();
 				RDE_ASSERT(index <= prevSize);
 				const size_type toMove = prevSize - index;
 
-				rde::internal::move_n(pos, toMove, pos + 1, int_to_type<has_trivial_copy<T>::value>());
+				rde::construct_args(m_end, std::move(*(m_end - 1)));
+				rde::internal::move_n(pos, toMove - 1, pos + 1, int_to_type<has_trivial_copy<T>::value>());
+				rde::destruct(pos);
 			}
 			else
 			{
+				// args may refer to an element that's about to be shifted, so new
+				// element is constructed first, then moved into place bitwise.
+				alignas(T) unsigned char buffer[sizeof(T)];
+				rde::construct_args(reinterpret_cast<T*>(buffer), std::forward<Args>(args)...);
+				// Bitwise shift, leaves raw memory at pos.
 				RDE_ASSERT(pos < m_end);
 				const size_type n = reinterpret_cast<uintptr_t>(m_end) - reinterpret_cast<uintptr_t>(pos);
 				Sys::MemMove(pos + 1, pos, n);
+				Sys::MemCpy(pos, buffer, sizeof(T));
+				++m_end;
+				RDE_ASSERT(invariant());
+				TStorage::record_high_watermark();
+				return pos;
 			}
 		}
 		rde::construct_args(pos, std::forward<Args>(args)...);
@@ -362,6 +441,13 @@ public:
 	{
 		RDE_ASSERT(invariant());
 		RDE_ASSERT(index >= 0); // FIXME: Having to use signed type for index param currently to prevent ambiguous overload matching ~SK
+		if (&val >= m_begin && &val < m_end)
+		{
+			// val would be moved (or freed) under us.
+			const T copy(val);
+			insert(index, n, copy);
+			return;
+		}
 		const size_type indexEnd = index + n;
 		const size_type prevSize = size();
 		if (m_end + n > m_capacityEnd)
@@ -383,6 +469,13 @@ public:
 			for (size_type i = 0; i < numCopy; ++i)
 				m_begin[index + i] = val;
 		}
+		else if (is_trivially_relocatable<T>::value)
+		{
+			iterator insertPos = m_begin + index;
+			Sys::MemMove(insertPos + n, insertPos, (prevSize - index) * sizeof(T));
+			for (size_type i = 0; i < n; ++i)
+				rde::copy_construct(insertPos + i, val);
+		}
 		else
 		{
 			rde::copy_construct_n(m_end - n, n, m_end);
@@ -415,6 +508,14 @@ public:
 		RDE_ASSERT(it != end());
 		RDE_ASSERT(invariant());
 
+		if (is_trivially_relocatable<T>::value)
+		{
+			// Destroy *it, then shift the rest down bitwise.
+			rde::destruct(it);
+			Sys::MemMove(it, it + 1, (m_end - it - 1) * sizeof(T));
+			--m_end;
+			return it;
+		}
 		// Move everything down, overwriting *it
 		if (it + 1 < m_end)
 		{
@@ -434,7 +535,13 @@ public:
 
 		const size_type indexFirst = size_type(first - m_begin);
 		const size_type toRemove = size_type(last - first);
-		if (toRemove > 0)
+		if (toRemove > 0 && is_trivially_relocatable<T>::value)
+		{
+			rde::destruct_n(first, toRemove);
+			Sys::MemMove(first, last, (m_end - last) * sizeof(T));
+			m_end -= toRemove;
+		}
+		else if (toRemove > 0)
 		{
 			move_down(last, first, int_to_type<has_trivial_copy<T>::value>());
 			shrink(size() - toRemove);
@@ -464,6 +571,74 @@ public:
 		// slower version
 		//erase(m_begin + n, m_end);
 	}
+	// Like resize, but new elements are default-initialized (ie. left
+	// uninitialized for trivial types, no memset).
+	void resize_default_init(size_type n)
+	{
+		const size_type prevSize = size();
+		if (n <= prevSize)
+		{
+			shrink(n);
+			return;
+		}
+		if (n > capacity())
+			reallocate(compute_new_capacity(n), prevSize);
+		rde::default_construct_n(m_end, n - prevSize);
+		m_end = m_begin + n;
+		TStorage::record_high_watermark();
+	}
+	// Grows vector by n default-initialized elements, returns pointer to the first
+	// one, so it can be filled directly (fread, decompression, etc).
+	T* append_uninitialized(size_type n)
+	{
+		const size_type prevSize = size();
+		resize_default_init(prevSize + n);
+		return m_begin + prevSize;
+	}
+	// Inserts copies of [first, last) before pos, with at most one reallocation.
+	// @pre [first, last) is not a part of this vector.
+	iterator insert_range(iterator pos, const T* first, const T* last)
+	{
+		RDE_ASSERT(validate_iterator(pos));
+		RDE_ASSERT(last <= m_begin || first >= m_capacityEnd || first == last);
+		const size_type n = size_type(last - first);
+		const size_type index = size_type(pos - m_begin);
+		if (n == 0)
+			return pos;
+		const size_type prevSize = size();
+		if (prevSize + n > capacity())
+			reallocate(compute_new_capacity(prevSize + n), prevSize);
+		pos = m_begin + index;
+		const size_type toMove = prevSize - index;
+		if (is_trivially_relocatable<T>::value)
+		{
+			Sys::MemMove(pos + n, pos, toMove * sizeof(T));
+			internal::copy_construct_n(first, n, pos, int_to_type<has_trivial_copy<T>::value>());
+		}
+		else if (toMove > n)
+		{
+			// Tail goes to raw memory, rest of old elements is shifted by assignment.
+			for (size_type i = 0; i < n; ++i)
+				rde::construct_args(m_end + i, std::move(*(m_end - n + i)));
+			for (size_type i = toMove - n; i > 0; --i)
+				pos[i - 1 + n] = std::move(pos[i - 1]);
+			for (size_type i = 0; i < n; ++i)
+				pos[i] = first[i];
+		}
+		else
+		{
+			for (size_type i = toMove; i < n; ++i)
+				rde::copy_construct(pos + i, first[i]);
+			for (size_type i = 0; i < toMove; ++i)
+				rde::construct_args(pos + n + i, std::move(pos[i]));
+			for (size_type i = 0; i < toMove; ++i)
+				pos[i] = first[i];
+		}
+		m_end += n;
+		TStorage::record_high_watermark();
+		RDE_ASSERT(invariant());
+		return pos;
+	}
 	void reserve(size_type n)
 	{
 		if (n > capacity())
@@ -532,13 +707,15 @@ private:
 	size_type compute_new_capacity(size_type newMinCapacity) const
 	{
 		const size_type c = capacity();
-		return (newMinCapacity > c * 2 ? newMinCapacity : (c == 0 ? kInitialCapacity : c * 2));
+		if (c == 0 && newMinCapacity < kInitialCapacity)
+			newMinCapacity = kInitialCapacity;
+		return TGrowthPolicy::next_capacity(c, newMinCapacity, sizeof(T));
 	}
 	inline void grow()
 	{
 		RDE_ASSERT(m_end == m_capacityEnd);	// size == capacity!
 		const size_type c = capacity();
-		reallocate((m_capacityEnd == 0 ? kInitialCapacity : c * 2), c);
+		reallocate(compute_new_capacity(c + 1), c);
 	}
 	RDE_FORCEINLINE void shrink(size_type newSize)
 	{
@@ -573,6 +750,13 @@ private:
 	}
 };
 
+// Vector with standard storage only points to its heap buffer, it can be memcpy'd.
+template<typename T, class TAllocator, class TGrowthPolicy>
+struct is_trivially_relocatable<vector<T, TAllocator, standard_vector_storage<T, TAllocator>, TGrowthPolicy>>
+{
+	enum { value = is_trivially_relocatable<TAllocator>::value };
+};
+
 } // namespace rde
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,292 @@
+#ifndef RDESTL_VM_VECTOR_H
+#define RDESTL_VM_VECTOR_H
+
+#include <cstdlib>
+#include "vector.h"
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+namespace rde
+{
+namespace internal
+{
+	// Thin layer over OS virtual memory functions.
+	// Reserved range is inaccessible until committed.
+#ifdef _WIN32
+	inline size_t vm_page_size()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+	}
+	inline void* vm_reserve(size_t bytes)
+	{
+		return VirtualAlloc(0, bytes, MEM_RESERVE, PAGE_NOACCESS);
+	}
+	inline bool vm_commit(void* ptr, size_t bytes)
+	{
+		return VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) != 0;
+	}
+	inline void vm_decommit(void* ptr, size_t bytes)
+	{
+		VirtualFree(ptr, bytes, MEM_DECOMMIT);
+	}
+	inline void vm_release(void* ptr, size_t /*bytes*/)
+	{
+		VirtualFree(ptr, 0, MEM_RELEASE);
+	}
+#else
+	inline size_t vm_page_size()
+	{
+		return size_t(sysconf(_SC_PAGESIZE));
+	}
+	inline void* vm_reserve(size_t bytes)
+	{
+		void* ptr = mmap(0, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return ptr == MAP_FAILED ? 0 : ptr;
+	}
+	inline bool vm_commit(void* ptr, size_t bytes)
+	{
+		return mprotect(ptr, bytes, PROT_READ | PROT_WRITE) == 0;
+	}
+	inline void vm_decommit(void* ptr, size_t bytes)
+	{
+		// Mapping fresh PROT_NONE pages over the range gives physical memory back.
+		mmap(ptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+	}
+	inline void vm_release(void* ptr, size_t bytes)
+	{
+		munmap(ptr, bytes);
+	}
+#endif
+	// vector can't report failure from push_back/resize etc. and would write
+	// into pages that aren't there, so we stop right here (like failed new
+	// with no exceptions would).
+	inline void vm_out_of_memory(const char* reason)
+	{
+		RDE_ASSERT(!reason);
+		(void)reason;
+		std::abort();
+	}
+} // namespace internal
+
+//=============================================================================
+// Grows by at least 1/8th (and 64KB), vm_vector_storage rounds it to pages anyway.
+// Doubling makes less sense when nothing has to be copied.
+// Extra step never goes past reserved range (requested capacity still can).
+template<size_t TReserveBytes>
+struct vm_vector_growth
+{
+	static base_vector::size_type next_capacity(base_vector::size_type capacity,
+		base_vector::size_type minCapacity, base_vector::size_type elementSize)
+	{
+		const base_vector::size_type minStep = (64 * 1024 + elementSize - 1) / elementSize;
+		const base_vector::size_type step = capacity / 8 > minStep ? capacity / 8 : minStep;
+		const base_vector::size_type maxCapacity = TReserveBytes / elementSize;
+		base_vector::size_type newCapacity = capacity + step;
+		if (newCapacity > maxCapacity)
+			newCapacity = maxCapacity;
+		return minCapacity > newCapacity ? minCapacity : newCapacity;
+	}
+};
+
+//=============================================================================
+// Reserves TReserveBytes of address space on first use, commits/decommits pages
+// as vector grows/shrinks. Elements never move.
+template<typename T, class TAllocator, size_t TReserveBytes>
+struct vm_vector_storage
+{
+	explicit vm_vector_storage(const TAllocator& allocator)
+		: m_begin(0),
+		m_end(0),
+		m_capacityEnd(0),
+		m_committedBytes(0),
+		m_allocator(allocator)
+	{
+	}
+	vm_vector_storage(vm_vector_storage&& rhs)
+		: m_begin(std::exchange(rhs.m_begin, nullptr)),
+		m_end(std::exchange(rhs.m_end, nullptr)),
+		m_capacityEnd(std::exchange(rhs.m_capacityEnd, nullptr)),
+		m_committedBytes(std::exchange(rhs.m_committedBytes, 0)),
+		m_allocator(rhs.m_allocator)
+	{
+	}
+	explicit vm_vector_storage(e_noinitialize)
+	{
+	}
+
+	vm_vector_storage& operator=(vm_vector_storage&& rhs)
+	{
+		if (m_begin)
+			destroy(m_begin, base_vector::size_type(m_end - m_begin));
+		m_begin = std::exchange(rhs.m_begin, nullptr);
+		m_end = std::exchange(rhs.m_end, nullptr);
+		m_capacityEnd = std::exchange(rhs.m_capacityEnd, nullptr);
+		m_committedBytes = std::exchange(rhs.m_committedBytes, 0);
+		return *this;
+	}
+
+	// Never moves elements, only commits/decommits pages at the end.
+	// Aborts if address space can't be reserved or pages can't be committed.
+	void reallocate(base_vector::size_type newCapacity, base_vector::size_type oldSize)
+	{
+		const base_vector::size_type newSize = oldSize < newCapacity ? oldSize : newCapacity;
+		if (m_begin)
+			rde::destruct_n(m_begin + newSize, oldSize - newSize);
+		else if (!reserve())
+			internal::vm_out_of_memory("vm_vector: could not reserve address space");
+		if (!commit(newCapacity))
+			internal::vm_out_of_memory("vm_vector: could not commit memory");
+		m_end = m_begin + newSize;
+		RDE_ASSERT(invariant());
+	}
+
+	// Reallocates memory, doesnt copy contents of old buffer.
+	void reallocate_discard_old(base_vector::size_type newCapacity)
+	{
+		const base_vector::size_type currSize((base_vector::size_type)(m_end - m_begin));
+		if (m_begin)
+			rde::destruct_n(m_begin, currSize);
+		else if (!reserve())
+			internal::vm_out_of_memory("vm_vector: could not reserve address space");
+		if (newCapacity > base_vector::size_type(m_capacityEnd - m_begin) && !commit(newCapacity))
+			internal::vm_out_of_memory("vm_vector: could not commit memory");
+		m_end = m_begin + currSize;
+		RDE_ASSERT(invariant());
+	}
+	void destroy(T* ptr, base_vector::size_type n)
+	{
+		rde::destruct_n(ptr, n);
+		internal::vm_release(m_begin, TReserveBytes);
+		m_begin = m_end = m_capacityEnd = 0;
+		m_committedBytes = 0;
+	}
+	void reset()
+	{
+		if (m_begin)
+			internal::vm_release(m_begin, TReserveBytes);
+		m_begin = m_end = m_capacityEnd = 0;
+		m_committedBytes = 0;
+	}
+	bool invariant() const
+	{
+		return m_end >= m_begin;
+	}
+	RDE_FORCEINLINE void record_high_watermark()
+	{
+		// empty
+	}
+	base_vector::size_type get_high_watermark() const
+	{
+		return base_vector::size_type(m_capacityEnd - m_begin);
+	}
+
+	bool reserve()
+	{
+		m_begin = static_cast<T*>(internal::vm_reserve(TReserveBytes));
+		m_end = m_capacityEnd = m_begin;
+		return m_begin != 0;
+	}
+	// Commits enough pages for newCapacity elements, decommits the rest.
+	// @return false (and leaves capacity untouched) if newCapacity doesn't fit
+	// in reserved range or OS refuses to commit.
+	bool commit(base_vector::size_type newCapacity)
+	{
+		const size_t pageSize = internal::vm_page_size();
+		if (newCapacity > TReserveBytes / sizeof(T))
+			return false;
+		const size_t bytes = (newCapacity * sizeof(T) + pageSize - 1) & ~(pageSize - 1);
+		if (bytes > TReserveBytes)
+			return false;
+		char* base = reinterpret_cast<char*>(m_begin);
+		if (bytes > m_committedBytes)
+		{
+			if (!internal::vm_commit(base + m_committedBytes, bytes - m_committedBytes))
+				return false;
+		}
+		else if (bytes < m_committedBytes)
+		{
+			internal::vm_decommit(base + bytes, m_committedBytes - bytes);
+		}
+		m_committedBytes = bytes;
+		m_capacityEnd = m_begin + bytes / sizeof(T);
+		return true;
+	}
+
+	T*			m_begin;
+	T*			m_end;
+	T*			m_capacityEnd;
+	size_t		m_committedBytes;
+	TAllocator	m_allocator;
+};
+
+//=============================================================================
+// Vector that reserves address space up front and commits it page by page.
+// Growing never copies and pointers/iterators to elements stay valid
+// (as long as elements are not erased/inserted before them, obviously).
+// Shrinking (shrink_to_fit/set_capacity) gives pages back to the OS.
+// Allocator is not used, it's here only for interface compatibility.
+template<typename T,
+	size_t TReserveBytes = (sizeof(void*) == 8 ? size_t(1) << 36 : size_t(1) << 28),
+	class TAllocator = rde::allocator
+>
+class vm_vector: public vector<T, TAllocator, vm_vector_storage<T, TAllocator, TReserveBytes>, vm_vector_growth<TReserveBytes> >
+{
+	typedef vector<T, TAllocator, vm_vector_storage<T, TAllocator, TReserveBytes>, vm_vector_growth<TReserveBytes> >	base_vector;
+public:
+	typedef TAllocator								allocator_type;
+	typedef typename base_vector::size_type			size_type;
+	typedef T										value_type;
+
+	explicit vm_vector(const allocator_type& allocator = allocator_type())
+		: base_vector(allocator)
+	{
+		/**/
+	}
+	explicit vm_vector(size_type initialSize, const allocator_type& allocator = allocator_type())
+		: base_vector(initialSize, allocator)
+	{
+		/**/
+	}
+	vm_vector(const T* first, const T* last, const allocator_type& allocator = allocator_type())
+		: base_vector(first, last, allocator)
+	{
+		/**/
+	}
+	vm_vector(const vm_vector& rhs, const allocator_type& allocator = allocator_type())
+		: base_vector(rhs, allocator)
+	{
+		/**/
+	}
+	vm_vector(vm_vector&& rhs)
+		: base_vector(std::move(rhs))
+	{
+		/**/
+	}
+
+	vm_vector& operator=(const vm_vector& rhs)
+	{
+		if (&rhs != this)
+			base_vector::copy(rhs);
+		return *this;
+	}
+	vm_vector& operator=(vm_vector&& rhs)
+	{
+		base_vector::operator=(std::move(rhs));
+		return *this;
+	}
+
+	// Upper limit for capacity, given by reserved address range.
+	static size_type max_size()	{ return TReserveBytes / sizeof(T); }
+};
+
+} // namespace rde
+
+//-----------------------------------------------------------------------------
+#endif // #ifndef RDESTL_VM_VECTOR_H